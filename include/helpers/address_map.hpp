@@ -0,0 +1,40 @@
+#pragma once
+
+#include <hex.hpp>
+#include <hex/providers/provider.hpp>
+
+#include <helpers/image_info.hpp>
+
+#include <optional>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Translates virtual addresses reported by the dynamic analysis into addresses of the provider
+     * PE and ELF images are mapped through their section table. Anything else is assumed to be loaded as is,
+     * so virtual addresses are taken as provider addresses
+     */
+    class AddressMap {
+    public:
+        /**
+         * @brief Reads the section layout of the image in a provider
+         * @param provider Provider containing the image
+         * @return Address map of the image
+         */
+        static AddressMap fromProvider(hex::prv::Provider *provider);
+
+        /**
+         * @brief Maps a virtual address into the provider
+         * @param virtualAddress Virtual address of the loaded image
+         * @return Provider address or std::nullopt if the address isn't backed by any data in the provider
+         */
+        [[nodiscard]] std::optional<u64> toAddress(u64 virtualAddress) const;
+
+    private:
+        u64 m_baseAddress = 0x00;
+        u64 m_dataSize = 0x00;
+
+        ImageInfo m_image;
+    };
+
+}
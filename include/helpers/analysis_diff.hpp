@@ -0,0 +1,77 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/malcore_api.hpp>
+#include <helpers/string_pool.hpp>
+
+#include <array>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Differences between the results of two analyses
+     * Signatures and strings are compared as sets. API traces are aligned call by call with a linear space Myers diff
+     * over tokens of each call's name and argument shape, so calls that only differ in their argument values still line up
+     */
+    class AnalysisDiff {
+    public:
+        struct SetDiff {
+            std::vector<std::string> removed, added;
+            size_t common = 0;
+        };
+
+        enum class RowType : u8 {
+            Equal,
+            Changed,
+            Replaced,
+            Removed,
+            Inserted
+        };
+
+        constexpr static u32 NoCall = 0xFFFF'FFFF;
+
+        /**
+         * @brief One row of the aligned traces
+         * Removed rows only have a left call and inserted rows only a right one, all others have both
+         */
+        struct Row {
+            RowType type;
+            u32 left, right;
+        };
+
+        struct TraceDiff {
+            std::vector<Row> rows;
+            std::array<u32, 5> counts = { };
+
+            [[nodiscard]] u32 getCount(RowType type) const {
+                return this->counts[u8(type)];
+            }
+        };
+
+        /**
+         * @brief Compares two sets of strings
+         * @return Strings only on the left, strings only on the right and the number of strings on both sides
+         */
+        static SetDiff compareSets(std::vector<std::string> left, std::vector<std::string> right);
+
+        /**
+         * @brief Aligns the API calls of two traces
+         * @param left Trace of the left analysis
+         * @param leftStrings String pool of the left analysis
+         * @param right Trace of the right analysis
+         * @param rightStrings String pool of the right analysis
+         * @param stopToken Token that aborts the diff when a stop is requested
+         * @return Aligned rows or std::nullopt if the diff got cancelled
+         */
+        static std::optional<TraceDiff> compareTraces(const MalcoreApi::DynamicAnalysisResult &left, const StringPool &leftStrings, const MalcoreApi::DynamicAnalysisResult &right, const StringPool &rightStrings, std::stop_token stopToken);
+
+    private:
+        AnalysisDiff() = default;
+    };
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <chrono>
+#include <string_view>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Time spent in each phase of an analysis together with transfer and result size counters
+     * Phases that didn't run for an analysis simply stay at zero
+     */
+    struct AnalysisMetrics {
+        enum class Phase : u8 {
+            Hash,
+            CacheLookup,
+            HashLookup,
+            Compression,
+            Upload,
+            Poll,
+            Queue,
+            Parse,
+            LocateStrings,
+            Annotate,
+
+            Count
+        };
+
+        using Duration = std::chrono::duration<double>;
+
+        /**
+         * @brief Adds the time between its construction and destruction to a phase
+         */
+        class ScopedTimer {
+        public:
+            ScopedTimer(AnalysisMetrics &metrics, Phase phase)
+                : m_metrics(metrics), m_phase(phase), m_startTime(std::chrono::steady_clock::now()) { }
+
+            ~ScopedTimer() {
+                this->m_metrics.add(this->m_phase, std::chrono::steady_clock::now() - this->m_startTime);
+            }
+
+            ScopedTimer(const ScopedTimer &) = delete;
+            ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        private:
+            AnalysisMetrics &m_metrics;
+            Phase m_phase;
+            std::chrono::steady_clock::time_point m_startTime;
+        };
+
+        std::array<Duration, size_t(Phase::Count)> durations = { };
+
+        // Time until the summary of a result could be shown, before its strings were located and its traces were scanned
+        Duration timeToFirstResult = { };
+
+        u64 sampleSize = 0;
+        u64 bytesSent = 0;
+        u64 bytesReceived = 0;
+        u32 pollCount = 0;
+
+        u64 statusSize = 0;
+        u64 signatureCount = 0;
+        u64 apiCallCount = 0;
+        u64 pooledStringCount = 0;
+        u64 storedTraceSize = 0;
+        u64 stringMatchCount = 0;
+        u64 annotationCount = 0;
+
+        void add(Phase phase, Duration duration) {
+            this->durations[size_t(phase)] += duration;
+        }
+
+        [[nodiscard]] Duration get(Phase phase) const {
+            return this->durations[size_t(phase)];
+        }
+
+        [[nodiscard]] ScopedTimer measure(Phase phase) {
+            return { *this, phase };
+        }
+
+        [[nodiscard]] Duration getTotal() const {
+            Duration total = { };
+            for (const auto &duration : this->durations)
+                total += duration;
+
+            return total;
+        }
+
+        /**
+         * @brief Machine readable name of a phase, used as its JSON key and to build its localization key
+         */
+        static std::string_view getPhaseName(Phase phase);
+
+        [[nodiscard]] nlohmann::json toJson() const;
+    };
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <helpers/analysis_metrics.hpp>
+#include <helpers/request_scheduler.hpp>
+#include <helpers/sample_source.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <stop_token>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Runs the full analysis pipeline for a single sample
+     * Hashes the sample, answers from the result cache or an existing report of the service if possible and otherwise
+     * uploads it and polls its status until it's done. Concurrent runs for the same content share a single upload and poll stream
+     */
+    class AnalysisRunner {
+    public:
+        enum class Error {
+            None,
+            Cancelled,
+            UploadFailed,
+            StatusFailed,
+            TimedOut
+        };
+
+        enum class Origin {
+            Cache,
+            Lookup,
+            Upload
+        };
+
+        struct Result {
+            // Digest keys everything local, the SHA-256 is what the service knows the sample by
+            SampleSource::Hash digest = { };
+            SampleSource::Hash hash = { };
+            std::optional<std::string> status;
+            Error error = Error::None;
+
+            Origin origin = Origin::Upload;
+            bool shared = false;
+
+            std::optional<double> compressionRatio;
+            std::chrono::duration<double> uploadTimeSaved = { };
+            std::chrono::duration<double> duration = { };
+
+            AnalysisMetrics metrics;
+
+            [[nodiscard]] std::optional<double> getUploadBandwidth() const {
+                const auto uploadDuration = this->metrics.get(AnalysisMetrics::Phase::Upload);
+                if (this->metrics.bytesSent == 0 || uploadDuration.count() <= 0)
+                    return std::nullopt;
+
+                return double(this->metrics.bytesSent) / uploadDuration.count();
+            }
+        };
+
+        /**
+         * @brief Analyzes a sample on the calling thread
+         * @param sample Sample to analyze
+         * @param stopToken Token that aborts the upload or polling when a stop is requested
+         * @param priority Priority all requests of the analysis are scheduled with
+         * @return Raw status response of the finished analysis or the reason why there is none
+         */
+        static Result run(const SampleSource &sample, std::stop_token stopToken, RequestScheduler::Priority priority = RequestScheduler::Priority::Interactive);
+
+        static void setDebugLogging(bool enabled) {
+            s_debugLogging = enabled;
+        }
+
+    private:
+        AnalysisRunner() = default;
+
+        /**
+         * @brief Remote analysis of one content digest, shared by everybody who asked for it while it's running
+         * It's only stopped once the last participant lost interest
+         */
+        struct Flight {
+            std::mutex mutex;
+            std::condition_variable_any finished;
+            std::optional<Result> result;
+
+            u32 participants = 0;
+            std::stop_source stopSource;
+        };
+
+        static Result analyze(const SampleSource &sample, const SampleSource::Hash &digest, RequestScheduler::Priority priority, std::stop_token stopToken);
+        static void leave(Flight &flight);
+
+        static inline std::atomic<bool> s_debugLogging = false;
+
+        static inline std::mutex s_flightsMutex;
+        static inline std::map<SampleSource::Hash, std::shared_ptr<Flight>> s_flights;
+    };
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Sorted interval index of annotations on a provider
+     * All annotated regions are flattened into non-overlapping segments once, so finding the annotations of a
+     * single address is one binary search no matter how many annotations there are
+     */
+    class AnnotationIndex {
+    public:
+        struct Annotation {
+            hex::Region region;
+            color_t color;
+            std::string label;
+        };
+
+        /**
+         * @brief Adds an annotation. Only takes effect once build() got called
+         */
+        void add(hex::Region region, color_t color, std::string label);
+
+        /**
+         * @brief Builds the segment table from all annotations added so far
+         */
+        void build();
+
+        /**
+         * @brief Finds all annotations that cover an address
+         * @param address Address to look up
+         * @return Ids of the covering annotations in the order they were added
+         */
+        [[nodiscard]] std::span<const u32> find(u64 address) const;
+
+        /**
+         * @brief Finds the highlight color of an address
+         * @param address Address to look up
+         * @return Color of the first annotation covering the address or std::nullopt if there is none
+         */
+        [[nodiscard]] std::optional<color_t> getColor(u64 address) const;
+
+        [[nodiscard]] const Annotation &get(u32 id) const {
+            return this->m_annotations[id];
+        }
+
+        [[nodiscard]] size_t size() const {
+            return this->m_annotations.size();
+        }
+
+    private:
+        [[nodiscard]] std::optional<size_t> findSegment(u64 address) const;
+
+    private:
+        std::vector<Annotation> m_annotations;
+
+        std::vector<u64> m_segmentStarts, m_segmentEnds;
+        std::vector<u32> m_segmentOffsets;
+        std::vector<u32> m_segmentAnnotations;
+    };
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/malcore_api.hpp>
+
+#include <helpers/string_pool.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Search index over the API calls of a single dynamic analysis trace
+     * Keeps a posting list of calls per interned API name and additionally keeps all calls in PC order,
+     * so filtering large traces doesn't need to rescan every call's strings
+     */
+    class ApiTraceIndex {
+    public:
+        enum class SortColumn {
+            Index,
+            Pc,
+            Name
+        };
+
+        struct Filter {
+            std::string name;
+            std::optional<u64> pcStart, pcEnd;
+            std::string argument;
+
+            [[nodiscard]] bool empty() const {
+                return this->name.empty() && !this->pcStart.has_value() && !this->pcEnd.has_value() && this->argument.empty();
+            }
+        };
+
+        ApiTraceIndex() = default;
+        ApiTraceIndex(const MalcoreApi::DynamicAnalysisResult &trace, const StringPool &strings);
+
+        /**
+         * @brief Finds all calls matching a filter
+         * @param trace Trace the index was built from
+         * @param strings String pool of the trace
+         * @param filter Filter to apply. Name and argument filters are case-insensitive substring matches, the PC range is inclusive
+         * @param column Column to sort the result by
+         * @param ascending Sort direction
+         * @return Indices of all matching calls
+         */
+        [[nodiscard]] std::vector<u32> query(const MalcoreApi::DynamicAnalysisResult &trace, const StringPool &strings, const Filter &filter, SortColumn column, bool ascending) const;
+
+    private:
+        std::vector<StringPool::Id> m_names;
+        std::vector<u32> m_nameRanks;
+        std::vector<u32> m_nameIds;
+        std::vector<std::vector<u32>> m_postings;
+
+        std::vector<u32> m_pcOrder;
+        std::vector<u64> m_sortedPcs;
+    };
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/sample_source.hpp>
+
+#include <wolv/literals.hpp>
+
+#include <stop_token>
+#include <vector>
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    /**
+     * @brief SHA-256 hash tree over fixed size chunks of a sample
+     * Chunks are hashed on all cores the first time the tree is used. Afterwards only chunks that were invalidated and
+     * their ancestors get rehashed, so the root of a large sample is up to date again right after a small edit
+     */
+    class HashTree {
+    public:
+        using Hash = SampleSource::Hash;
+
+        constexpr static u64 ChunkSize = 64_KiB;
+
+        /**
+         * @brief Marks a range of the data as changed
+         * @param offset Offset of the changed range from the start of the sample
+         * @param size Size of the changed range, clamped to the end of the data
+         */
+        void invalidate(u64 offset, u64 size);
+
+        /**
+         * @brief Changes the number of bytes covered by the tree
+         * The chunk that contained the old end and everything after it is marked as changed
+         */
+        void resize(u64 size);
+
+        /**
+         * @brief Rehashes all changed chunks and their ancestors
+         * @param sample Sample to read changed chunks from
+         * @param stopToken Token that aborts hashing when a stop is requested
+         * @return False if hashing got cancelled, in which case all changes stay pending
+         */
+        bool update(const SampleSource &sample, std::stop_token stopToken);
+
+        /**
+         * @brief Root of the tree, which also covers the size of the data
+         * Only valid after an update without any changes in between
+         */
+        [[nodiscard]] const Hash &getRoot() const {
+            return this->m_root;
+        }
+
+        [[nodiscard]] u64 getSize() const {
+            return this->m_size;
+        }
+
+        [[nodiscard]] bool isDirty() const {
+            return this->m_rebuild || !this->m_dirtyChunks.empty();
+        }
+
+    private:
+        void rebuildLevels();
+        void propagate(std::vector<u64> indices);
+        void updateRoot();
+
+    private:
+        u64 m_size = 0;
+
+        // Level 0 holds the chunk hashes, every following level holds the hashes of pairs of nodes of the level below
+        std::vector<std::vector<Hash>> m_levels = { { } };
+
+        std::vector<bool> m_dirty;
+        std::vector<u64> m_dirtyChunks;
+        bool m_rebuild = true;
+
+        Hash m_root = { };
+    };
+
+}
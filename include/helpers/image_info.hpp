@@ -0,0 +1,62 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/sample_source.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Header facts of a PE or ELF image
+     * Only little endian images are understood. Anything else is reported as an unknown format
+     */
+    struct ImageInfo {
+        enum class Format {
+            Unknown,
+            PE,
+            ELF
+        };
+
+        struct Section {
+            std::string name;
+            u64 virtualAddress = 0x00;
+            u64 virtualSize = 0x00;
+            u64 fileOffset = 0x00;
+            u64 fileSize = 0x00;
+        };
+
+        Format format = Format::Unknown;
+        std::string machine;
+        std::string type;
+        bool is64Bit = false;
+
+        u64 imageBase = 0x00;
+        u64 entryPoint = 0x00;
+        std::optional<u32> timestamp;
+
+        std::vector<Section> sections;
+
+        /**
+         * @brief Reads the headers of the image in a sample
+         * @param sample Sample containing the image
+         * @return Header facts. The format is Format::Unknown if the sample isn't a PE or ELF image
+         */
+        static ImageInfo parse(const SampleSource &sample);
+
+        /**
+         * @brief Maps a virtual address of the loaded image back to its offset in the file
+         * @param virtualAddress Virtual address
+         * @return File offset or std::nullopt if the address isn't backed by data in the file
+         */
+        [[nodiscard]] std::optional<u64> toFileOffset(u64 virtualAddress) const;
+
+        [[nodiscard]] std::optional<u64> getEntryPointOffset() const {
+            return this->toFileOffset(this->entryPoint);
+        }
+    };
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <curl/curl.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Single thread that drives all Malcore transfers through one curl multi handle
+     * Transfers are multiplexed on the executor's event loop instead of each blocking a thread of their own, and they all
+     * draw from the multi handle's connection cache, so connections and TLS sessions are reused no matter which analysis
+     * sends a request. Only a limited number of transfers is active at once, the rest wait in a queue without any of their
+     * timeouts running
+     */
+    class IoExecutor {
+    public:
+        constexpr static u32 MaxTransfers = 32;
+
+        /**
+         * @brief Called on the executor thread once a transfer has finished, failed or was aborted
+         */
+        using Completion = std::function<void(CURLcode code)>;
+
+        /**
+         * @brief Hands out a curl handle to configure a transfer on
+         * @return Handle that's either freshly created or was reset after its last transfer, nullptr if creating one failed
+         */
+        static CURL *acquireHandle();
+
+        /**
+         * @brief Returns a handle once its transfer is complete and its results have been read
+         */
+        static void releaseHandle(CURL *handle);
+
+        /**
+         * @brief Queues a configured handle to be transferred
+         * @param handle Handle to transfer. Its callbacks are called on the executor thread and must never block
+         * @param completion Function that's called once the transfer is over
+         * @return Id of the transfer
+         */
+        static u64 start(CURL *handle, Completion completion);
+
+        /**
+         * @brief Continues a transfer that paused itself because its read callback had no data ready yet
+         */
+        static void resume(u64 id);
+
+        /**
+         * @brief Aborts a transfer that's queued or in flight. Its completion is called with CURLE_ABORTED_BY_CALLBACK
+         */
+        static void abort(u64 id);
+
+    private:
+        struct Transfer {
+            CURL *handle;
+            Completion completion;
+        };
+
+        IoExecutor();
+        ~IoExecutor();
+
+        static IoExecutor &get();
+
+        void run(std::stop_token stopToken);
+        void processCommands();
+        void finish(u64 id, CURLcode code);
+
+    private:
+        CURLM *m_multi;
+
+        std::mutex m_mutex;
+        u64 m_nextId = 1;
+        std::deque<std::pair<u64, Transfer>> m_queued;
+        std::vector<u64> m_resumed, m_aborted;
+        std::vector<CURL*> m_idleHandles;
+
+        // Only ever touched by the executor thread
+        std::map<u64, Transfer> m_active;
+
+        std::jthread m_thread;
+    };
+
+}
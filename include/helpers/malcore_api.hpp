@@ -1,16 +1,36 @@
 #pragma once
 
 #include <hex/providers/provider.hpp>
-#include <hex/helpers/http_requests.hpp>
+#include <hex/helpers/logger.hpp>
+
+#include <helpers/malcore_request.hpp>
+#include <helpers/request_scheduler.hpp>
+#include <helpers/sample_source.hpp>
+#include <helpers/string_pool.hpp>
+#include <helpers/upload_compressor.hpp>
+
+#include <nlohmann/json.hpp>
 
 #include <wolv/literals.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+
 namespace mal::hlp {
 
     using namespace wolv::literals;
 
     class MalcoreApi {
     public:
+        constexpr static auto DefaultBaseUrl = "https://api.malcore.io/api";
+
         struct PackerInformation {
             std::string name;
             u32 confidence = 0;
@@ -18,7 +38,7 @@ namespace mal::hlp {
 
         struct Signature {
             std::string title, description;
-            nlohmann::json discovered;
+            std::string discovered;
         };
 
         struct ThreatScore {
@@ -26,184 +46,418 @@ namespace mal::hlp {
             std::vector<Signature> signatures;
         };
 
+        struct Argument {
+            StringPool::Id value = StringPool::Empty;
+            bool isNumber = false;
+        };
+
         struct Api {
-            std::string apiName;
+            StringPool::Id apiName = StringPool::Empty;
             u64 pcValue = 0x00;
 
-            std::vector<std::string> arguments;
-            std::string returnValue;
+            u32 firstArgument = 0;
+            u32 argumentCount = 0;
+            StringPool::Id returnValue = StringPool::Empty;
         };
 
+        /*
+         * Calls and their arguments are stored in two flat arrays. Every string in them is an id into the
+         * string pool of the analysis result they belong to, since the same names and arguments repeat all over a trace
+         */
         struct DynamicAnalysisResult {
             std::string hash;
             std::vector<Api> apis;
+            std::vector<Argument> arguments;
+
+            [[nodiscard]] std::span<const Argument> getArguments(const Api &api) const {
+                return std::span(this->arguments).subspan(api.firstArgument, api.argumentCount);
+            }
         };
 
-        static auto uploadProviderData(hex::prv::Provider *provider, hex::Region region) {
-            std::vector<u8> data;
-            data.resize(std::min<size_t>(region.getSize(), s_uploadLimit));
-            provider->read(region.getStartAddress(), data.data(), data.size());
+        struct AnalysisResult {
+            std::optional<ThreatScore> threatScore;
+            std::optional<PackerInformation> packerInformation;
+            std::optional<std::vector<std::string>> interestingStrings;
+            std::optional<std::vector<DynamicAnalysisResult>> dynamicAnalysisResults;
 
-            return std::async(std::launch::async, [data = std::move(data)]() mutable -> std::optional<std::string> {
-                auto request = createRequest("POST", "/upload");
-                auto response = request.uploadFile<std::string>(data, "filename1").get();
+            StringPool strings;
+        };
 
-                if (!response.isSuccess()) {
-                    hex::log::error("Failed to upload file to malcore: {}", response.getStatusCode());
-                    return std::nullopt;
-                }
+        struct Upload {
+            std::optional<std::string> uuid;
+            u64 bytesSent = 0;
+            std::chrono::duration<double> duration = { };
+            std::chrono::duration<double> compressionDuration = { };
 
-                try {
-                    auto json = nlohmann::json::parse(response.getData());
+            std::optional<double> compressionRatio;
+            std::chrono::duration<double> timeSaved = { };
+        };
 
-                    return json["data"]["data"]["uuid"].get<std::string>();
-                } catch (std::exception &e) {
-                    hex::log::error("Failed to get UUID: {}", e.what());
-                    return std::nullopt;
-                }
-            });
-        }
+        /**
+         * @brief Optional features of the Malcore instance the client talks to
+         */
+        struct Capabilities {
+            bool hashLookup = false;
+            bool gzipUploads = false;
+            bool pagedStatus = false;
+        };
 
-        static auto getAnalysisStatus(const std::string &uuid) {
-            return std::async(std::launch::async, [uuid]() -> std::optional<nlohmann::json> {
-                auto request = createRequest("POST", "/status");
-                request.setBody("uuid=" + uuid);
-                auto response = request.execute<std::string>().get();
+        using Priority = RequestScheduler::Priority;
+
+        /**
+         * @brief Uploads the start of a sample to start a new analysis
+         * The transfer runs on the IoExecutor while the calling thread waits for it and prepares the upload body
+         * @param sample Sample to upload, up to the upload limit
+         * @param stopToken Token that aborts the upload
+         * @param priority Priority the request is scheduled with
+         * @return UUID of the new analysis, if any, and statistics of the transfer
+         */
+        static Upload uploadSample(const SampleSource &sample, std::stop_token stopToken = { }, Priority priority = Priority::Interactive) {
+            const auto size = std::min<u64>(sample.getSize(), s_uploadLimit);
+
+            // Only services that announced they accept gzip encoded uploads get one, all others would analyze the gzip container
+            if (s_compressUploads && getCapabilities(priority, stopToken).gzipUploads) {
+                auto compressor = std::make_shared<UploadCompressor>(sample, size, stopToken);
+
+                auto request = createRequest("/upload");
+                request->setSource("filename1", "data.bin", [compressor](u64 offset, u8 *buffer, size_t size) {
+                    return compressor->read(offset, buffer, size);
+                });
+                request->addField("encoding", "gzip");
+
+                auto upload = sendUpload(*request, priority, stopToken);
+
+                // Services that advertise gzip but still reject it get the raw data instead
+                if (upload.statusCode != 400 && upload.statusCode != 415) {
+                    auto result = parseUpload(upload);
+
+                    if (compressor->isComplete()) {
+                        // Compression runs while the upload is sent, so its time is already part of the upload duration.
+                        // Estimate how long the raw payload would have taken at the bandwidth that was just measured
+                        const auto rawDuration = upload.duration * compressor->getRatio();
+                        result.compressionDuration = compressor->getDuration();
+                        result.compressionRatio    = compressor->getRatio();
+                        result.timeSaved           = rawDuration - upload.duration;
+                    }
 
-                if (!response.isSuccess())
-                    return std::nullopt;
+                    if (result.uuid.has_value() && result.compressionRatio.has_value()) {
+                        hex::log::info("Compressed upload from {} to {} bytes ({:.2f}x), saving about {:.2f}s",
+                            compressor->getRawSize(), compressor->getCompressedSize(), compressor->getRatio(), result.timeSaved.count());
+                    }
 
-                try {
-                    return nlohmann::json::parse(response.getData());
-                } catch (std::exception &e) {
-                    return std::nullopt;
+                    return result;
                 }
-            });
-        }
-
-        static bool isAnalysisFinished(const nlohmann::json &analysis) {
-            return analysis["messages"][0]["type"].get<std::string>() == "success";
-        }
 
-        static std::optional<PackerInformation> getPackerInformation(const nlohmann::json &analysis) {
-            try {
-                auto &packerInformation = analysis["data"]["packer_information"][0];
+                hex::log::warn("Malcore rejected the compressed upload with status {}, sending it uncompressed", upload.statusCode);
 
-                PackerInformation result;
-                result.name = packerInformation["packer_name"].get<std::string>();
+                if (stopToken.stop_requested())
+                    return { };
+            }
 
-                auto confidenceString = packerInformation["percent"].get<std::string>();
-                result.confidence = std::strtoul(confidenceString.c_str(), nullptr, 10);
+            // Stream the data straight out of the sample instead of copying the whole region into memory first
+            auto request = createRequest("/upload");
+            request->setSource("filename1", "data.bin", size, sample.getReader());
 
-                return result;
-            } catch (nlohmann::json::exception &) {
-                return std::nullopt;
-            }
+            return parseUpload(sendUpload(*request, priority, stopToken));
         }
 
-        static std::optional<std::vector<std::string>> getInterestingStrings(const nlohmann::json &analysis) {
-            try {
-                auto &strings = analysis["data"]["interesting_strings"]["results"];
+        static Upload uploadProviderData(hex::prv::Provider *provider, hex::Region region) {
+            return uploadSample(SampleSource::fromProvider(provider, region));
+        }
 
-                std::vector<std::string> result;
-                for (auto &string : strings)
-                    result.push_back(string.get<std::string>());
+        static std::array<u8, 32> hashProviderData(hex::prv::Provider *provider, hex::Region region) {
+            return SampleSource::fromProvider(provider, region).calculateHash(s_uploadLimit);
+        }
 
-                return result;
-            } catch (nlohmann::json::exception &) {
+        /**
+         * @brief Asks the service for an existing report of a sample without uploading it
+         * @param hash Hex encoded SHA-256 of the sample
+         * @param priority Priority the request is scheduled with
+         * @param stopToken Token that aborts waiting for the request to be sent
+         * @return Raw status response or std::nullopt if the service doesn't know the sample
+         */
+        static std::optional<std::string> lookupHash(const std::string &hash, Priority priority = Priority::Interactive, std::stop_token stopToken = { }) {
+            auto request = createRequest("/lookup");
+            request->setBody("hash=" + hash);
+            auto response = RequestScheduler::execute(*request, priority, stopToken);
+
+            if (!response.isSuccess())
                 return std::nullopt;
-            }
+
+            return std::move(response.data);
         }
 
-        static std::optional<ThreatScore> getThreatScore(const nlohmann::json &analysis) {
-            try {
-                const auto &threatScore = analysis["data"]["threat_score"]["results"];
-
-                ThreatScore result;
-                result.score = std::strtof(threatScore["score"].get<std::string>().c_str(), nullptr);
-
-                for (auto &signature : threatScore["signatures"]) {
-                    const auto &info = signature["info"];
-                    result.signatures.push_back({
-                        info["title"].get<std::string>(),
-                        info["description"].get<std::string>(),
-                        signature["discovered"]
-                    });
+        /**
+         * @brief Asks the service which optional features it supports
+         * Answers are cached per base URL. Services that don't know about the endpoint support none of the features,
+         * services that can't be reached at all are asked again the next time
+         * @param priority Priority the request is scheduled with
+         * @param stopToken Token that aborts waiting for the request to be sent
+         * @return Features the service supports
+         */
+        static Capabilities getCapabilities(Priority priority = Priority::Interactive, std::stop_token stopToken = { }) {
+            const auto baseUrl = getBaseUrl();
+
+            while (true) {
+                // Only the first caller asks the service, everybody arriving while it does waits for its answer
+                std::shared_ptr<CapabilitiesQuery> query;
+                bool asking = false;
+                {
+                    std::scoped_lock lock(s_capabilitiesMutex);
+
+                    auto &entry = s_capabilities[baseUrl];
+                    if (entry == nullptr) {
+                        entry = std::make_shared<CapabilitiesQuery>();
+                        asking = true;
+                    }
+
+                    query = entry;
                 }
 
-                return result;
-            } catch (nlohmann::json::exception &e) {
-                hex::log::error("Failed to get threat score: {}", e.what());
-                return std::nullopt;
-            }
-        }
+                if (asking) {
+                    auto capabilities = queryCapabilities(priority, stopToken);
 
-        static std::optional<std::vector<DynamicAnalysisResult>> getDynamicAnalysisResult(const nlohmann::json &analysis) {
-            try {
-                auto &dynamicAnalysisList = analysis["data"]["dynamic_analysis"]["dynamic_analysis"];
+                    // Unanswered queries are forgotten, so the service is asked again the next time
+                    if (!capabilities.has_value()) {
+                        std::scoped_lock lock(s_capabilitiesMutex);
+                        if (auto it = s_capabilities.find(baseUrl); it != s_capabilities.end() && it->second == query)
+                            s_capabilities.erase(it);
+                    }
 
-                std::vector<DynamicAnalysisResult> results;
+                    {
+                        std::scoped_lock lock(query->mutex);
+                        query->capabilities = capabilities;
+                        query->cancelled    = !capabilities.has_value() && stopToken.stop_requested();
+                        query->done         = true;
+                    }
+                    query->answered.notify_all();
 
-                for (const auto &dynamicAnalysis : dynamicAnalysisList) {
-                    for (const auto &entryPoint : dynamicAnalysis["entry_points"]) {
-                        DynamicAnalysisResult result;
+                    return capabilities.value_or(Capabilities { });
+                }
 
-                        result.hash = entryPoint["apihash"].get<std::string>();
-                        for (const auto &api : entryPoint["apis"]) {
-                            Api apiResult;
-                            apiResult.apiName = api["api_name"].get<std::string>();
-                            apiResult.pcValue = std::strtoull(api["pc"].get<std::string>().c_str(), nullptr, 16);
+                std::unique_lock lock(query->mutex);
+                if (!query->answered.wait(lock, stopToken, [&query] { return query->done; }))
+                    return { };
 
-                            for (const auto &argument : api["args"])
-                                apiResult.arguments.push_back(argument.get<std::string>());
+                // Somebody else's cancellation doesn't leave the ones still waiting without an answer
+                if (query->cancelled)
+                    continue;
 
-                            if (api["ret_val"].is_string())
-                                apiResult.returnValue = api["ret_val"].get<std::string>();
+                return query->capabilities.value_or(Capabilities { });
+            }
+        }
 
-                            result.apis.emplace_back(std::move(apiResult));
-                        }
+        /**
+         * @brief Fetches the current status of an analysis
+         * Services that support paged status requests only send a summary with an index of the traces, which are then
+         * fetched page by page through getStatusPage once they're looked at
+         * @param uuid UUID the upload of the sample returned
+         * @param priority Priority the request is scheduled with
+         * @param stopToken Token that aborts waiting for the request to be sent
+         * @return Raw status response or std::nullopt if the request failed
+         */
+        static std::optional<std::string> getAnalysisStatus(const std::string &uuid, Priority priority = Priority::Interactive, std::stop_token stopToken = { }) {
+            auto request = createRequest("/status");
+            request->setBody("uuid=" + uuid + (getCapabilities(priority, stopToken).pagedStatus ? "&section=summary" : ""));
+            auto response = RequestScheduler::execute(*request, priority, stopToken);
+
+            if (!response.isSuccess())
+                return std::nullopt;
 
-                        results.emplace_back(std::move(result));
-                    }
-                }
+            // Responses are only kept as raw text here, StatusParser only reads as much of them as it needs
+            return std::move(response.data);
+        }
 
-                return results;
-            } catch (nlohmann::json::exception &e) {
-                hex::log::error("Failed to get dynamic analysis result: {}", e.what());
+        /**
+         * @brief Fetches a single page of traces of a finished analysis from a service that supports paged status requests
+         * @param uuid UUID named by the page index of the summary
+         * @param page Index of the page
+         * @param priority Priority the request is scheduled with
+         * @param stopToken Token that aborts waiting for the request to be sent
+         * @return Raw status response holding only the traces of the page or std::nullopt if the request failed
+         */
+        static std::optional<std::string> getStatusPage(const std::string &uuid, u32 page, Priority priority = Priority::Interactive, std::stop_token stopToken = { }) {
+            auto request = createRequest("/status");
+            request->setBody("uuid=" + uuid + "&page=" + std::to_string(page));
+            auto response = RequestScheduler::execute(*request, priority, stopToken);
+
+            if (!response.isSuccess())
                 return std::nullopt;
-            }
-        }
 
+            return std::move(response.data);
+        }
 
         static void setApiKey(std::string apiKey) {
-            s_apiKey = std::move(apiKey);
+            updateConfig([&](Config &config) { config.apiKey = std::move(apiKey); });
         }
 
         static bool hasApiKey() {
-            return !s_apiKey.empty();
+            return !getConfig()->apiKey.empty();
         }
 
         static void setUploadLimit(size_t limit) {
             s_uploadLimit = limit;
         }
 
+        static u64 getUploadLimit() {
+            return s_uploadLimit;
+        }
+
+        /**
+         * @brief Points the client to a different Malcore instance
+         * @param baseUrl URL all endpoints are relative to, without a trailing slash. Empty resets it to the default
+         */
+        static void setBaseUrl(std::string baseUrl) {
+            while (baseUrl.ends_with('/'))
+                baseUrl.pop_back();
+
+            updateConfig([&](Config &config) { config.baseUrl = baseUrl.empty() ? DefaultBaseUrl : std::move(baseUrl); });
+        }
+
+        static std::string getBaseUrl() {
+            return getConfig()->baseUrl;
+        }
+
+        /**
+         * @brief Enables gzip encoding uploads
+         * Only used with services that announce they accept gzip encoded uploads, all others still get the raw sample
+         */
+        static void setCompressUploads(bool compressUploads) {
+            s_compressUploads = compressUploads;
+        }
+
+        /**
+         * @brief Enables asking for existing reports by hash before uploading a sample
+         * Every lookup costs a request, so it's only worth it with services that already know many of the analyzed samples
+         */
+        static void setHashLookup(bool hashLookup) {
+            s_hashLookup = hashLookup;
+        }
+
+        /**
+         * @brief Checks if samples should be looked up by their hash before uploading them
+         * @return True if lookups are enabled and the service supports them
+         */
+        static bool shouldLookupHashes(Priority priority = Priority::Interactive, std::stop_token stopToken = { }) {
+            return s_hashLookup && getCapabilities(priority, stopToken).hashLookup;
+        }
+
     private:
-        static hex::HttpRequest createRequest(const std::string &method, const std::string &endpoint) {
-            hex::HttpRequest request(method, ApiUrl + endpoint);
-            request.addHeader("apiKey", MalcoreApi::s_apiKey);
-            request.addHeader("X-No-Poll", "true");
+        /**
+         * @brief Connection settings, changed from the UI thread while workers are building requests
+         * Every change publishes a new immutable snapshot so a request never sees a half written string
+         */
+        struct Config {
+            std::string baseUrl = DefaultBaseUrl;
+            std::string apiKey;
+        };
+
+        static std::shared_ptr<const Config> getConfig() {
+            std::scoped_lock lock(s_configMutex);
+
+            return s_config;
+        }
+
+        static void updateConfig(const auto &update) {
+            std::scoped_lock lock(s_configMutex);
+
+            auto config = std::make_shared<Config>(*s_config);
+            update(*config);
+            s_config = std::move(config);
+        }
+
+        static MalcoreRequest::Result sendUpload(MalcoreRequest &request, Priority priority, std::stop_token stopToken) {
+            std::stop_callback cancelUpload(stopToken, [&request] { request.cancel(); });
+
+            // Every upload that gets through starts a new analysis
+            request.setIdempotent(false);
+
+            return RequestScheduler::execute(request, priority, stopToken);
+        }
+
+        static Upload parseUpload(const MalcoreRequest::Result &response) {
+            Upload result;
+            result.bytesSent = response.bytesSent;
+            result.duration  = response.duration;
+
+            if (!response.isSuccess()) {
+                hex::log::error("Failed to upload file to malcore: {}", response.statusCode);
+                return result;
+            }
+
+            try {
+                auto json = nlohmann::json::parse(response.data);
+
+                result.uuid = json["data"]["data"]["uuid"].get<std::string>();
+            } catch (std::exception &e) {
+                hex::log::error("Failed to get UUID: {}", e.what());
+            }
+
+            return result;
+        }
+
+        static std::unique_ptr<MalcoreRequest> createRequest(const std::string &endpoint) {
+            const auto config = getConfig();
+
+            auto request = std::make_unique<MalcoreRequest>(config->baseUrl + endpoint);
+            request->addHeader("apiKey", config->apiKey);
+            request->addHeader("X-No-Poll", "true");
 
             return request;
         }
 
+        /**
+         * @brief Sends the capabilities request
+         * @return Features the service supports, std::nullopt if it couldn't be reached
+         */
+        static std::optional<Capabilities> queryCapabilities(Priority priority, std::stop_token stopToken) {
+            auto request = createRequest("/capabilities");
+            auto response = RequestScheduler::execute(*request, priority, stopToken);
+            if (response.statusCode == 0)
+                return std::nullopt;
+
+            Capabilities capabilities;
+            if (response.isSuccess()) {
+                try {
+                    const auto json = nlohmann::json::parse(response.data).at("data").at("capabilities");
+
+                    capabilities.hashLookup  = json.value("hash_lookup", false);
+                    capabilities.pagedStatus = json.value("paged_status", false);
+                    for (const auto &encoding : json.value("upload_encodings", nlohmann::json::array()))
+                        capabilities.gzipUploads |= encoding == "gzip";
+                } catch (std::exception &e) {
+                    hex::log::warn("Failed to parse Malcore capabilities: {}", e.what());
+                }
+            }
+
+            return capabilities;
+        }
+
     private:
+        /**
+         * @brief Capabilities request of one base URL, answered once for everybody who asked while it was sent
+         */
+        struct CapabilitiesQuery {
+            std::mutex mutex;
+            std::condition_variable_any answered;
+            std::optional<Capabilities> capabilities;
+
+            bool done = false;
+            bool cancelled = false;
+        };
+
         MalcoreApi() = default;
         ~MalcoreApi() = default;
 
-        const static inline std::string ApiUrl = "https://api.malcore.io/api";
+        static inline std::mutex s_configMutex;
+        static inline std::shared_ptr<const Config> s_config = std::make_shared<const Config>();
+
+        static inline std::atomic<u64> s_uploadLimit = 20_MiB;
+        static inline std::atomic<bool> s_compressUploads = false;
+        static inline std::atomic<bool> s_hashLookup = false;
 
-        static inline std::string s_apiKey;
-        static inline u64 s_uploadLimit = 20_MiB;
+        static inline std::mutex s_capabilitiesMutex;
+        static inline std::map<std::string, std::shared_ptr<CapabilitiesQuery>> s_capabilities;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <wolv/literals.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    /**
+     * @brief HTTP POST request to the Malcore API
+     * Request bodies can either be sent as a plain string or as a multipart file part that's pulled from a reader callback
+     * while it's being sent, so uploads never hold more than a couple of transfer blocks of the payload in memory.
+     * The transfer itself runs on the IoExecutor together with all other requests. The thread that sends a request only
+     * waits for it to complete, and produces the blocks of a streamed body in the meantime so reading and compressing the
+     * payload never stalls the executor's event loop
+     */
+    class MalcoreRequest {
+    public:
+        /**
+         * @brief Callback used to fill the next block of a streamed request body
+         * @param offset Offset of the block relative to the start of the payload
+         * @param buffer Buffer to write the data into
+         * @param size Number of bytes requested
+         */
+        using Reader = std::function<void(u64 offset, u8 *buffer, size_t size)>;
+
+        /**
+         * @brief Callback used to produce the next block of a streamed request body whose size isn't known up front
+         * @param offset Offset of the block relative to the start of the payload. Goes back to 0 if the body is sent again
+         * @param buffer Buffer to write the data into
+         * @param size Maximum number of bytes to write
+         * @return Number of bytes written, 0 once the payload is complete or std::nullopt to abort the request
+         */
+        using Stream = std::function<std::optional<size_t>(u64 offset, u8 *buffer, size_t size)>;
+
+        struct Result {
+            long statusCode = 0;
+            std::string data;
+
+            // Time the server asked to wait before trying again, if it sent a Retry-After header
+            std::optional<std::chrono::seconds> retryAfter;
+
+            // Set if the request failed before a connection was established, so none of it reached the server
+            bool connectFailed = false;
+
+            u64 bytesSent = 0;
+            std::chrono::duration<double> duration = { };
+
+            [[nodiscard]] bool isSuccess() const {
+                return this->statusCode == 200;
+            }
+        };
+
+        constexpr static size_t BlockSize = 256_KiB;
+
+        // Number of blocks of a streamed body that are prepared ahead of the transfer
+        constexpr static size_t BlocksAhead = 2;
+
+        constexpr static auto ConnectTimeout = std::chrono::seconds(10);
+
+        // Transfers that stay below this rate for that long are aborted instead of hanging on a dead connection forever
+        constexpr static u64 StallSpeed = 1_KiB;
+        constexpr static auto StallTime = std::chrono::seconds(60);
+
+        explicit MalcoreRequest(std::string url);
+
+        MalcoreRequest(const MalcoreRequest &) = delete;
+        MalcoreRequest(MalcoreRequest &&) = delete;
+        MalcoreRequest &operator=(const MalcoreRequest &) = delete;
+        MalcoreRequest &operator=(MalcoreRequest &&) = delete;
+
+        void addHeader(std::string key, std::string value) {
+            this->m_headers[std::move(key)] = std::move(value);
+        }
+
+        void setBody(std::string body) {
+            this->m_body = std::move(body);
+        }
+
+        /**
+         * @brief Sends the request body as a streamed multipart file part instead of the plain body
+         * @param mimeName Name of the multipart field
+         * @param fileName File name reported to the server
+         * @param size Total size of the payload
+         * @param reader Callback that's queried for each block of the payload
+         */
+        void setSource(std::string mimeName, std::string fileName, u64 size, Reader reader);
+
+        /**
+         * @brief Sends the request body as a multipart file part that's produced while it's being sent
+         * The size isn't known up front, so the body is sent with chunked transfer encoding
+         * @param mimeName Name of the multipart field
+         * @param fileName File name reported to the server
+         * @param stream Callback that's queried for each block of the payload
+         */
+        void setSource(std::string mimeName, std::string fileName, Stream stream);
+
+        void setSourceType(std::string mimeType) {
+            this->m_mimeType = std::move(mimeType);
+        }
+
+        /**
+         * @brief Adds a plain form field that's sent in front of the file part
+         * @param name Name of the multipart field
+         * @param value Value of the field
+         */
+        void addField(std::string name, std::string value) {
+            this->m_fields.emplace_back(std::move(name), std::move(value));
+        }
+
+        /**
+         * @brief Marks whether sending the request twice has the same effect as sending it once
+         * Requests that aren't idempotent are only retried if the server can't have acted on them yet
+         */
+        void setIdempotent(bool idempotent) {
+            this->m_idempotent = idempotent;
+        }
+
+        [[nodiscard]] bool isIdempotent() const {
+            return this->m_idempotent;
+        }
+
+        /**
+         * @brief Sends the request through the IoExecutor and waits for it to complete
+         * @return Status code, response body and transfer statistics
+         */
+        Result execute();
+
+        void cancel() {
+            {
+                std::scoped_lock lock(this->m_transferMutex);
+                this->m_cancelled = true;
+            }
+
+            this->m_transferCondVar.notify_all();
+        }
+
+        /**
+         * @brief Sets the proxy all requests are sent through
+         * @param url Proxy URL or an empty string to connect directly
+         */
+        static void setProxy(std::string url) {
+            std::scoped_lock lock(s_settingsMutex);
+            s_proxyUrl = std::move(url);
+        }
+
+        /**
+         * @brief Sets the CA certificates TLS connections are verified against
+         * @param certificates PEM encoded certificate bundle or an empty string to use the ones curl was built with
+         */
+        static void setCaCertificates(std::string certificates) {
+            std::scoped_lock lock(s_settingsMutex);
+            s_caCertificates = std::make_shared<const std::string>(std::move(certificates));
+        }
+
+    private:
+        /**
+         * @brief Waits for a transfer that's been started on the IoExecutor, while producing the blocks of its body
+         */
+        void waitForTransfer(u64 id);
+
+    private:
+        std::string m_url;
+        std::map<std::string, std::string> m_headers;
+        std::string m_body;
+
+        std::string m_mimeName, m_fileName, m_mimeType;
+        std::vector<std::pair<std::string, std::string>> m_fields;
+        std::optional<u64> m_size;
+        Stream m_stream;
+
+        bool m_idempotent = true;
+        std::atomic<bool> m_cancelled = false;
+
+        // State of the transfer in flight, shared between the executor thread and the thread waiting for the request
+        std::mutex m_transferMutex;
+        std::condition_variable m_transferCondVar;
+        std::deque<std::vector<u8>> m_blocks;
+        size_t m_blockOffset = 0;
+        u64 m_produceOffset = 0, m_sendOffset = 0, m_rewinds = 0;
+        bool m_bodyComplete = false, m_bodyFailed = false, m_waitingForBody = false, m_finished = false;
+        int m_code = 0;
+
+        static inline std::mutex s_settingsMutex;
+        static inline std::string s_proxyUrl;
+        static inline std::shared_ptr<const std::string> s_caCertificates;
+    };
+
+}
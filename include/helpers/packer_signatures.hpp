@@ -0,0 +1,85 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/image_info.hpp>
+#include <helpers/malcore_api.hpp>
+#include <helpers/pattern_matcher.hpp>
+#include <helpers/sample_source.hpp>
+
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Local packer detection based on a signature file
+     * Every packer is described by a set of rules, each with its own confidence:
+     *  - entry_point: Byte pattern that has to be found right at the entry point of the image
+     *  - section:     Name of a section the packer adds to the image
+     *  - anywhere:    Byte pattern that may appear anywhere in the sample
+     * Patterns are hex bytes separated by spaces where ?? matches any byte. All anywhere rules are searched for
+     * in a single pass over the sample
+     */
+    class PackerSignatures {
+    public:
+        /**
+         * @brief Replaces the loaded signatures
+         * Invalid rules are logged and skipped
+         * @param json Content of the signature file
+         */
+        static void load(std::string_view json);
+
+        /**
+         * @brief Matches all loaded signatures against a sample
+         * @param sample Sample to scan
+         * @param image Header facts of the sample
+         * @param stopToken Token that aborts the scan when a stop is requested
+         * @return Detected packers with the confidence of their best matching rule, most confident first
+         */
+        static std::vector<MalcoreApi::PackerInformation> scan(const SampleSource &sample, const ImageInfo &image, std::stop_token stopToken);
+
+    private:
+        PackerSignatures() = default;
+
+        struct Pattern {
+            std::vector<u8> bytes;
+            std::vector<u8> mask;
+
+            static std::optional<Pattern> parse(std::string_view string);
+            [[nodiscard]] bool matches(std::span<const u8> data) const;
+        };
+
+        struct EntryPointRule {
+            u32 packer;
+            Pattern pattern;
+            u32 confidence;
+        };
+
+        struct SectionRule {
+            u32 packer;
+            std::string name;
+            u32 confidence;
+        };
+
+        struct AnywhereRule {
+            u32 packer;
+            Pattern pattern;
+            u32 anchorOffset;
+            u32 confidence;
+        };
+
+        constexpr static size_t MinAnchorSize = 4;
+        constexpr static size_t MaxAnchorMatches = 64;
+
+        static inline std::vector<std::string> s_packers;
+        static inline std::vector<EntryPointRule> s_entryPointRules;
+        static inline std::vector<SectionRule> s_sectionRules;
+        static inline std::vector<AnywhereRule> s_anywhereRules;
+        static inline PatternMatcher s_anchorMatcher;
+    };
+
+}
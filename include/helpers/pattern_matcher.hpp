@@ -0,0 +1,88 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/sample_source.hpp>
+
+#include <wolv/literals.hpp>
+
+#include <array>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    /**
+     * @brief Finds all occurrences of a set of byte patterns in a sample
+     * All patterns are compiled into a single Aho-Corasick automaton, so the sample is only read once no matter how
+     * many patterns are searched. The sample is split into chunks that are scanned in parallel. States get a full row of
+     * transitions, one per byte class, shallowest first until the table would outgrow MaxTableSize. Deeper states of large
+     * pattern sets only keep the trie's edges and follow failure links on mismatches, which always end in a full row
+     */
+    class PatternMatcher {
+    public:
+        constexpr static size_t ChunkSize = 4_MiB;
+        constexpr static size_t MaxTableSize = 16_MiB;
+
+        PatternMatcher() = default;
+        explicit PatternMatcher(const std::vector<std::vector<u8>> &patterns);
+
+        /**
+         * @brief Scans a sample for all patterns
+         * @param sample Sample to scan
+         * @param stopToken Token that aborts the scan when a stop is requested
+         * @param maxMatches Maximum number of matches that are reported per pattern
+         * @return Start offsets of the matches of every pattern sorted in ascending order, in the same order as the patterns
+         *         passed to the constructor
+         */
+        [[nodiscard]] std::vector<std::vector<u64>> locate(const SampleSource &sample, std::stop_token stopToken, size_t maxMatches) const;
+
+        [[nodiscard]] size_t getPatternCount() const {
+            return this->m_patternSizes.size();
+        }
+
+    private:
+        constexpr static u32 None = 0xFFFF'FFFF;
+
+        /**
+         * @brief Trie of the patterns while it's being built
+         * Children are kept as sibling lists, so building it doesn't depend on the number of byte classes
+         */
+        struct Trie {
+            std::vector<u32> firstChild, nextSibling, byteClass;
+
+            [[nodiscard]] u32 findChild(u32 state, u32 byteClass) const;
+        };
+
+        void addPattern(Trie &trie, std::span<const u8> bytes, u32 id);
+        void build(const Trie &trie);
+
+        [[nodiscard]] u32 findEdge(u32 state, u32 byteClass) const;
+        [[nodiscard]] u32 step(u32 state, u32 byteClass) const;
+
+        void scan(std::span<const u8> data, u64 baseOffset, u64 endOffset, size_t maxMatches, std::vector<std::vector<u64>> &matches) const;
+
+    private:
+        std::array<u16, 256> m_byteClasses = { };
+        u32 m_classCount = 1;
+
+        // States are numbered breadth first, the ones below m_denseStateCount have a full row of transitions
+        std::vector<u32> m_transitions;
+        u32 m_denseStateCount = 0;
+
+        // Edges of the trie grouped by state and sorted by byte class, and the failure link of every state
+        std::vector<u32> m_edgeOffsets, m_edgeClasses, m_edgeTargets;
+        std::vector<u32> m_failures;
+
+        std::vector<u32> m_outputs;
+        std::vector<u32> m_outputLinks;
+
+        std::vector<u32> m_patternSizes;
+        std::vector<u32> m_nextPatterns;
+        size_t m_maxPatternSize = 0;
+    };
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <random>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Computes the delays between status polls of a running analysis
+     * Starts out with a short interval so fast analyses are picked up quickly and then backs off exponentially
+     * with some jitter up to a configurable ceiling, until the overall timeout is reached
+     */
+    class PollScheduler {
+    public:
+        using Duration = std::chrono::milliseconds;
+
+        constexpr static Duration InitialInterval = std::chrono::milliseconds(250);
+        constexpr static double BackoffFactor = 1.5;
+        constexpr static double Jitter = 0.2;
+
+        PollScheduler() : m_startTime(Clock::now()), m_interval(InitialInterval), m_random(std::random_device()()) { }
+
+        /**
+         * @brief Advances the schedule by one poll
+         * @return Delay until the next poll should happen or std::nullopt if the analysis timed out
+         */
+        [[nodiscard]] std::optional<Duration> next() {
+            this->m_pollCount += 1;
+
+            const auto timeout = s_timeout.load();
+            const auto elapsed = this->getElapsedTime();
+            if (elapsed >= timeout)
+                return std::nullopt;
+
+            std::uniform_real_distribution<double> jitter(1.0 - Jitter, 1.0 + Jitter);
+            auto delay = Duration(Duration::rep(this->m_interval.count() * jitter(this->m_random)));
+
+            // Never sleep past the timeout, there's one last poll right when it expires
+            delay = std::clamp<Duration>(delay, Duration(0), std::chrono::duration_cast<Duration>(timeout - elapsed));
+
+            this->m_interval = std::min<Duration>(Duration(Duration::rep(this->m_interval.count() * BackoffFactor)), s_maxInterval.load());
+
+            return delay;
+        }
+
+        [[nodiscard]] std::chrono::duration<double> getElapsedTime() const {
+            return Clock::now() - this->m_startTime;
+        }
+
+        [[nodiscard]] u32 getPollCount() const {
+            return this->m_pollCount;
+        }
+
+        static void setMaxInterval(Duration maxInterval) {
+            s_maxInterval = std::max(maxInterval, InitialInterval);
+        }
+
+        static void setTimeout(std::chrono::seconds timeout) {
+            s_timeout = timeout;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        Clock::time_point m_startTime;
+        Duration m_interval;
+        u32 m_pollCount = 0;
+
+        std::mt19937 m_random;
+
+        // Changed from the UI thread while analyses are polling
+        static inline std::atomic<Duration> s_maxInterval = std::chrono::duration_cast<Duration>(std::chrono::seconds(10));
+        static inline std::atomic<std::chrono::seconds> s_timeout = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::minutes(15));
+    };
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <hex.hpp>
+#include <hex/providers/provider.hpp>
+
+#include <helpers/hash_tree.hpp>
+#include <helpers/sample_source.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Hash trees of all providers that were analyzed, kept up to date with the edits made to them
+     * Edits only mark the affected chunks, the rehashing happens the next time a digest is requested
+     */
+    class ProviderHashes {
+    public:
+        /**
+         * @brief Starts tracking edits made to providers
+         */
+        static void init();
+
+        /**
+         * @brief Creates a sample of a whole provider whose digest is answered from the provider's hash tree
+         */
+        static SampleSource createSample(hex::prv::Provider *provider);
+
+        /**
+         * @brief Brings the hash tree of a provider up to date, building it on first use
+         * @param provider Provider to hash
+         * @param limit Maximum number of bytes that will be uploaded
+         * @param stopToken Token that aborts hashing, the chunks that weren't rehashed yet stay marked
+         * @return Digest of the first min(size, limit) bytes of the provider or std::nullopt if hashing got cancelled
+         */
+        static std::optional<SampleSource::Hash> getDigest(hex::prv::Provider *provider, u64 limit, std::stop_token stopToken = { });
+
+    private:
+        ProviderHashes() = default;
+
+        struct Entry {
+            std::mutex treeMutex;
+            HashTree tree;
+
+            // Edits are only queued here so they never have to wait for a rehash that's currently running
+            std::mutex pendingMutex;
+            std::vector<hex::Region> pending;
+        };
+
+        static void invalidate(hex::prv::Provider *provider, u64 address, u64 size);
+
+    private:
+        static inline std::mutex s_entriesMutex;
+        static inline std::map<hex::prv::Provider*, std::shared_ptr<Entry>> s_entries;
+    };
+
+}
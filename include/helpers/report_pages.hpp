@@ -0,0 +1,216 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/api_trace_index.hpp>
+#include <helpers/malcore_api.hpp>
+#include <helpers/result_archive.hpp>
+#include <helpers/string_pool.hpp>
+
+#include <wolv/literals.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    /**
+     * @brief Dynamic analysis traces of a status response, split into pages that are only decoded when they're looked at
+     * Splitting a response only scans its structure, it doesn't decode anything. Everything but the traces ends up in a small
+     * summary that's parsed right away, the traces are cut into pages of whole entry points that are kept compressed.
+     * Decoded pages are kept in a small LRU, so expanding the same traces again doesn't decode them a second time.
+     * Project files store the compressed pages as they are, so restored traces get decoded one page at a time as well.
+     * Services that support paged status requests only send a summary with an index of the traces. Their pages start out
+     * empty and are fetched from the service the first time they're decoded, local splitting is only used for full responses
+     */
+    class ReportPages {
+    public:
+        using TraceHeader = ResultArchive::TraceHeader;
+
+        constexpr static u32 MaxTracesPerPage = 16;
+        constexpr static size_t MaxPageSize = 4_MiB;
+        constexpr static u32 MaxCachedPages = 8;
+
+        struct Page {
+            std::vector<MalcoreApi::DynamicAnalysisResult> traces;
+            StringPool strings;
+
+            // Only built for pages that are shown, filtering and sorting them is the only thing that needs them
+            std::vector<ApiTraceIndex> indices;
+        };
+
+        /**
+         * @brief Compressed entry points of a page, exactly as they're kept in memory
+         * Pages that weren't fetched from the service yet have no data
+         */
+        struct StoredPage {
+            u32 firstTrace = 0;
+            u64 rawSize = 0;
+            std::vector<u8> data;
+        };
+
+        /**
+         * @brief Places in the sample APIs got called from, merged over all stored pages
+         * They're collected while the pages are built, so annotating the traces doesn't need to decode any of them.
+         * Loops call the same API from the same place over and over again, so every PC is only kept once
+         */
+        struct CallSites {
+            struct Site {
+                u64 pc = 0;
+                u32 name = 0;
+                u32 count = 0;
+            };
+
+            std::vector<std::string> names;
+            std::vector<Site> sites;
+        };
+
+        /**
+         * @brief Splits a status response into its summary and pages of traces
+         * @param status Raw status response, either a full one or the summary of a paged one
+         * @return Pages or std::nullopt if the response isn't structurally valid JSON
+         */
+        static std::optional<ReportPages> split(std::string_view status);
+
+        /**
+         * @brief Extracts the summary of a status response without keeping its traces around
+         * @param status Raw status response
+         * @param traceHeaders Receives the headers of all traces if given
+         * @return Status response without the dynamic analysis section or std::nullopt if it isn't structurally valid JSON
+         */
+        static std::optional<std::string> extractSummary(std::string_view status, std::vector<TraceHeader> *traceHeaders = nullptr);
+
+        /**
+         * @brief Restores pages that were stored before, without decompressing any of them
+         * @param traceHeaders Headers of all traces on the pages
+         * @param pages Stored pages, ordered by their first trace
+         * @param callSites Call sites of all pages that have data
+         * @param remoteUuid UUID pages without data are fetched with, empty if all of them are stored
+         * @return Pages or std::nullopt if they don't fit the trace headers
+         */
+        static std::optional<ReportPages> fromStoredPages(std::vector<TraceHeader> traceHeaders, std::vector<StoredPage> pages, CallSites callSites, std::string remoteUuid = { });
+
+        ReportPages(const ReportPages &other) = delete;
+        ReportPages(ReportPages &&other) noexcept;
+        ReportPages &operator=(const ReportPages &other) = delete;
+        ReportPages &operator=(ReportPages &&other) = delete;
+
+        /**
+         * @brief Status response without the dynamic analysis section, parseable by StatusParser
+         */
+        [[nodiscard]] const std::string &getSummary() const {
+            return this->m_summary;
+        }
+
+        [[nodiscard]] bool hasTraces() const {
+            return this->m_hasTraces;
+        }
+
+        [[nodiscard]] const std::vector<TraceHeader> &getTraceHeaders() const {
+            return this->m_traceHeaders;
+        }
+
+        [[nodiscard]] u32 getPageCount() const {
+            return this->m_pages.size();
+        }
+
+        /**
+         * @brief UUID of the analysis the pages are fetched with, empty if they were all split locally
+         */
+        [[nodiscard]] const std::string &getRemoteUuid() const {
+            return this->m_remoteUuid;
+        }
+
+        [[nodiscard]] std::vector<StoredPage> getStoredPages() const;
+
+        /**
+         * @brief Checks if a page can be decoded without fetching it from the service first
+         */
+        [[nodiscard]] bool isPageStored(u32 page) const;
+
+        [[nodiscard]] u32 getPageOf(u32 trace) const;
+
+        [[nodiscard]] u32 getFirstTrace(u32 page) const {
+            return this->m_pages[page].firstTrace;
+        }
+
+        /**
+         * @brief Returns the call sites of all pages that are stored, without decoding any of them
+         * @param pageCount Receives the number of pages the call sites were collected from if given
+         * @return Call sites in the order they were first called from
+         */
+        [[nodiscard]] CallSites getCallSites(u32 *pageCount = nullptr) const;
+
+        [[nodiscard]] u64 getRawSize() const;
+        [[nodiscard]] u64 getStoredSize() const;
+        [[nodiscard]] u32 getCachedPageCount() const;
+
+        /**
+         * @brief Looks up a decoded page without decoding it
+         * @param page Index of the page
+         * @return Page or nullptr if it isn't decoded right now
+         */
+        [[nodiscard]] std::shared_ptr<const Page> findPage(u32 page) const;
+
+        /**
+         * @brief Returns a decoded page with the indices of its traces, decoding it first if needed
+         * @param page Index of the page
+         * @return Page or nullptr if it couldn't be decoded
+         */
+        std::shared_ptr<const Page> loadPage(u32 page) const;
+
+        /**
+         * @brief Decodes a page without adding it to the decoded pages, for passes that only walk its traces
+         * Pages that aren't stored yet are fetched from the service first, which blocks until the request is done
+         * @param page Index of the page
+         * @param buildIndices Whether to build the indices of the traces as well
+         * @return Page or std::nullopt if it couldn't be decoded
+         */
+        [[nodiscard]] std::optional<Page> decodePage(u32 page, bool buildIndices = false) const;
+
+        /**
+         * @brief Marks a page as being decoded by somebody
+         * @param page Index of the page
+         * @return Whether the caller should decode the page, false if it's decoded already or somebody else does it
+         */
+        bool beginLoading(u32 page) const;
+
+    private:
+        ReportPages() = default;
+
+        struct CachedPage {
+            u32 page;
+            std::shared_ptr<const Page> data;
+            std::chrono::steady_clock::time_point lastUse;
+        };
+
+        void insert(u32 page, std::shared_ptr<const Page> data) const;
+        bool fetchPage(u32 page) const;
+        [[nodiscard]] u32 getTraceCount(u32 page) const;
+
+    private:
+        std::string m_summary;
+        bool m_hasTraces = false;
+
+        std::vector<TraceHeader> m_traceHeaders;
+        std::string m_remoteUuid;
+
+        // Pages only change once, when a page without data gets fetched. Once a page has data it stays as it is
+        mutable std::mutex m_pagesMutex;
+        mutable std::vector<StoredPage> m_pages;
+        mutable CallSites m_callSites;
+
+        mutable std::mutex m_cacheMutex;
+        mutable std::vector<CachedPage> m_cache;
+        mutable std::set<u32> m_loading;
+    };
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/malcore_request.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Process wide gate all Malcore API requests pass through
+     * A token bucket limits the request rate of everything that shares the API key. Waiting requests are granted tokens
+     * by priority, so interactive analyses don't queue up behind batch jobs. Transient failures are retried with
+     * exponential backoff, and a throttled request pauses all requests until the server says it's fine to try again
+     */
+    class RequestScheduler {
+    public:
+        enum class Priority : u8 {
+            Interactive,
+            Batch,
+
+            Count
+        };
+
+        struct Counters {
+            u64 queued = 0;
+            u64 retried = 0;
+            u64 throttled = 0;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        constexpr static u32 MaxAttempts = 5;
+        constexpr static auto InitialBackoff = std::chrono::seconds(1);
+        constexpr static auto MaxBackoff = std::chrono::minutes(1);
+        constexpr static auto MaxRetryAfter = std::chrono::minutes(5);
+
+        /**
+         * @brief Sends a request through the IoExecutor once a token is available and waits for it, retrying it while it fails transiently
+         * @param request Request to send. It's sent again as a whole for every retry, unless it isn't idempotent and may already have reached the server
+         * @param priority Priority of the request
+         * @param stopToken Token that aborts waiting and retrying when a stop is requested
+         * @return Result of the last attempt
+         */
+        static MalcoreRequest::Result execute(MalcoreRequest &request, Priority priority, std::stop_token stopToken);
+
+        /**
+         * @brief Configures the token bucket
+         * @param requestsPerMinute Number of requests allowed per minute on average, 0 disables the limit
+         * @param burst Number of requests that may be sent back to back after being idle
+         */
+        static void setRateLimit(u32 requestsPerMinute, u32 burst = DefaultBurst);
+
+        static Counters getCounters();
+
+    private:
+        RequestScheduler() = default;
+
+        static bool acquire(Priority priority, std::stop_token stopToken);
+        static void refill(Clock::time_point now);
+
+        static bool isRetryable(const MalcoreRequest &request, const MalcoreRequest::Result &result);
+        static Clock::duration getBackoff(u32 attempt, const MalcoreRequest::Result &result);
+
+    private:
+        constexpr static u32 DefaultBurst = 10;
+
+        static inline std::mutex s_mutex;
+        static inline std::condition_variable_any s_tokenAvailable;
+
+        static inline double s_rate = 1.0;
+        static inline double s_burst = DefaultBurst;
+        static inline double s_tokens = DefaultBurst;
+        static inline Clock::time_point s_lastRefill = Clock::now();
+        static inline Clock::time_point s_pausedUntil = { };
+
+        static inline std::array<u32, size_t(Priority::Count)> s_waiting = { };
+        static inline u64 s_generation = 0;
+
+        static inline std::atomic<u64> s_retried = 0, s_throttled = 0;
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/malcore_api.hpp>
+#include <helpers/string_locator.hpp>
+
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace mal::hlp {
+
+    class ReportPages;
+
+    /**
+     * @brief Compact binary encoding of analysis results for storage in project files
+     * Results are split into a small summary and the dynamic analysis traces. The summary holds everything that's shown
+     * right away and the headers of all traces, the traces themselves are a separate blob of the same compressed pages
+     * ReportPages keeps in memory. They're written and restored as they are and only decoded page by page once they're looked at.
+     * Pages that weren't fetched from a paging service yet are stored without data, along with the UUID they're fetched with.
+     * The call sites of the stored pages are written along with them, so restored traces are annotated without decoding them
+     */
+    class ResultArchive {
+    public:
+        constexpr static u32 SummaryMagic = 0x5253'4C4D; // "MLSR"
+        constexpr static u32 TracesMagic  = 0x5254'4C4D; // "MLTR"
+        constexpr static u16 SummaryVersion = 1;
+        constexpr static u16 TracesVersion  = 4;
+
+        struct TraceHeader {
+            std::string hash;
+            u32 apiCount = 0;
+        };
+
+        struct Summary {
+            MalcoreApi::AnalysisResult result;
+            std::vector<std::vector<StringLocator::Match>> stringMatches;
+            std::vector<TraceHeader> traces;
+        };
+
+        /**
+         * @brief Encodes everything but the dynamic analysis traces of a result
+         * @param result Analysis result
+         * @param stringMatches Matches of the interesting strings, relative to the start of the sample
+         * @param traces Headers of the traces that are stored alongside
+         * @return Encoded summary
+         */
+        static std::vector<u8> encodeSummary(const MalcoreApi::AnalysisResult &result, std::span<const std::vector<StringLocator::Match>> stringMatches, std::span<const TraceHeader> traces);
+        static std::optional<Summary> decodeSummary(std::span<const u8> data);
+
+        /**
+         * @brief Encodes the compressed trace pages of a result without decompressing any of them
+         * @param pages Trace pages
+         * @return Encoded traces
+         */
+        static std::vector<u8> encodeTraces(const ReportPages &pages);
+
+        /**
+         * @brief Restores trace pages without decompressing any of them
+         * @param data Encoded traces
+         * @param traces Headers of the traces, as stored in the summary
+         * @return Trace pages or std::nullopt if the data is invalid or doesn't fit the headers
+         */
+        static std::optional<ReportPages> decodeTraces(std::span<const u8> data, std::vector<TraceHeader> traces);
+
+    private:
+        ResultArchive() = default;
+    };
+
+}
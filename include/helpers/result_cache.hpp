@@ -0,0 +1,84 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <wolv/io/fs.hpp>
+#include <wolv/literals.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    /**
+     * @brief On-disk cache of raw Malcore status responses
+     * Entries are keyed by the digest of the uploaded data and the upload limit that was used to produce it,
+     * so re-opening a sample that was already analyzed doesn't need any network traffic nor hashing the whole sample again
+     */
+    class ResultCache {
+    public:
+        using Hash = std::array<u8, 32>;
+
+        struct Entry {
+            Hash hash = { };
+            std::string status;
+        };
+
+        /**
+         * @brief Looks up a cached status response
+         * @param digest Digest of the uploaded data
+         * @param uploadLimit Upload limit that was in effect when the data was hashed
+         * @return SHA-256 of the uploaded data and its cached status response or std::nullopt if there's no valid entry or a refresh is forced
+         */
+        static std::optional<Entry> get(const Hash &digest, u64 uploadLimit);
+
+        /**
+         * @brief Stores a finished status response and evicts old entries if the cache grew too large
+         * @param digest Digest of the uploaded data
+         * @param uploadLimit Upload limit that was in effect when the data was hashed
+         * @param hash SHA-256 of the uploaded data
+         * @param status Raw status response
+         */
+        static void store(const Hash &digest, u64 uploadLimit, const Hash &hash, std::string_view status);
+
+        static void clear();
+
+        static void setForceRefresh(bool forceRefresh) {
+            s_forceRefresh = forceRefresh;
+        }
+
+        static void setMaxSize(u64 maxSize) {
+            s_maxSize = maxSize;
+        }
+
+        static void setMaxAge(std::chrono::seconds maxAge) {
+            s_maxAge = maxAge;
+        }
+
+    private:
+        ResultCache() = default;
+
+        static std::optional<std::fs::path> getCacheFolder();
+        static std::string getEntryName(const Hash &digest, u64 uploadLimit);
+        static bool isExpired(const std::fs::path &path);
+        static void evict(const std::fs::path &folder);
+
+    private:
+        constexpr static size_t HashLength = 64;
+        constexpr static auto EntryExtension = ".cache";
+
+        static inline std::mutex s_mutex;
+
+        static inline std::atomic<bool> s_forceRefresh = false;
+        static inline std::atomic<u64> s_maxSize = 256_MiB;
+        static inline std::atomic<std::chrono::seconds> s_maxAge = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::days(7));
+    };
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <hex.hpp>
+#include <hex/providers/provider.hpp>
+
+#include <wolv/io/fs.hpp>
+
+#include <array>
+#include <functional>
+#include <optional>
+#include <stop_token>
+#include <string>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Data that can be submitted for analysis, backed either by an ImHex provider or by a file on disk
+     */
+    class SampleSource {
+    public:
+        using Hash = std::array<u8, 32>;
+        using Reader = std::function<void(u64 offset, u8 *buffer, size_t size)>;
+        using Digester = std::function<std::optional<Hash>(u64 limit, std::stop_token stopToken)>;
+        using Hasher = std::function<std::optional<Hash>(u64 limit)>;
+
+        static SampleSource fromProvider(hex::prv::Provider *provider, hex::Region region);
+        static SampleSource fromProvider(hex::prv::Provider *provider);
+        static std::optional<SampleSource> fromFile(const std::fs::path &path);
+        static SampleSource fromReader(std::string name, u64 size, Reader reader);
+
+        [[nodiscard]] const std::string &getName() const {
+            return this->m_name;
+        }
+
+        [[nodiscard]] u64 getSize() const {
+            return this->m_size;
+        }
+
+        [[nodiscard]] const Reader &getReader() const {
+            return this->m_reader;
+        }
+
+        void read(u64 offset, u8 *buffer, size_t size) const {
+            this->m_reader(offset, buffer, size);
+        }
+
+        /**
+         * @brief Calculates the SHA-256 of the data that would be uploaded
+         * @param limit Maximum number of bytes that will be uploaded
+         * @return SHA-256 of the first min(size, limit) bytes
+         */
+        [[nodiscard]] Hash calculateHash(u64 limit) const;
+
+        /**
+         * @brief Calculates the root of a hash tree over the data that would be uploaded
+         * Used to key everything that's local, since unlike the SHA-256 it can be kept up to date cheaply while the data is edited
+         * @param limit Maximum number of bytes that will be uploaded
+         * @param stopToken Token that aborts hashing
+         * @return Digest of the first min(size, limit) bytes or std::nullopt if hashing got cancelled
+         */
+        [[nodiscard]] std::optional<Hash> calculateDigest(u64 limit, std::stop_token stopToken = { }) const;
+
+        /**
+         * @brief Answers digests from an existing hash tree instead of building a new one every time
+         */
+        void setDigester(Digester digester) {
+            this->m_digester = std::move(digester);
+        }
+
+        /**
+         * @brief Answers the SHA-256 from a hash that's calculated somewhere else anyway
+         * The hasher returns std::nullopt if it can't answer for the given limit, the hash is calculated from the data then
+         */
+        void setHasher(Hasher hasher) {
+            this->m_hasher = std::move(hasher);
+        }
+
+    private:
+        SampleSource(std::string name, u64 size, Reader reader)
+            : m_name(std::move(name)), m_size(size), m_reader(std::move(reader)) { }
+
+        std::string m_name;
+        u64 m_size = 0;
+        Reader m_reader;
+        Digester m_digester;
+        Hasher m_hasher;
+    };
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <helpers/malcore_api.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Event driven parser for Malcore status responses
+     * Builds all sections of an analysis result in a single pass over the response text without ever materializing
+     * a JSON document. Everything outside of the known sections is skipped as it streams by
+     */
+    class StatusParser : public nlohmann::json_sax<nlohmann::json> {
+    public:
+        /**
+         * @brief Parses a finished status response
+         * @param status Raw status response
+         * @return Parsed analysis result or std::nullopt if the response isn't valid JSON
+         */
+        static std::optional<MalcoreApi::AnalysisResult> parse(std::string_view status);
+
+        /**
+         * @brief Checks whether a status response reports a finished analysis
+         * Stops reading the response as soon as the message type was found, so polls that are still in progress
+         * don't pay for parsing the rest of the document
+         * @param status Raw status response
+         * @return Whether the analysis is finished or std::nullopt if the response isn't valid JSON
+         */
+        static std::optional<bool> isFinished(std::string_view status);
+
+        bool null() override;
+        bool boolean(bool value) override;
+        bool number_integer(number_integer_t value) override;
+        bool number_unsigned(number_unsigned_t value) override;
+        bool number_float(number_float_t value, const string_t &string) override;
+        bool string(string_t &value) override;
+        bool binary(binary_t &value) override;
+
+        bool start_object(std::size_t elements) override;
+        bool key(string_t &value) override;
+        bool end_object() override;
+
+        bool start_array(std::size_t elements) override;
+        bool end_array() override;
+
+        bool parse_error(std::size_t position, const std::string &token, const nlohmann::detail::exception &exception) override;
+
+    private:
+        /**
+         * @brief Location inside of the response. Each open object or array gets one of these pushed onto the stack
+         */
+        enum class Node {
+            Skip,
+            Root,
+            Messages,
+            FirstMessage,
+            Data,
+            ThreatScore,
+            ThreatScoreResults,
+            Signatures,
+            Signature,
+            SignatureInfo,
+            Discovered,
+            PackerList,
+            Packer,
+            InterestingStrings,
+            InterestingStringList,
+            DynamicAnalysis,
+            DynamicAnalysisList,
+            DynamicAnalysisEntry,
+            EntryPoints,
+            EntryPoint,
+            Apis,
+            Api,
+            Arguments
+        };
+
+        struct Frame {
+            Node node;
+            bool isArray;
+            u32 elements = 0;
+        };
+
+        explicit StatusParser(bool statusOnly) : m_statusOnly(statusOnly) { }
+
+        Node enter(bool isArray);
+        bool value(string_t &string);
+        bool scalar(std::string_view text);
+        void advance();
+
+        [[nodiscard]] bool isCapturing() const;
+        void capture(std::string_view text);
+
+    private:
+        bool m_statusOnly;
+
+        std::vector<Frame> m_stack;
+        std::string m_key;
+
+        MalcoreApi::AnalysisResult m_result;
+        std::optional<std::string> m_messageType;
+
+        std::string *m_discovered = nullptr;
+    };
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/pattern_matcher.hpp>
+#include <helpers/sample_source.hpp>
+
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Finds all occurrences of a set of strings in a sample
+     * Every string is searched for in both its ASCII and UTF-16LE form. All of them are handed to a single PatternMatcher,
+     * so the sample is only read once no matter how many strings are searched
+     */
+    class StringLocator {
+    public:
+        enum class Encoding : u8 {
+            ASCII,
+            UTF16LE
+        };
+
+        struct Match {
+            u64 offset;
+            u32 size;
+            Encoding encoding;
+        };
+
+        constexpr static size_t MaxMatchesPerString = 1024;
+
+        explicit StringLocator(std::span<const std::string> strings);
+
+        /**
+         * @brief Scans a sample for all strings
+         * @param sample Sample to scan
+         * @param stopToken Token that aborts the scan when a stop is requested
+         * @return Matches of every string sorted by offset, in the same order as the strings passed to the constructor.
+         *         At most MaxMatchesPerString matches are reported per string
+         */
+        [[nodiscard]] std::vector<std::vector<Match>> locate(const SampleSource &sample, std::stop_token stopToken) const;
+
+    private:
+        struct Pattern {
+            u32 string;
+            u32 size;
+            Encoding encoding;
+        };
+
+        std::vector<Pattern> m_patterns;
+        PatternMatcher m_matcher;
+        size_t m_stringCount = 0;
+    };
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Append-only table of interned strings
+     * All strings are stored back to back in a single buffer and referred to by a 32 bit id, so strings that repeat
+     * thousands of times in a report are only stored once
+     */
+    class StringPool {
+    public:
+        using Id = u32;
+
+        constexpr static Id Empty = 0;
+
+        StringPool();
+
+        /**
+         * @brief Interns a string
+         * @param string String to intern
+         * @return Id of the string. Equal strings always yield the same id
+         */
+        Id intern(std::string_view string);
+
+        [[nodiscard]] std::string_view get(Id id) const {
+            return std::string_view(this->m_data).substr(this->m_offsets[id], this->m_offsets[id + 1] - this->m_offsets[id]);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return this->m_offsets.size() - 1;
+        }
+
+        /**
+         * @brief Drops the lookup table once no more strings will be interned and trims all buffers
+         */
+        void freeze();
+
+    private:
+        void rehash(size_t bucketCount);
+
+    private:
+        constexpr static u32 InvalidBucket = 0xFFFF'FFFF;
+
+        std::string m_data;
+        std::vector<u32> m_offsets;
+        std::vector<Id> m_buckets;
+    };
+
+}
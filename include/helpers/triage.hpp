@@ -0,0 +1,68 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/image_info.hpp>
+#include <helpers/malcore_api.hpp>
+#include <helpers/sample_source.hpp>
+#include <helpers/string_locator.hpp>
+
+#include <wolv/literals.hpp>
+
+#include <chrono>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    /**
+     * @brief Local pre-triage of a sample
+     * Gathers everything that can be known about a sample without the remote analysis, so there's something to look at
+     * right away. Strings and entropy are computed on all cores chunk by chunk while the hashes are calculated alongside
+     */
+    class Triage {
+    public:
+        struct String {
+            u64 offset;
+            std::string value;
+            StringLocator::Encoding encoding;
+        };
+
+        struct Result {
+            ImageInfo image;
+            std::string sha256, md5;
+
+            u64 entropyBlockSize = 0;
+            std::vector<float> entropy;
+
+            std::vector<String> strings;
+            bool stringsTruncated = false;
+
+            std::vector<MalcoreApi::PackerInformation> packers;
+
+            std::chrono::duration<double> duration = { };
+        };
+
+        constexpr static size_t ChunkSize = 4_MiB;
+        constexpr static size_t EntropyBlockCount = 1024;
+        constexpr static size_t MinStringLength = 5;
+        constexpr static size_t MaxStringLength = 1024;
+        constexpr static size_t MaxStrings = 100'000;
+
+        /**
+         * @brief Runs the pre-triage on the calling thread
+         * @param sample Sample to inspect
+         * @param stopToken Token that aborts the pre-triage when a stop is requested
+         * @return Pre-triage result or std::nullopt if it got cancelled
+         */
+        static std::optional<Result> run(const SampleSource &sample, std::stop_token stopToken);
+
+    private:
+        Triage() = default;
+    };
+
+}
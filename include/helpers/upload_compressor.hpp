@@ -0,0 +1,90 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <helpers/sample_source.hpp>
+
+#include <wolv/literals.hpp>
+
+#include <chrono>
+#include <optional>
+#include <stop_token>
+#include <vector>
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    /**
+     * @brief Compresses upload payloads into a single gzip stream while it's being sent
+     * The stream is produced in batches of blocks that are each deflated on their own on all cores, so only a single batch
+     * is ever held in memory. The blocks are flushed to a byte boundary so they can simply be appended to each other, and
+     * their checksums get combined for the trailer
+     */
+    class UploadCompressor {
+    public:
+        constexpr static size_t BlockSize = 1_MiB;
+        constexpr static int Level = 6;
+
+        /**
+         * @brief Creates a compressor for the start of a sample
+         * @param sample Sample to compress
+         * @param size Number of bytes to compress from the start of the sample
+         * @param stopToken Token that aborts the compression when a stop is requested
+         */
+        UploadCompressor(SampleSource sample, u64 size, std::stop_token stopToken);
+
+        /**
+         * @brief Fills a buffer with the next part of the gzip stream
+         * @param offset Offset in the stream to continue at. Either where the last read ended or 0 to start over
+         * @param buffer Buffer to write the data into
+         * @param size Size of the buffer
+         * @return Number of bytes written, 0 once the stream is complete or std::nullopt if compressing failed or got cancelled
+         */
+        std::optional<size_t> read(u64 offset, u8 *buffer, size_t size);
+
+        [[nodiscard]] bool isComplete() const {
+            return this->m_stage == Stage::Done && this->m_pendingOffset == this->m_pending.size();
+        }
+
+        [[nodiscard]] u64 getRawSize() const {
+            return this->m_size;
+        }
+
+        [[nodiscard]] u64 getCompressedSize() const {
+            return this->m_position;
+        }
+
+        /**
+         * @brief Time spent compressing, including the time waiting for the sample to be read
+         */
+        [[nodiscard]] std::chrono::duration<double> getDuration() const {
+            return this->m_duration;
+        }
+
+        [[nodiscard]] double getRatio() const {
+            return this->m_position == 0 ? 1.0 : double(this->m_size) / this->m_position;
+        }
+
+    private:
+        enum class Stage { Blocks, Trailer, Done };
+
+        void restart();
+        bool compressNextBatch();
+
+        SampleSource m_sample;
+        u64 m_size;
+        std::stop_token m_stopToken;
+
+        u64 m_blockCount, m_nextBlock = 0;
+        Stage m_stage = Stage::Blocks;
+
+        std::vector<u8> m_pending;
+        size_t m_pendingOffset = 0;
+        u64 m_position = 0;
+        u64 m_crc = 0;
+
+        std::chrono::duration<double> m_duration = { };
+    };
+
+}
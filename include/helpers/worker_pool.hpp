@@ -0,0 +1,49 @@
+#pragma once
+
+#include <hex.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mal::hlp {
+
+    /**
+     * @brief Process wide pool of threads that all CPU bound work of the plugin is spread over
+     * Splitting, hashing, scanning and compressing all run on the same threads instead of starting new ones on every call
+     */
+    class WorkerPool {
+    public:
+        /**
+         * @brief Number of threads a job can run on at once, including the calling thread
+         */
+        static u32 getConcurrency();
+
+        /**
+         * @brief Runs a job on the pool's threads and on the calling thread, and waits until it's done everywhere
+         * The job is called once per participant and is expected to claim work from a shared counter until there's nothing left.
+         * Participants that no pool thread has picked up yet are run by the calling thread itself, so nested calls can't starve the pool
+         * @param participants Number of times the job is run, usually the smaller of the amount of work and getConcurrency()
+         * @param job Function that's called with the index of the participant running it
+         */
+        static void run(u32 participants, const std::function<void(u32 participant)> &job);
+
+    private:
+        WorkerPool();
+        ~WorkerPool() = default;
+
+        static WorkerPool &get();
+        void enqueue(std::function<void()> job);
+
+    private:
+        std::mutex m_queueMutex;
+        std::condition_variable_any m_queueCondVar;
+        std::deque<std::function<void()>> m_queue;
+
+        std::vector<std::jthread> m_workers;
+    };
+
+}
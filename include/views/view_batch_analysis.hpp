@@ -0,0 +1,115 @@
+#pragma once
+
+#include <hex/ui/view.hpp>
+
+#include <helpers/analysis_runner.hpp>
+#include <helpers/malcore_api.hpp>
+#include <helpers/sample_source.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace mal {
+
+    class ViewBatchAnalysis : public hex::View {
+    public:
+        ViewBatchAnalysis();
+        ~ViewBatchAnalysis() override;
+
+        void drawContent() override;
+
+        [[nodiscard]] bool isAvailable() const override {
+            return this->m_hasEntries && View::isAvailable();
+        }
+
+        static void setMaxInFlight(u32 maxInFlight) {
+            s_maxInFlight = std::max<u32>(maxInFlight, 1);
+        }
+
+    private:
+        enum class State {
+            Queued,
+            Analyzing,
+            Done,
+            Failed,
+            Cancelled
+        };
+
+        /**
+         * @brief Access to a provider that's being analyzed, revoked as soon as the provider gets closed
+         * The provider is pinned only while it's being accessed, so a long digest never holds the lease's lock
+         */
+        struct ProviderLease {
+            std::mutex mutex;
+            std::condition_variable unpinned;
+            hex::prv::Provider *provider = nullptr;
+            u32 pins = 0;
+
+            /**
+             * @brief Keeps the provider from being revoked until unpin() is called
+             * @return Provider to access, nullptr if the lease was revoked already and nothing must be unpinned
+             */
+            hex::prv::Provider *pin();
+            void unpin();
+
+            /**
+             * @brief Revokes the lease and waits for all accesses that are still running
+             */
+            void revoke();
+        };
+
+        /**
+         * @brief Sample of a batch that hasn't been opened yet
+         * Files are only opened once a worker picks them up, so a batch never keeps more files open than it has workers
+         */
+        struct Job {
+            std::string name;
+
+            std::optional<std::fs::path> path;
+            hex::prv::Provider *provider = nullptr;
+            std::shared_ptr<ProviderLease> lease;
+
+            std::stop_source stopSource;
+        };
+
+        struct Entry {
+            std::string name;
+            State state = State::Queued;
+
+            std::string hash;
+            std::optional<float> threatScore;
+            std::optional<hlp::MalcoreApi::PackerInformation> packer;
+
+            std::optional<double> duration, bandwidth;
+            hlp::AnalysisRunner::Origin origin = hlp::AnalysisRunner::Origin::Upload;
+            bool shared = false;
+        };
+
+        void analyzeOpenProviders();
+        void analyzeDirectory(const std::fs::path &path);
+        void startBatch(std::vector<Job> jobs);
+        void analyzeJob(size_t index);
+        void cancelProviderJobs(hex::prv::Provider *provider);
+        void revokeProviderJobs(hex::prv::Provider *provider);
+
+        static hlp::SampleSource createSample(const std::shared_ptr<ProviderLease> &lease, std::string name);
+
+    private:
+        std::mutex m_entriesMutex;
+        std::vector<Entry> m_entries;
+        std::vector<Job> m_jobs;
+        std::atomic<bool> m_hasEntries = false;
+        std::atomic<bool> m_running = false;
+
+        std::optional<double> m_wallTime;
+
+        static inline std::atomic<u32> s_maxInFlight = 4;
+    };
+
+}
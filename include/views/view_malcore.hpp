@@ -0,0 +1,148 @@
+#pragma once
+
+#include <hex/ui/view.hpp>
+#include <hex/providers/provider_data.hpp>
+
+#include <helpers/analysis_diff.hpp>
+#include <helpers/analysis_runner.hpp>
+#include <helpers/annotation_index.hpp>
+#include <helpers/api_trace_index.hpp>
+#include <helpers/malcore_api.hpp>
+#include <helpers/report_pages.hpp>
+#include <helpers/result_archive.hpp>
+#include <helpers/string_locator.hpp>
+#include <helpers/triage.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace mal {
+
+    class ViewMalcore : public hex::View {
+    public:
+        ViewMalcore();
+        ~ViewMalcore() override;
+
+        void drawContent() override;
+        void drawAlwaysVisible() override;
+
+        [[nodiscard]] bool isAvailable() const override {
+            return hex::ImHexApi::Provider::isValid() && (this->m_analysis.get() != nullptr || this->m_triage.get() != nullptr) && View::isAvailable();
+        }
+
+    private:
+        /**
+         * @brief Analysis summary of a provider
+         * Only the summary of the status response is parsed into it, the traces are never decoded as a whole
+         */
+        struct Analysis : hlp::MalcoreApi::AnalysisResult {
+            explicit Analysis(hlp::MalcoreApi::AnalysisResult result) : AnalysisResult(std::move(result)) { }
+
+            std::vector<std::vector<hlp::StringLocator::Match>> stringMatches;
+            hlp::AnnotationIndex annotations;
+
+            // Headers of all traces, so they can be listed without decoding any page
+            std::vector<hlp::ResultArchive::TraceHeader> traceHeaders;
+
+            // Outcome and timings of the run that produced this analysis, without its status response
+            hlp::AnalysisRunner::Result runResult;
+
+            // Traces are kept in compressed pages that are only decoded once they're expanded, no matter if they
+            // come from a fresh analysis or were restored from a project
+            std::shared_ptr<const hlp::ReportPages> tracePages;
+
+            // Number of stored pages whose call sites are part of the annotations. Pages fetched later on are annotated again
+            u32 annotatedPageCount = 0;
+
+            // Analyses restored from a project don't have a run result
+            bool restored = false;
+        };
+
+        /**
+         * @brief Single decoded trace together with whatever keeps it alive
+         */
+        struct TraceRef {
+            std::shared_ptr<const void> owner;
+            const hlp::MalcoreApi::DynamicAnalysisResult *trace = nullptr;
+            const hlp::StringPool *strings = nullptr;
+        };
+
+        struct TraceFilter {
+            std::string name, pcStart, pcEnd, argument;
+
+            hlp::ApiTraceIndex::SortColumn sortColumn = hlp::ApiTraceIndex::SortColumn::Index;
+            bool ascending = true;
+
+            std::vector<u32> rows;
+            bool dirty = true;
+        };
+
+        /**
+         * @brief Comparison of a provider's analysis with the one of another provider
+         * Keeps the snapshots it was made from, so it's redone as soon as either side gets a new analysis
+         */
+        struct Comparison {
+            hex::prv::Provider *other = nullptr;
+            std::shared_ptr<const Analysis> left, right;
+
+            hlp::AnalysisDiff::SetDiff signatures, strings;
+
+            u32 leftTrace = 0, rightTrace = 0;
+            std::shared_ptr<const hlp::AnalysisDiff::TraceDiff> traceDiff;
+            TraceRef leftSource, rightSource;
+
+            // Stop source of the trace diff that's running for this comparison, if there is one
+            std::shared_ptr<std::stop_source> diffing;
+        };
+
+        static void drawTrace(const hlp::MalcoreApi::DynamicAnalysisResult &trace, const hlp::StringPool &strings, const hlp::ApiTraceIndex &index, TraceFilter &filter);
+        static void drawApiCall(const hlp::MalcoreApi::Api &api, const hlp::MalcoreApi::DynamicAnalysisResult &trace, const hlp::StringPool &strings);
+
+        static void drawTriage(const hlp::Triage::Result &triage);
+        static void drawInterestingStrings(const Analysis &analysis);
+        static void drawDiagnostics(const Analysis &analysis, std::chrono::duration<double> drawDuration);
+
+        void drawComparison(hex::prv::Provider *provider, const std::shared_ptr<const Analysis> &analysis);
+        static void drawSetDiff(const char *name, const hlp::AnalysisDiff::SetDiff &diff);
+        static void drawTraceDiff(const Comparison &comparison);
+        static void stopTraceDiff(Comparison &comparison);
+
+        static hlp::AnnotationIndex buildAnnotations(hex::prv::Provider *provider, const Analysis &analysis, u32 *annotatedPageCount = nullptr);
+        static std::optional<TraceRef> loadTrace(const std::shared_ptr<const Analysis> &analysis, u32 index);
+
+        void startTriageTask(hex::prv::Provider *provider, std::shared_ptr<std::promise<std::optional<hlp::SampleSource::Hash>>> sha256 = nullptr);
+        void startAnalysisTask();
+        void startAnnotationTask(hex::prv::Provider *provider, std::shared_ptr<const Analysis> analysis);
+        void startPageLoadTask(hex::prv::Provider *provider, std::shared_ptr<const Analysis> analysis, u32 page);
+        void startTraceDiffTask(hex::prv::Provider *provider, Comparison &comparison);
+
+        void registerProjectHandler();
+
+        static void setApiKey(const std::string &key);
+
+    private:
+        std::string m_apiKey;
+
+        /*
+         * Every provider has its own immutable analysis snapshot. Snapshots are built on the analysis task and
+         * only ever swapped in on the main thread, so drawing never sees a partially written result.
+         * The local pre-triage is published the same way and stays visible next to the remote results
+         */
+        mutable hex::PerProvider<std::shared_ptr<const Analysis>> m_analysis;
+        mutable hex::PerProvider<std::shared_ptr<const hlp::Triage::Result>> m_triage;
+        hex::PerProvider<std::vector<TraceFilter>> m_traceFilters;
+        hex::PerProvider<Comparison> m_comparisons;
+
+        // Bumped every time a run is started, so results of older runs that finish late are dropped instead of published
+        hex::PerProvider<u64> m_analysisGeneration, m_triageGeneration;
+
+        u32 m_highlightProvider = 0, m_tooltipProvider = 0;
+        std::chrono::duration<double> m_drawDuration = { };
+    };
+
+}
@@ -0,0 +1,503 @@
+#include <helpers/analysis_runner.hpp>
+#include <helpers/malcore_api.hpp>
+#include <helpers/request_scheduler.hpp>
+#include <helpers/result_cache.hpp>
+#include <helpers/sample_source.hpp>
+#include <helpers/status_parser.hpp>
+
+#include <curl/curl.h>
+#include <wolv/io/file.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+ * Heap usage is tracked by replacing the global allocation functions, so the numbers only include what the
+ * client itself allocates and not whatever the allocator or the OS keep around
+ */
+namespace {
+
+    std::atomic<u64> s_heapInUse = 0, s_heapPeak = 0;
+
+    void *allocate(std::size_t size) {
+        auto pointer = static_cast<std::size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+        if (pointer == nullptr)
+            throw std::bad_alloc();
+
+        *pointer = size;
+
+        const auto inUse = s_heapInUse += size;
+        auto peak = s_heapPeak.load();
+        while (inUse > peak && !s_heapPeak.compare_exchange_weak(peak, inUse)) { }
+
+        return reinterpret_cast<u8*>(pointer) + sizeof(std::max_align_t);
+    }
+
+    void deallocate(void *pointer) {
+        if (pointer == nullptr)
+            return;
+
+        auto base = reinterpret_cast<std::size_t*>(static_cast<u8*>(pointer) - sizeof(std::max_align_t));
+        s_heapInUse -= *base;
+        std::free(base);
+    }
+
+}
+
+void *operator new(std::size_t size)                    { return allocate(size); }
+void *operator new[](std::size_t size)                  { return allocate(size); }
+void operator delete(void *pointer) noexcept            { deallocate(pointer); }
+void operator delete[](void *pointer) noexcept          { deallocate(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept   { deallocate(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { deallocate(pointer); }
+
+using namespace mal;
+using namespace wolv::literals;
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+    struct Options {
+        std::string scenario;
+
+        u64 sampleSize = 1_MiB;
+        u32 count = 10;
+        u32 concurrency = 1;
+        bool compressible = false;
+
+        // Samples are different on every run unless a fixed seed is given
+        u64 seed = Clock::now().time_since_epoch().count();
+
+        std::fs::path report;
+        std::fs::path sampleFolder = std::fs::temp_directory_path() / "malcore_bench";
+    };
+
+    void printUsage() {
+        std::fputs(
+            "Usage: malcore_bench [options] <scenario>\n"
+            "Benchmarks the Malcore API client, usually against a local malcore_mock instance\n"
+            "\n"
+            "Scenarios:\n"
+            "  upload    Uploads samples one after another and reports throughput and peak heap usage\n"
+            "  poll      Polls the status of a finished analysis and reports the request latency\n"
+            "  parse     Parses a status response and reports parse time and the size of the parsed result\n"
+            "  analyze   Runs whole analyses of distinct samples, --concurrency of them at once\n"
+            "\n"
+            "Options:\n"
+            "  --api-url <url>        Base URL of the API (default: http://127.0.0.1:8417/api)\n"
+            "  --size <KiB>           Size of every generated sample (default: 1024)\n"
+            "  --count <count>        Number of samples, requests or parses (default: 10)\n"
+            "  --concurrency <count>  Number of analyses running at the same time (default: 1)\n"
+            "  --compressible         Generate text-like samples instead of random data\n"
+            "  --lookup               Look up existing reports by hash before uploading\n"
+            "  --compress             Compress uploads if the API accepts gzip encoded ones\n"
+            "  --report <file>        Status response to parse, fetched from the API if not given\n"
+            "  --rate-limit <count>   Maximum API requests per minute, 0 for no limit (default: 0)\n"
+            "  --seed <number>        Seed of the generated samples, so a later run can send the same ones again\n",
+            stderr);
+    }
+
+    std::optional<Options> parseArguments(std::span<char*> arguments) {
+        Options options;
+
+        hlp::MalcoreApi::setBaseUrl("http://127.0.0.1:8417/api");
+        hlp::RequestScheduler::setRateLimit(0);
+
+        for (size_t i = 0; i < arguments.size(); i++) {
+            const std::string_view argument = arguments[i];
+
+            if (argument == "--help" || argument == "-h")
+                return std::nullopt;
+
+            if (argument == "--compressible") {
+                options.compressible = true;
+                continue;
+            }
+
+            if (argument == "--lookup") {
+                hlp::MalcoreApi::setHashLookup(true);
+                continue;
+            }
+
+            if (argument == "--compress") {
+                hlp::MalcoreApi::setCompressUploads(true);
+                continue;
+            }
+
+            if (!argument.starts_with("--")) {
+                options.scenario = argument;
+                continue;
+            }
+
+            if (i + 1 >= arguments.size()) {
+                std::fprintf(stderr, "Missing value for %s\n", arguments[i]);
+                return std::nullopt;
+            }
+
+            const std::string value = arguments[++i];
+            const auto number = std::strtoull(value.c_str(), nullptr, 10);
+
+            if (argument == "--api-url")             hlp::MalcoreApi::setBaseUrl(value);
+            else if (argument == "--size")           options.sampleSize = std::max<u64>(number, 1) * 1_KiB;
+            else if (argument == "--count")          options.count = std::max<u32>(number, 1);
+            else if (argument == "--concurrency")    options.concurrency = std::clamp<u32>(number, 1, 1024);
+            else if (argument == "--report")         options.report = value;
+            else if (argument == "--rate-limit")     hlp::RequestScheduler::setRateLimit(number);
+            else if (argument == "--seed")           options.seed = number;
+            else {
+                std::fprintf(stderr, "Unknown option %s\n", arguments[i - 1]);
+                return std::nullopt;
+            }
+        }
+
+        if (options.scenario.empty())
+            return std::nullopt;
+
+        return options;
+    }
+
+    /**
+     * @brief Writes a sample to disk. Every sample gets different content so neither the cache nor the lookup can answer it,
+     * unless the same seed is used again
+     */
+    std::optional<hlp::SampleSource> createSample(const Options &options, u32 index) {
+        std::error_code error;
+        std::fs::create_directories(options.sampleFolder, error);
+
+        const auto path = options.sampleFolder / ("sample_" + std::to_string(index) + ".bin");
+        {
+            std::mt19937_64 random(index * 0x9E3779B97F4A7C15ULL + options.seed);
+            std::ofstream file(path, std::ios::binary);
+
+            // Written block by block, so generating large samples doesn't show up in the peak memory usage
+            std::vector<u8> block(std::min<u64>(options.sampleSize, 1_MiB));
+            for (u64 written = 0; written < options.sampleSize; written += block.size()) {
+                block.resize(std::min<u64>(block.size(), options.sampleSize - written));
+
+                if (options.compressible) {
+                    constexpr static std::string_view Words[] = { "GetProcAddress ", "kernel32.dll ", "CreateFileW ", "0x00401000 ", "\xCC\xCC\xCC\xCC", "http://example.com/ " };
+
+                    size_t offset = 0;
+                    while (offset < block.size()) {
+                        const auto &word = Words[random() % std::size(Words)];
+                        const auto size = std::min(word.size(), block.size() - offset);
+                        std::copy_n(word.begin(), size, block.begin() + offset);
+                        offset += size;
+                    }
+                } else {
+                    for (auto &byte : block)
+                        byte = u8(random());
+                }
+
+                file.write(reinterpret_cast<const char*>(block.data()), block.size());
+            }
+        }
+
+        return hlp::SampleSource::fromFile(path);
+    }
+
+    struct Statistics {
+        Seconds total = { }, min = { }, median = { }, p95 = { }, max = { };
+    };
+
+    Statistics getStatistics(std::vector<Seconds> samples) {
+        Statistics result;
+        if (samples.empty())
+            return result;
+
+        std::sort(samples.begin(), samples.end());
+        for (const auto &sample : samples)
+            result.total += sample;
+
+        result.min    = samples.front();
+        result.median = samples[samples.size() / 2];
+        result.p95    = samples[std::min<size_t>(samples.size() * 95 / 100, samples.size() - 1)];
+        result.max    = samples.back();
+
+        return result;
+    }
+
+    void printStatistics(const char *name, const Statistics &statistics) {
+        std::printf("%-24s min %8.2f ms  median %8.2f ms  p95 %8.2f ms  max %8.2f ms\n", name,
+            statistics.min.count() * 1000, statistics.median.count() * 1000, statistics.p95.count() * 1000, statistics.max.count() * 1000);
+    }
+
+    double toMiB(u64 bytes) {
+        return double(bytes) / 1_MiB;
+    }
+
+    /**
+     * @brief Reads a numeric field of the process status, like the thread count or the peak resident set size
+     */
+    u64 readProcessStatus(std::string_view field) {
+        std::ifstream status("/proc/self/status");
+
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.starts_with(field) && line.size() > field.size() && line[field.size()] == ':')
+                return std::strtoull(line.c_str() + field.size() + 1, nullptr, 10);
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief Samples the number of threads of the process while a scenario runs
+     */
+    class ThreadCounter {
+    public:
+        ThreadCounter() : m_thread([this](std::stop_token stopToken) {
+            while (!stopToken.stop_requested()) {
+                this->m_peak = std::max<u32>(this->m_peak.load(), readProcessStatus("Threads"));
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }) { }
+
+        [[nodiscard]] u32 getPeak() const {
+            return this->m_peak;
+        }
+
+    private:
+        std::atomic<u32> m_peak = 0;
+        std::jthread m_thread;
+    };
+
+    int runUpload(const Options &options) {
+        std::vector<Seconds> durations;
+        u64 bytesSent = 0;
+        Seconds totalDuration = { };
+
+        for (u32 i = 0; i < options.count; i++) {
+            auto sample = createSample(options, i);
+            if (!sample.has_value())
+                return EXIT_FAILURE;
+
+            s_heapPeak = s_heapInUse.load();
+            const auto heapBefore = s_heapInUse.load();
+
+            const auto upload = hlp::MalcoreApi::uploadSample(*sample);
+            if (!upload.uuid.has_value()) {
+                std::fputs("Upload failed\n", stderr);
+                return EXIT_FAILURE;
+            }
+
+            durations.push_back(upload.duration);
+            bytesSent += upload.bytesSent;
+            totalDuration += upload.duration;
+
+            if (i == 0)
+                std::printf("Peak heap during upload    %.2f MiB above the %.2f MiB before it\n", toMiB(s_heapPeak - heapBefore), toMiB(heapBefore));
+        }
+
+        std::printf("Peak resident set          %.2f MiB\n", toMiB(readProcessStatus("VmHWM") * 1_KiB));
+
+        std::printf("Uploaded %u samples of %.2f MiB, %.2f MiB on the wire\n", options.count, toMiB(options.sampleSize), toMiB(bytesSent));
+        std::printf("Throughput                 %.2f MiB/s of sample data\n", toMiB(options.sampleSize) * options.count / totalDuration.count());
+        printStatistics("Upload duration", getStatistics(durations));
+
+        return EXIT_SUCCESS;
+    }
+
+    std::optional<std::string> fetchFinishedStatus(const Options &options) {
+        auto sample = createSample(options, 0);
+        if (!sample.has_value())
+            return std::nullopt;
+
+        auto result = hlp::AnalysisRunner::run(*sample, { });
+        if (result.error != hlp::AnalysisRunner::Error::None)
+            return std::nullopt;
+
+        return std::move(result.status);
+    }
+
+    int runPoll(const Options &options) {
+        auto sample = createSample(options, 0);
+        if (!sample.has_value())
+            return EXIT_FAILURE;
+
+        const auto upload = hlp::MalcoreApi::uploadSample(*sample);
+        if (!upload.uuid.has_value()) {
+            std::fputs("Upload failed\n", stderr);
+            return EXIT_FAILURE;
+        }
+
+        std::vector<Seconds> durations;
+        u64 bytesReceived = 0;
+        for (u32 i = 0; i < options.count; i++) {
+            const auto startTime = Clock::now();
+            const auto status = hlp::MalcoreApi::getAnalysisStatus(*upload.uuid);
+            durations.push_back(Clock::now() - startTime);
+
+            if (!status.has_value()) {
+                std::fputs("Status request failed\n", stderr);
+                return EXIT_FAILURE;
+            }
+
+            bytesReceived += status->size();
+        }
+
+        std::printf("Polled %u times, %.2f MiB received\n", options.count, toMiB(bytesReceived));
+        printStatistics("Poll latency", getStatistics(durations));
+
+        return EXIT_SUCCESS;
+    }
+
+    int runParse(const Options &options) {
+        std::optional<std::string> status;
+        if (!options.report.empty()) {
+            wolv::io::File file(options.report, wolv::io::File::Mode::Read);
+            if (file.isValid())
+                status = file.readString();
+        } else {
+            status = fetchFinishedStatus(options);
+        }
+
+        if (!status.has_value()) {
+            std::fputs("Failed to get a status response to parse\n", stderr);
+            return EXIT_FAILURE;
+        }
+
+        std::vector<Seconds> durations;
+        u64 resultSize = 0, peakSize = 0, apiCount = 0;
+        for (u32 i = 0; i < options.count; i++) {
+            const auto heapBefore = s_heapInUse.load();
+            s_heapPeak = heapBefore;
+
+            const auto startTime = Clock::now();
+            auto result = hlp::StatusParser::parse(*status);
+            durations.push_back(Clock::now() - startTime);
+
+            if (!result.has_value()) {
+                std::fputs("Failed to parse the status response\n", stderr);
+                return EXIT_FAILURE;
+            }
+
+            resultSize = s_heapInUse - heapBefore;
+            peakSize   = s_heapPeak - heapBefore;
+
+            apiCount = 0;
+            if (result->dynamicAnalysisResults.has_value()) {
+                for (const auto &trace : *result->dynamicAnalysisResults)
+                    apiCount += trace.apis.size();
+            }
+        }
+
+        std::printf("Status response            %.2f MiB, %llu API calls\n", toMiB(status->size()), static_cast<unsigned long long>(apiCount));
+        std::printf("Parsed result              %.2f MiB on the heap, %.2f MiB peak while parsing\n", toMiB(resultSize), toMiB(peakSize));
+        printStatistics("Parse time", getStatistics(durations));
+
+        return EXIT_SUCCESS;
+    }
+
+    int runAnalyze(const Options &options) {
+        std::vector<hlp::SampleSource> samples;
+        for (u32 i = 0; i < options.count; i++) {
+            auto sample = createSample(options, i);
+            if (!sample.has_value())
+                return EXIT_FAILURE;
+
+            samples.push_back(std::move(*sample));
+        }
+
+        std::vector<Seconds> durations(samples.size());
+        std::atomic<u32> failed = 0;
+        std::map<hlp::AnalysisRunner::Origin, u32> origins;
+        std::mutex originsMutex;
+
+        ThreadCounter threads;
+
+        const auto startTime = Clock::now();
+        {
+            std::atomic<size_t> nextSample = 0;
+
+            std::vector<std::jthread> workers;
+            for (u32 i = 0; i < std::min<size_t>(options.concurrency, samples.size()); i++) {
+                workers.emplace_back([&] {
+                    while (true) {
+                        const auto index = nextSample++;
+                        if (index >= samples.size())
+                            break;
+
+                        const auto result = hlp::AnalysisRunner::run(samples[index], { }, hlp::RequestScheduler::Priority::Batch);
+                        durations[index] = result.duration;
+
+                        if (result.error != hlp::AnalysisRunner::Error::None)
+                            failed += 1;
+
+                        std::scoped_lock lock(originsMutex);
+                        origins[result.origin] += 1;
+                    }
+                });
+            }
+        }
+        const Seconds wallTime = Clock::now() - startTime;
+
+        const auto requests = hlp::RequestScheduler::getCounters();
+
+        std::printf("Analyzed %u samples, %u at a time, %u failed\n", options.count, options.concurrency, failed.load());
+        std::printf("Wall time                  %.2f s, %.1f analyses per minute\n", wallTime.count(), options.count / wallTime.count() * 60);
+        std::printf("Peak thread count          %u\n", threads.getPeak());
+        std::printf("Peak resident set          %.2f MiB\n", toMiB(readProcessStatus("VmHWM") * 1_KiB));
+        std::printf("Origins                    %u uploaded, %u looked up, %u cached\n",
+            origins[hlp::AnalysisRunner::Origin::Upload], origins[hlp::AnalysisRunner::Origin::Lookup], origins[hlp::AnalysisRunner::Origin::Cache]);
+        std::printf("Requests                   %llu retried, %llu throttled\n",
+            static_cast<unsigned long long>(requests.retried), static_cast<unsigned long long>(requests.throttled));
+        printStatistics("Analysis duration", getStatistics(durations));
+
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+}
+
+int main(int argc, char **argv) {
+    const auto options = parseArguments(std::span(argv + 1, argv + argc));
+    if (!options.has_value()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    const std::map<std::string_view, std::function<int(const Options &)>> scenarios = {
+        { "upload",  runUpload  },
+        { "poll",    runPoll    },
+        { "parse",   runParse   },
+        { "analyze", runAnalyze }
+    };
+
+    const auto scenario = scenarios.find(options->scenario);
+    if (scenario == scenarios.end()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    hex::log::impl::redirectToFile();
+
+    curl_global_init(CURL_GLOBAL_ALL);
+    hlp::MalcoreApi::setApiKey("benchmark");
+
+    // Every run should talk to the API, nothing is answered from or left behind in the cache
+    hlp::ResultCache::setForceRefresh(true);
+    hlp::ResultCache::setMaxSize(0);
+
+    const auto result = scenario->second(*options);
+
+    std::error_code error;
+    std::fs::remove_all(options->sampleFolder, error);
+
+    curl_global_cleanup();
+
+    return result;
+}
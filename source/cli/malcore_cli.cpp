@@ -0,0 +1,291 @@
+#include <helpers/analysis_runner.hpp>
+#include <helpers/malcore_api.hpp>
+#include <helpers/report_pages.hpp>
+#include <helpers/request_scheduler.hpp>
+#include <helpers/result_cache.hpp>
+#include <helpers/sample_source.hpp>
+#include <helpers/status_parser.hpp>
+
+#include <hex/helpers/crypto.hpp>
+#include <hex/helpers/logger.hpp>
+
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+#include <wolv/utils/string.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace mal;
+
+namespace {
+
+    struct Options {
+        std::vector<std::fs::path> paths;
+        std::string apiKey;
+        u32 jobs = 4;
+    };
+
+    void printUsage() {
+        std::fputs(
+            "Usage: malcore_cli [options] <file or folder>...\n"
+            "Analyzes all given files with Malcore and prints one JSON line per file\n"
+            "\n"
+            "Options:\n"
+            "  --jobs <count>       Number of files analyzed at the same time (default: 4)\n"
+            "  --api-key <key>      Malcore API key, defaults to the MALCORE_API_KEY environment variable\n"
+            "  --api-url <url>      Base URL of the Malcore API\n"
+            "  --upload-limit <MiB> Maximum number of bytes uploaded per file\n"
+            "  --rate-limit <count> Maximum API requests per minute, 0 for no limit (default: 60)\n"
+            "  --compress           Compress uploads if the API accepts gzip encoded ones\n"
+            "  --lookup             Look up existing reports by hash before uploading\n"
+            "  --refresh            Ignore cached results\n",
+            stderr);
+    }
+
+    std::optional<Options> parseArguments(std::span<char*> arguments) {
+        Options options;
+        if (const auto apiKey = std::getenv("MALCORE_API_KEY"); apiKey != nullptr)
+            options.apiKey = apiKey;
+
+        for (size_t i = 0; i < arguments.size(); i++) {
+            const std::string_view argument = arguments[i];
+
+            auto nextValue = [&]() -> std::optional<std::string_view> {
+                if (i + 1 >= arguments.size())
+                    return std::nullopt;
+
+                return arguments[++i];
+            };
+
+            if (argument == "--help" || argument == "-h") {
+                return std::nullopt;
+            } else if (argument == "--compress") {
+                hlp::MalcoreApi::setCompressUploads(true);
+            } else if (argument == "--lookup") {
+                hlp::MalcoreApi::setHashLookup(true);
+            } else if (argument == "--refresh") {
+                hlp::ResultCache::setForceRefresh(true);
+            } else if (argument == "--jobs" || argument == "--api-key" || argument == "--api-url" || argument == "--upload-limit" || argument == "--rate-limit") {
+                const auto value = nextValue();
+                if (!value.has_value()) {
+                    std::fprintf(stderr, "Missing value for %s\n", arguments[i]);
+                    return std::nullopt;
+                }
+
+                if (argument == "--jobs")
+                    options.jobs = std::clamp<u32>(std::strtoul(value->data(), nullptr, 10), 1, 64);
+                else if (argument == "--api-key")
+                    options.apiKey = *value;
+                else if (argument == "--api-url")
+                    hlp::MalcoreApi::setBaseUrl(std::string(*value));
+                else if (argument == "--rate-limit")
+                    hlp::RequestScheduler::setRateLimit(std::strtoul(value->data(), nullptr, 10));
+                else
+                    hlp::MalcoreApi::setUploadLimit(std::strtoull(value->data(), nullptr, 10) * 1024 * 1024);
+            } else if (argument.starts_with("--")) {
+                std::fprintf(stderr, "Unknown option %s\n", arguments[i]);
+                return std::nullopt;
+            } else {
+                options.paths.emplace_back(std::string(argument));
+            }
+        }
+
+        if (options.paths.empty())
+            return std::nullopt;
+
+        return options;
+    }
+
+    std::vector<std::fs::path> collectFiles(const std::vector<std::fs::path> &paths) {
+        std::vector<std::fs::path> files;
+
+        for (const auto &path : paths) {
+            std::error_code error;
+            if (!std::fs::is_directory(path, error)) {
+                files.push_back(path);
+                continue;
+            }
+
+            for (const auto &entry : std::fs::recursive_directory_iterator(path, std::fs::directory_options::skip_permission_denied, error)) {
+                if (entry.is_regular_file(error))
+                    files.push_back(entry.path());
+            }
+        }
+
+        return files;
+    }
+
+    std::string_view getErrorName(hlp::AnalysisRunner::Error error) {
+        switch (error) {
+            using enum hlp::AnalysisRunner::Error;
+
+            case None:          return "none";
+            case Cancelled:     return "cancelled";
+            case UploadFailed:  return "upload_failed";
+            case StatusFailed:  return "status_failed";
+            case TimedOut:      return "timed_out";
+        }
+
+        return "unknown";
+    }
+
+    std::string_view getOriginName(hlp::AnalysisRunner::Origin origin) {
+        switch (origin) {
+            using enum hlp::AnalysisRunner::Origin;
+
+            case Cache:   return "cache";
+            case Lookup:  return "lookup";
+            case Upload:  return "upload";
+        }
+
+        return "unknown";
+    }
+
+    /**
+     * @brief Analyzes a single file and builds its output line
+     * Only the headers of the traces are printed, their individual calls would make lines of hundreds of megabytes.
+     * That's why the traces are cut out of the response before parsing it instead of being decoded for nothing
+     */
+    nlohmann::json analyzeFile(const std::fs::path &path, bool &failed) {
+        nlohmann::json line;
+        line["file"] = wolv::util::toUTF8String(path);
+
+        auto sample = hlp::SampleSource::fromFile(path);
+        if (!sample.has_value()) {
+            line["error"] = "open_failed";
+            failed = true;
+            return line;
+        }
+
+        const auto result = hlp::AnalysisRunner::run(*sample, { }, hlp::RequestScheduler::Priority::Batch);
+
+        line["size"]     = sample->getSize();
+        line["sha256"]   = hex::crypt::encode16({ result.hash.begin(), result.hash.end() });
+        line["origin"]   = getOriginName(result.origin);
+        line["shared"]   = result.shared;
+        line["duration"] = result.duration.count();
+
+        if (result.error != hlp::AnalysisRunner::Error::None) {
+            line["error"] = getErrorName(result.error);
+            failed = true;
+            return line;
+        }
+
+        std::vector<hlp::ReportPages::TraceHeader> traceHeaders;
+        auto summary  = hlp::ReportPages::extractSummary(*result.status, &traceHeaders);
+        auto analysis = summary.has_value() ? hlp::StatusParser::parse(*summary) : std::nullopt;
+        if (!analysis.has_value()) {
+            line["error"] = "invalid_status";
+            failed = true;
+            return line;
+        }
+
+        line["threat_score"] = nullptr;
+        line["signatures"]   = nlohmann::json::array();
+        if (analysis->threatScore.has_value()) {
+            line["threat_score"] = analysis->threatScore->score;
+            for (const auto &signature : analysis->threatScore->signatures)
+                line["signatures"].push_back(signature.title);
+        }
+
+        line["packer"] = nullptr;
+        if (analysis->packerInformation.has_value())
+            line["packer"] = { { "name", analysis->packerInformation->name }, { "confidence", analysis->packerInformation->confidence } };
+
+        line["strings"] = analysis->interestingStrings.value_or(std::vector<std::string>());
+
+        line["traces"] = nlohmann::json::array();
+        for (const auto &trace : traceHeaders)
+            line["traces"].push_back({ { "hash", trace.hash }, { "calls", trace.apiCount } });
+
+        return line;
+    }
+
+    /**
+     * @brief Builds the output line of a file, no matter what happens while analyzing it
+     * File names and reported strings aren't necessarily valid UTF-8, invalid sequences are replaced instead of failing the line
+     */
+    std::string getOutputLine(const std::fs::path &path, bool &failed) {
+        nlohmann::json line;
+
+        try {
+            line = analyzeFile(path, failed);
+        } catch (const std::exception &e) {
+            hex::log::error("Failed to analyze {}: {}", wolv::util::toUTF8String(path), e.what());
+
+            line = { { "file", wolv::util::toUTF8String(path) }, { "error", "internal_error" } };
+            failed = true;
+        }
+
+        return line.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    }
+
+}
+
+int main(int argc, char **argv) {
+    const auto options = parseArguments(std::span(argv + 1, argv + argc));
+    if (!options.has_value()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    if (options->apiKey.empty()) {
+        std::fputs("No Malcore API key given, set MALCORE_API_KEY or pass --api-key\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    // Standard output only carries the result lines, everything the pipeline logs goes to ImHex's log file instead
+    hex::log::impl::redirectToFile();
+
+    curl_global_init(CURL_GLOBAL_ALL);
+    hlp::MalcoreApi::setApiKey(options->apiKey);
+
+    const auto files = collectFiles(options->paths);
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::mutex outputMutex;
+    std::atomic<size_t> nextFile = 0, failedFiles = 0;
+    {
+        // Every worker keeps exactly one file in flight, just like the batch analysis in the plugin
+        std::vector<std::jthread> workers;
+        for (u32 i = 0; i < std::min<size_t>(options->jobs, files.size()); i++) {
+            workers.emplace_back([&] {
+                while (true) {
+                    const auto index = nextFile++;
+                    if (index >= files.size())
+                        break;
+
+                    bool failed = false;
+                    const auto line = getOutputLine(files[index], failed);
+                    if (failed)
+                        failedFiles += 1;
+
+                    std::scoped_lock lock(outputMutex);
+                    std::fputs(line.c_str(), stdout);
+                    std::fputc('\n', stdout);
+                    std::fflush(stdout);
+                }
+            });
+        }
+    }
+
+    const std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - startTime;
+    std::fprintf(stderr, "Analyzed %zu files (%zu failed) in %.2fs, %.1f files per minute\n",
+        files.size(), failedFiles.load(), wallTime.count(), wallTime.count() > 0 ? files.size() / wallTime.count() * 60 : 0.0);
+
+    const auto requests = hlp::RequestScheduler::getCounters();
+    std::fprintf(stderr, "Retried %llu requests, throttled %llu times\n", static_cast<unsigned long long>(requests.retried), static_cast<unsigned long long>(requests.throttled));
+
+    curl_global_cleanup();
+
+    return failedFiles == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,29 @@
+#include <helpers/address_map.hpp>
+
+namespace mal::hlp {
+
+    AddressMap AddressMap::fromProvider(hex::prv::Provider *provider) {
+        AddressMap result;
+        result.m_baseAddress = provider->getBaseAddress();
+        result.m_dataSize    = provider->getActualSize();
+        result.m_image       = ImageInfo::parse(SampleSource::fromProvider(provider));
+
+        return result;
+    }
+
+    std::optional<u64> AddressMap::toAddress(u64 virtualAddress) const {
+        if (this->m_image.format == ImageInfo::Format::Unknown) {
+            if (virtualAddress < this->m_baseAddress || virtualAddress - this->m_baseAddress >= this->m_dataSize)
+                return std::nullopt;
+
+            return virtualAddress;
+        }
+
+        const auto offset = this->m_image.toFileOffset(virtualAddress);
+        if (!offset.has_value() || *offset >= this->m_dataSize)
+            return std::nullopt;
+
+        return this->m_baseAddress + *offset;
+    }
+
+}
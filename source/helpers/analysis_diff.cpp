@@ -0,0 +1,308 @@
+#include <helpers/analysis_diff.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <span>
+#include <string_view>
+
+namespace mal::hlp {
+
+    namespace {
+
+        enum class Operation : u8 {
+            Equal,
+            Delete,
+            Insert
+        };
+
+        struct Edit {
+            Operation operation;
+            u32 left, right;
+        };
+
+        /**
+         * @brief Myers' O(ND) diff in linear space
+         * Ranges are split at the middle snake of their shortest edit script and handled one after the other. Ranges whose
+         * edit script gets too long are split at the furthest point reached instead, which trades a minimal script for a
+         * bounded run time on traces that have little in common
+         */
+        class SequenceDiff {
+        public:
+            SequenceDiff(std::span<const u64> left, std::span<const u64> right, std::stop_token stopToken)
+                : m_left(left), m_right(right), m_stopToken(stopToken) {
+                this->m_maxCost = std::max<i64>(MinCost, i64(std::sqrt(double(left.size() + right.size()))));
+            }
+
+            bool run() {
+                struct Range {
+                    u32 leftStart, leftEnd, rightStart, rightEnd;
+                    bool equal;
+                };
+
+                // Ranges are processed in order using an explicit stack, so unbalanced splits can't overflow the call stack
+                std::vector<Range> ranges = { { 0, u32(this->m_left.size()), 0, u32(this->m_right.size()), false } };
+                while (!ranges.empty()) {
+                    if (this->m_stopToken.stop_requested())
+                        return false;
+
+                    auto [leftStart, leftEnd, rightStart, rightEnd, equal] = ranges.back();
+                    ranges.pop_back();
+
+                    if (equal) {
+                        for (u32 i = 0; i < leftEnd - leftStart; i++)
+                            this->m_edits.push_back({ Operation::Equal, leftStart + i, rightStart + i });
+                        continue;
+                    }
+
+                    while (leftStart < leftEnd && rightStart < rightEnd && this->m_left[leftStart] == this->m_right[rightStart]) {
+                        this->m_edits.push_back({ Operation::Equal, leftStart, rightStart });
+                        leftStart += 1;
+                        rightStart += 1;
+                    }
+
+                    const auto suffixEnd = leftEnd;
+                    while (leftStart < leftEnd && rightStart < rightEnd && this->m_left[leftEnd - 1] == this->m_right[rightEnd - 1]) {
+                        leftEnd -= 1;
+                        rightEnd -= 1;
+                    }
+
+                    if (leftEnd != suffixEnd)
+                        ranges.push_back({ leftEnd, suffixEnd, rightEnd, rightEnd + (suffixEnd - leftEnd), true });
+
+                    const auto left  = this->m_left.subspan(leftStart, leftEnd - leftStart);
+                    const auto right = this->m_right.subspan(rightStart, rightEnd - rightStart);
+
+                    std::optional<std::pair<u32, u32>> split;
+                    if (!left.empty() && !right.empty())
+                        split = this->bisect(left, right);
+
+                    if (split.has_value()) {
+                        const auto [x, y] = *split;
+                        ranges.push_back({ leftStart + x, leftEnd, rightStart + y, rightEnd, false });
+                        ranges.push_back({ leftStart, leftStart + x, rightStart, rightStart + y, false });
+                    } else {
+                        for (auto i = leftStart; i < leftEnd; i++)
+                            this->m_edits.push_back({ Operation::Delete, i, AnalysisDiff::NoCall });
+                        for (auto i = rightStart; i < rightEnd; i++)
+                            this->m_edits.push_back({ Operation::Insert, AnalysisDiff::NoCall, i });
+                    }
+                }
+
+                return true;
+            }
+
+            [[nodiscard]] const std::vector<Edit> &getEdits() const {
+                return this->m_edits;
+            }
+
+        private:
+            /**
+             * @brief Finds the point to split two ranges at
+             * @return Split point relative to the start of both ranges or std::nullopt if the ranges can't be split
+             */
+            std::optional<std::pair<u32, u32>> bisect(std::span<const u64> left, std::span<const u64> right) const {
+                const i64 n = left.size(), m = right.size();
+                const i64 maxD = std::min<i64>((n + m + 1) / 2, this->m_maxCost);
+                const i64 offset = maxD + 1;
+                const i64 length = 2 * offset + 1;
+
+                // Furthest reaching x of every diagonal, searching forwards from the start and backwards from the end
+                std::vector<i64> forward(length, -1), backward(length, -1);
+                forward[offset + 1]  = 0;
+                backward[offset + 1] = 0;
+
+                const i64 delta = n - m;
+                const bool checkForward = delta % 2 != 0;
+
+                auto validSplit = [n, m](i64 x, i64 y) -> std::optional<std::pair<u32, u32>> {
+                    if (x < 0 || y < 0 || x > n || y > m || x + y == 0 || x + y == n + m)
+                        return std::nullopt;
+
+                    return std::pair { u32(x), u32(y) };
+                };
+
+                i64 forwardStart = 0, forwardEnd = 0, backwardStart = 0, backwardEnd = 0;
+                for (i64 d = 0; d < maxD; d++) {
+                    for (i64 k = -d + forwardStart; k <= d - forwardEnd; k += 2) {
+                        const auto index = offset + k;
+                        i64 x = (k == -d || (k != d && forward[index - 1] < forward[index + 1])) ? forward[index + 1] : forward[index - 1] + 1;
+                        i64 y = x - k;
+                        while (x < n && y < m && left[x] == right[y]) {
+                            x += 1;
+                            y += 1;
+                        }
+                        forward[index] = x;
+
+                        if (x > n) {
+                            forwardEnd += 2;
+                        } else if (y > m) {
+                            forwardStart += 2;
+                        } else if (checkForward) {
+                            const auto backwardIndex = offset + delta - k;
+                            if (backwardIndex >= 0 && backwardIndex < length && backward[backwardIndex] != -1 && x >= n - backward[backwardIndex])
+                                return validSplit(x, y);
+                        }
+                    }
+
+                    for (i64 k = -d + backwardStart; k <= d - backwardEnd; k += 2) {
+                        const auto index = offset + k;
+                        i64 x = (k == -d || (k != d && backward[index - 1] < backward[index + 1])) ? backward[index + 1] : backward[index - 1] + 1;
+                        i64 y = x - k;
+                        while (x < n && y < m && left[n - x - 1] == right[m - y - 1]) {
+                            x += 1;
+                            y += 1;
+                        }
+                        backward[index] = x;
+
+                        if (x > n) {
+                            backwardEnd += 2;
+                        } else if (y > m) {
+                            backwardStart += 2;
+                        } else if (!checkForward) {
+                            const auto forwardIndex = offset + delta - k;
+                            if (forwardIndex >= 0 && forwardIndex < length && forward[forwardIndex] != -1) {
+                                const auto forwardX = forward[forwardIndex];
+                                if (forwardX >= n - x)
+                                    return validSplit(forwardX, forwardX - (forwardIndex - offset));
+                            }
+                        }
+                    }
+                }
+
+                // Too expensive to find the middle snake, split at the point the forward search got furthest to instead
+                std::optional<std::pair<u32, u32>> best;
+                i64 bestProgress = 0;
+                for (i64 index = 0; index < length; index++) {
+                    const auto x = forward[index];
+                    const auto y = x - (index - offset);
+                    if (x < 0 || x + y <= bestProgress)
+                        continue;
+
+                    if (auto split = validSplit(x, y); split.has_value()) {
+                        best = split;
+                        bestProgress = x + y;
+                    }
+                }
+
+                return best;
+            }
+
+        private:
+            constexpr static i64 MinCost = 256;
+
+            std::span<const u64> m_left, m_right;
+            std::stop_token m_stopToken;
+            i64 m_maxCost;
+
+            std::vector<Edit> m_edits;
+        };
+
+        /**
+         * @brief Token of a call's name and argument shape, independent of the string pool it came from
+         */
+        std::vector<u64> tokenize(const MalcoreApi::DynamicAnalysisResult &trace, const StringPool &strings) {
+            auto combine = [](u64 seed, u64 value) {
+                return seed ^ (value + 0x9E37'79B9'7F4A'7C15 + (seed << 6) + (seed >> 2));
+            };
+
+            std::vector<u64> tokens;
+            tokens.reserve(trace.apis.size());
+            for (const auto &api : trace.apis) {
+                auto token = combine(std::hash<std::string_view>()(strings.get(api.apiName)), api.argumentCount);
+                for (const auto &argument : trace.getArguments(api))
+                    token = combine(token, argument.isNumber);
+
+                tokens.push_back(token);
+            }
+
+            return tokens;
+        }
+
+        AnalysisDiff::RowType compareCalls(const MalcoreApi::DynamicAnalysisResult &left, const StringPool &leftStrings, u32 leftIndex, const MalcoreApi::DynamicAnalysisResult &right, const StringPool &rightStrings, u32 rightIndex) {
+            const auto &leftApi  = left.apis[leftIndex];
+            const auto &rightApi = right.apis[rightIndex];
+
+            const auto leftArguments  = left.getArguments(leftApi);
+            const auto rightArguments = right.getArguments(rightApi);
+
+            // Tokens are only hashes, make sure the calls really have the same shape
+            if (leftStrings.get(leftApi.apiName) != rightStrings.get(rightApi.apiName) || leftArguments.size() != rightArguments.size())
+                return AnalysisDiff::RowType::Replaced;
+
+            bool changed = leftStrings.get(leftApi.returnValue) != rightStrings.get(rightApi.returnValue);
+            for (size_t i = 0; i < leftArguments.size(); i++) {
+                if (leftArguments[i].isNumber != rightArguments[i].isNumber)
+                    return AnalysisDiff::RowType::Replaced;
+
+                changed |= leftStrings.get(leftArguments[i].value) != rightStrings.get(rightArguments[i].value);
+            }
+
+            return changed ? AnalysisDiff::RowType::Changed : AnalysisDiff::RowType::Equal;
+        }
+
+    }
+
+    AnalysisDiff::SetDiff AnalysisDiff::compareSets(std::vector<std::string> left, std::vector<std::string> right) {
+        for (auto *strings : { &left, &right }) {
+            std::sort(strings->begin(), strings->end());
+            strings->erase(std::unique(strings->begin(), strings->end()), strings->end());
+        }
+
+        SetDiff result;
+        std::set_difference(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(result.removed));
+        std::set_difference(right.begin(), right.end(), left.begin(), left.end(), std::back_inserter(result.added));
+        result.common = left.size() - result.removed.size();
+
+        return result;
+    }
+
+    std::optional<AnalysisDiff::TraceDiff> AnalysisDiff::compareTraces(const MalcoreApi::DynamicAnalysisResult &left, const StringPool &leftStrings, const MalcoreApi::DynamicAnalysisResult &right, const StringPool &rightStrings, std::stop_token stopToken) {
+        const auto leftTokens  = tokenize(left, leftStrings);
+        const auto rightTokens = tokenize(right, rightStrings);
+
+        SequenceDiff diff(leftTokens, rightTokens, stopToken);
+        if (!diff.run())
+            return std::nullopt;
+
+        TraceDiff result;
+        auto addRow = [&result](RowType type, u32 leftIndex, u32 rightIndex) {
+            result.rows.push_back({ type, leftIndex, rightIndex });
+            result.counts[u8(type)] += 1;
+        };
+
+        // Calls removed and inserted at the same place are shown next to each other
+        std::vector<u32> removed, inserted;
+        auto flush = [&] {
+            const auto paired = std::min(removed.size(), inserted.size());
+            for (size_t i = 0; i < paired; i++)
+                addRow(RowType::Replaced, removed[i], inserted[i]);
+            for (size_t i = paired; i < removed.size(); i++)
+                addRow(RowType::Removed, removed[i], NoCall);
+            for (size_t i = paired; i < inserted.size(); i++)
+                addRow(RowType::Inserted, NoCall, inserted[i]);
+
+            removed.clear();
+            inserted.clear();
+        };
+
+        for (const auto &[operation, leftIndex, rightIndex] : diff.getEdits()) {
+            switch (operation) {
+                case Operation::Delete:
+                    removed.push_back(leftIndex);
+                    break;
+                case Operation::Insert:
+                    inserted.push_back(rightIndex);
+                    break;
+                case Operation::Equal:
+                    flush();
+                    addRow(compareCalls(left, leftStrings, leftIndex, right, rightStrings, rightIndex), leftIndex, rightIndex);
+                    break;
+            }
+        }
+        flush();
+
+        return result;
+    }
+
+}
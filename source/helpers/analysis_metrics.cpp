@@ -0,0 +1,51 @@
+#include <helpers/analysis_metrics.hpp>
+
+namespace mal::hlp {
+
+    std::string_view AnalysisMetrics::getPhaseName(Phase phase) {
+        using enum Phase;
+        switch (phase) {
+            case Hash:          return "hash";
+            case CacheLookup:   return "cache_lookup";
+            case HashLookup:    return "hash_lookup";
+            case Compression:   return "compression";
+            case Upload:        return "upload";
+            case Poll:          return "poll";
+            case Queue:         return "queue";
+            case Parse:         return "parse";
+            case LocateStrings: return "locate_strings";
+            case Annotate:      return "annotate";
+            case Count:         break;
+        }
+
+        return "unknown";
+    }
+
+    nlohmann::json AnalysisMetrics::toJson() const {
+        nlohmann::json durations = nlohmann::json::object();
+        for (size_t phase = 0; phase < size_t(Phase::Count); phase++)
+            durations[getPhaseName(Phase(phase))] = this->durations[phase].count();
+
+        return {
+            { "durations", durations },
+            { "total", this->getTotal().count() },
+            { "time_to_first_result", this->timeToFirstResult.count() },
+            { "transfer", {
+                { "sample_size", this->sampleSize },
+                { "bytes_sent", this->bytesSent },
+                { "bytes_received", this->bytesReceived },
+                { "poll_count", this->pollCount }
+            } },
+            { "result", {
+                { "status_size", this->statusSize },
+                { "signatures", this->signatureCount },
+                { "api_calls", this->apiCallCount },
+                { "pooled_strings", this->pooledStringCount },
+                { "stored_trace_size", this->storedTraceSize },
+                { "string_matches", this->stringMatchCount },
+                { "annotations", this->annotationCount }
+            } }
+        };
+    }
+
+}
@@ -0,0 +1,264 @@
+#include <helpers/analysis_runner.hpp>
+
+#include <helpers/malcore_api.hpp>
+#include <helpers/poll_scheduler.hpp>
+#include <helpers/result_cache.hpp>
+#include <helpers/status_parser.hpp>
+
+#include <hex/helpers/crypto.hpp>
+#include <hex/helpers/logger.hpp>
+
+#include <condition_variable>
+#include <mutex>
+
+namespace mal::hlp {
+
+    AnalysisRunner::Result AnalysisRunner::run(const SampleSource &sample, std::stop_token stopToken, RequestScheduler::Priority priority) {
+        const auto startTime = std::chrono::steady_clock::now();
+
+        // Phases that happen locally are measured separately, a shared analysis only brings along the remote ones
+        AnalysisMetrics localMetrics;
+
+        const auto uploadLimit = MalcoreApi::getUploadLimit();
+        const auto calculatedDigest = [&] {
+            auto timer = localMetrics.measure(AnalysisMetrics::Phase::Hash);
+            return sample.calculateDigest(uploadLimit, stopToken);
+        }();
+
+        if (!calculatedDigest.has_value()) {
+            Result result;
+            result.error    = Error::Cancelled;
+            result.metrics  = localMetrics;
+            result.duration = std::chrono::steady_clock::now() - startTime;
+            return result;
+        }
+
+        const auto &digest = *calculatedDigest;
+        const auto digestString = hex::crypt::encode16({ digest.begin(), digest.end() });
+
+        auto cached = [&] {
+            auto timer = localMetrics.measure(AnalysisMetrics::Phase::CacheLookup);
+            return ResultCache::get(digest, uploadLimit);
+        }();
+
+        if (cached.has_value()) {
+            hex::log::info("Using cached Malcore analysis of {}", hex::crypt::encode16({ cached->hash.begin(), cached->hash.end() }));
+
+            Result result;
+            result.digest   = digest;
+            result.hash     = cached->hash;
+            result.origin   = Origin::Cache;
+            result.metrics  = localMetrics;
+            result.metrics.sampleSize = sample.getSize();
+            result.metrics.statusSize = cached->status.size();
+            result.status   = std::move(cached->status);
+            result.duration = std::chrono::steady_clock::now() - startTime;
+            return result;
+        }
+
+        // Join the analysis of the same content if one is already running, otherwise become the one running it
+        std::shared_ptr<Flight> flight;
+        bool leader = false;
+        {
+            std::scoped_lock lock(s_flightsMutex);
+
+            auto &entry = s_flights[digest];
+            if (entry == nullptr || entry->stopSource.stop_requested()) {
+                entry = std::make_shared<Flight>();
+                leader = true;
+            }
+
+            flight = entry;
+
+            std::scoped_lock flightLock(flight->mutex);
+            flight->participants += 1;
+        }
+
+        // A cancelled leader keeps the shared analysis going as long as anybody else is still waiting for it
+        std::stop_callback leaveOnStop(stopToken, [&flight] { leave(*flight); });
+
+        Result result;
+        if (leader) {
+            result = analyze(sample, digest, priority, flight->stopSource.get_token());
+
+            {
+                std::scoped_lock lock(s_flightsMutex);
+                if (auto it = s_flights.find(digest); it != s_flights.end() && it->second == flight)
+                    s_flights.erase(it);
+            }
+
+            {
+                std::scoped_lock lock(flight->mutex);
+                flight->result = result;
+            }
+            flight->finished.notify_all();
+        } else {
+            hex::log::info("Joining the running Malcore analysis of content {}", digestString);
+
+            std::unique_lock lock(flight->mutex);
+            flight->finished.wait(lock, stopToken, [&flight] { return flight->result.has_value(); });
+
+            if (flight->result.has_value()) {
+                result = *flight->result;
+                result.shared = true;
+            }
+        }
+
+        if (stopToken.stop_requested()) {
+            result.digest = digest;
+            result.status.reset();
+            result.error  = Error::Cancelled;
+        }
+
+        result.metrics.add(AnalysisMetrics::Phase::Hash, localMetrics.get(AnalysisMetrics::Phase::Hash));
+        result.metrics.add(AnalysisMetrics::Phase::CacheLookup, localMetrics.get(AnalysisMetrics::Phase::CacheLookup));
+        result.metrics.sampleSize = sample.getSize();
+
+        result.duration = std::chrono::steady_clock::now() - startTime;
+
+        if (result.error == Error::None) {
+            const auto bandwidth = result.getUploadBandwidth();
+            if (result.shared)
+                hex::log::info("Malcore analysis of '{}' took {:.2f}s, shared with a concurrent analysis of the same content", sample.getName(), result.duration.count());
+            else if (bandwidth.has_value())
+                hex::log::info("Malcore analysis of '{}' took {:.2f}s, uploaded {} bytes at {:.2f} MiB/s", sample.getName(), result.duration.count(), result.metrics.bytesSent, *bandwidth / 1_MiB);
+            else
+                hex::log::info("Malcore analysis of '{}' took {:.2f}s without uploading anything", sample.getName(), result.duration.count());
+        }
+
+        return result;
+    }
+
+    void AnalysisRunner::leave(Flight &flight) {
+        std::scoped_lock lock(flight.mutex);
+
+        flight.participants -= 1;
+        if (flight.participants == 0)
+            flight.stopSource.request_stop();
+    }
+
+    AnalysisRunner::Result AnalysisRunner::analyze(const SampleSource &sample, const SampleSource::Hash &digest, RequestScheduler::Priority priority, std::stop_token stopToken) {
+        Result result;
+        result.digest = digest;
+
+        const auto uploadLimit = MalcoreApi::getUploadLimit();
+        auto &metrics = result.metrics;
+
+        // Results are identified by their SHA-256, which can't be derived from the digest. Samples that already know it answer it
+        // without reading the data again, everything else has it calculated over the whole sample
+        result.hash = [&] {
+            auto timer = metrics.measure(AnalysisMetrics::Phase::Hash);
+            return sample.calculateHash(uploadLimit);
+        }();
+        const auto hashString = hex::crypt::encode16({ result.hash.begin(), result.hash.end() });
+
+        // A report of the same content may already exist, in which case there's no need to send the sample at all.
+        // Lookups cost a request of their own, so they're only made if they're enabled and the service supports them
+        std::optional<std::string> known;
+        if (MalcoreApi::shouldLookupHashes(priority, stopToken)) {
+            auto timer = metrics.measure(AnalysisMetrics::Phase::HashLookup);
+            known = MalcoreApi::lookupHash(hashString, priority, stopToken);
+        }
+
+        if (known.has_value())
+            metrics.bytesReceived += known->size();
+
+        if (known.has_value() && StatusParser::isFinished(*known) == true) {
+            hex::log::info("Malcore already has a report of {}, skipping the upload", hashString);
+
+            ResultCache::store(digest, uploadLimit, result.hash, *known);
+
+            metrics.statusSize = known->size();
+            result.status = std::move(known);
+            result.origin = Origin::Lookup;
+            return result;
+        }
+
+        if (stopToken.stop_requested()) {
+            result.error = Error::Cancelled;
+            return result;
+        }
+
+        const auto upload = MalcoreApi::uploadSample(sample, stopToken, priority);
+        const auto &uuid  = upload.uuid;
+
+        // Compressed payloads are produced while they're sent, the upload phase only gets the time that wasn't spent compressing
+        metrics.add(AnalysisMetrics::Phase::Compression, upload.compressionDuration);
+        metrics.add(AnalysisMetrics::Phase::Upload, upload.duration - upload.compressionDuration);
+        metrics.bytesSent += upload.bytesSent;
+
+        if (stopToken.stop_requested()) {
+            result.error = Error::Cancelled;
+            return result;
+        }
+
+        if (!uuid.has_value()) {
+            result.error = Error::UploadFailed;
+            return result;
+        }
+
+        result.compressionRatio = upload.compressionRatio;
+        result.uploadTimeSaved  = upload.timeSaved;
+
+        std::mutex mutex;
+        std::condition_variable_any wakeUp;
+
+        PollScheduler scheduler;
+        while (true) {
+            auto status = [&] {
+                auto timer = metrics.measure(AnalysisMetrics::Phase::Poll);
+                return MalcoreApi::getAnalysisStatus(*uuid, priority, stopToken);
+            }();
+
+            metrics.pollCount += 1;
+            if (!status.has_value()) {
+                result.error = Error::StatusFailed;
+                return result;
+            }
+
+            metrics.bytesReceived += status->size();
+
+            const auto finished = StatusParser::isFinished(*status);
+            if (!finished.has_value()) {
+                result.error = Error::StatusFailed;
+                return result;
+            }
+
+            if (*finished) {
+                hex::log::info("Malcore analysis of '{}' finished after {:.2f}s and {} polls", sample.getName(), scheduler.getElapsedTime().count(), scheduler.getPollCount() + 1);
+
+                ResultCache::store(digest, uploadLimit, result.hash, *status);
+
+                metrics.statusSize = status->size();
+                result.status = std::move(status);
+                return result;
+            }
+
+            // Full status responses can get huge, so they're only dumped when asked for
+            if (s_debugLogging)
+                hex::log::debug("{}", *status);
+
+            auto delay = scheduler.next();
+            if (!delay.has_value()) {
+                hex::log::error("Malcore analysis of '{}' timed out after {:.2f}s and {} polls", sample.getName(), scheduler.getElapsedTime().count(), scheduler.getPollCount());
+
+                result.error = Error::TimedOut;
+                return result;
+            }
+
+            // Wait for the next poll, but wake up right away if the analysis gets cancelled
+            {
+                auto timer = metrics.measure(AnalysisMetrics::Phase::Queue);
+
+                std::unique_lock lock(mutex);
+                wakeUp.wait_for(lock, stopToken, *delay, [] { return false; });
+            }
+
+            if (stopToken.stop_requested()) {
+                result.error = Error::Cancelled;
+                return result;
+            }
+        }
+    }
+
+}
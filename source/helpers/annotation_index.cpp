@@ -0,0 +1,96 @@
+#include <helpers/annotation_index.hpp>
+
+#include <algorithm>
+
+namespace mal::hlp {
+
+    void AnnotationIndex::add(hex::Region region, color_t color, std::string label) {
+        if (region.getSize() == 0)
+            return;
+
+        this->m_annotations.push_back({ region, color, std::move(label) });
+    }
+
+    void AnnotationIndex::build() {
+        this->m_segmentStarts.clear();
+        this->m_segmentEnds.clear();
+        this->m_segmentOffsets.clear();
+        this->m_segmentAnnotations.clear();
+
+        struct Event {
+            u64 address;
+            bool isStart;
+            u32 id;
+        };
+
+        std::vector<Event> events;
+        events.reserve(this->m_annotations.size() * 2);
+        for (u32 id = 0; id < this->m_annotations.size(); id++) {
+            const auto &region = this->m_annotations[id].region;
+            events.push_back({ region.getStartAddress(), true, id });
+            events.push_back({ region.getStartAddress() + region.getSize(), false, id });
+        }
+
+        std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+            return a.address < b.address;
+        });
+
+        // Sweep over all region boundaries and emit one segment for every stretch covered by the same set of annotations
+        std::vector<u32> active;
+        for (size_t i = 0; i < events.size();) {
+            const auto address = events[i].address;
+            for (; i < events.size() && events[i].address == address; i++) {
+                if (events[i].isStart)
+                    active.insert(std::upper_bound(active.begin(), active.end(), events[i].id), events[i].id);
+                else
+                    active.erase(std::lower_bound(active.begin(), active.end(), events[i].id));
+            }
+
+            if (active.empty() || i == events.size())
+                continue;
+
+            this->m_segmentStarts.push_back(address);
+            this->m_segmentEnds.push_back(events[i].address);
+            this->m_segmentOffsets.push_back(this->m_segmentAnnotations.size());
+            this->m_segmentAnnotations.insert(this->m_segmentAnnotations.end(), active.begin(), active.end());
+        }
+        this->m_segmentOffsets.push_back(this->m_segmentAnnotations.size());
+
+        this->m_segmentStarts.shrink_to_fit();
+        this->m_segmentEnds.shrink_to_fit();
+        this->m_segmentOffsets.shrink_to_fit();
+        this->m_segmentAnnotations.shrink_to_fit();
+    }
+
+    std::optional<size_t> AnnotationIndex::findSegment(u64 address) const {
+        auto it = std::upper_bound(this->m_segmentStarts.begin(), this->m_segmentStarts.end(), address);
+        if (it == this->m_segmentStarts.begin())
+            return std::nullopt;
+
+        const auto segment = size_t(std::distance(this->m_segmentStarts.begin(), it) - 1);
+        if (address >= this->m_segmentEnds[segment])
+            return std::nullopt;
+
+        return segment;
+    }
+
+    std::span<const u32> AnnotationIndex::find(u64 address) const {
+        const auto segment = this->findSegment(address);
+        if (!segment.has_value())
+            return { };
+
+        const auto begin = this->m_segmentOffsets[*segment];
+        const auto end   = this->m_segmentOffsets[*segment + 1];
+
+        return std::span(this->m_segmentAnnotations).subspan(begin, end - begin);
+    }
+
+    std::optional<color_t> AnnotationIndex::getColor(u64 address) const {
+        const auto annotations = this->find(address);
+        if (annotations.empty())
+            return std::nullopt;
+
+        return this->m_annotations[annotations.front()].color;
+    }
+
+}
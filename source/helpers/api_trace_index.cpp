@@ -0,0 +1,129 @@
+#include <helpers/api_trace_index.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace mal::hlp {
+
+    namespace {
+
+        bool containsIgnoreCase(std::string_view haystack, std::string_view needle) {
+            auto it = std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(), [](char a, char b) {
+                return std::tolower(u8(a)) == std::tolower(u8(b));
+            });
+
+            return it != haystack.end() || needle.empty();
+        }
+
+    }
+
+    ApiTraceIndex::ApiTraceIndex(const MalcoreApi::DynamicAnalysisResult &trace, const StringPool &strings) {
+        const auto &apis = trace.apis;
+
+        // API names are already interned in the string pool, map them to dense ids local to this trace
+        std::unordered_map<StringPool::Id, u32> nameIds;
+
+        this->m_nameIds.reserve(apis.size());
+        for (u32 row = 0; row < apis.size(); row++) {
+            const auto name = apis[row].apiName;
+
+            auto [it, inserted] = nameIds.try_emplace(name, this->m_names.size());
+            if (inserted) {
+                this->m_names.push_back(name);
+                this->m_postings.emplace_back();
+            }
+
+            this->m_nameIds.push_back(it->second);
+            this->m_postings[it->second].push_back(row);
+        }
+
+        // Rank the interned names alphabetically so sorting by name only needs to compare integers
+        std::vector<u32> nameOrder(this->m_names.size());
+        std::iota(nameOrder.begin(), nameOrder.end(), 0);
+        std::sort(nameOrder.begin(), nameOrder.end(), [this, &strings](u32 a, u32 b) {
+            return strings.get(this->m_names[a]) < strings.get(this->m_names[b]);
+        });
+
+        this->m_nameRanks.resize(this->m_names.size());
+        for (u32 rank = 0; rank < nameOrder.size(); rank++)
+            this->m_nameRanks[nameOrder[rank]] = rank;
+
+        this->m_pcOrder.resize(apis.size());
+        std::iota(this->m_pcOrder.begin(), this->m_pcOrder.end(), 0);
+        std::stable_sort(this->m_pcOrder.begin(), this->m_pcOrder.end(), [&apis](u32 a, u32 b) {
+            return apis[a].pcValue < apis[b].pcValue;
+        });
+
+        this->m_sortedPcs.reserve(apis.size());
+        for (auto row : this->m_pcOrder)
+            this->m_sortedPcs.push_back(apis[row].pcValue);
+    }
+
+    std::vector<u32> ApiTraceIndex::query(const MalcoreApi::DynamicAnalysisResult &trace, const StringPool &strings, const Filter &filter, SortColumn column, bool ascending) const {
+        const auto &apis = trace.apis;
+
+        const auto pcStart = filter.pcStart.value_or(0x00);
+        const auto pcEnd   = filter.pcEnd.value_or(std::numeric_limits<u64>::max());
+        const bool hasPcRange = filter.pcStart.has_value() || filter.pcEnd.has_value();
+
+        std::vector<u32> rows;
+        if (!filter.name.empty()) {
+            // Only the distinct names need to be matched, the posting lists then yield the calls directly
+            for (u32 id = 0; id < this->m_names.size(); id++) {
+                if (containsIgnoreCase(strings.get(this->m_names[id]), filter.name))
+                    rows.insert(rows.end(), this->m_postings[id].begin(), this->m_postings[id].end());
+            }
+            std::sort(rows.begin(), rows.end());
+
+            if (hasPcRange) {
+                std::erase_if(rows, [&](u32 row) {
+                    return apis[row].pcValue < pcStart || apis[row].pcValue > pcEnd;
+                });
+            }
+        } else if (hasPcRange) {
+            auto begin = std::lower_bound(this->m_sortedPcs.begin(), this->m_sortedPcs.end(), pcStart);
+            auto end   = std::upper_bound(begin, this->m_sortedPcs.end(), pcEnd);
+
+            rows.assign(this->m_pcOrder.begin() + (begin - this->m_sortedPcs.begin()), this->m_pcOrder.begin() + (end - this->m_sortedPcs.begin()));
+            std::sort(rows.begin(), rows.end());
+        } else {
+            rows.resize(apis.size());
+            std::iota(rows.begin(), rows.end(), 0);
+        }
+
+        if (!filter.argument.empty()) {
+            std::erase_if(rows, [&](u32 row) {
+                const auto &api = apis[row];
+                const auto arguments = trace.getArguments(api);
+
+                return std::none_of(arguments.begin(), arguments.end(), [&](const MalcoreApi::Argument &argument) {
+                    return containsIgnoreCase(strings.get(argument.value), filter.argument);
+                }) && !containsIgnoreCase(strings.get(api.returnValue), filter.argument);
+            });
+        }
+
+        switch (column) {
+            case SortColumn::Index:
+                break;
+            case SortColumn::Pc:
+                std::stable_sort(rows.begin(), rows.end(), [&apis](u32 a, u32 b) {
+                    return apis[a].pcValue < apis[b].pcValue;
+                });
+                break;
+            case SortColumn::Name:
+                std::stable_sort(rows.begin(), rows.end(), [this](u32 a, u32 b) {
+                    return this->m_nameRanks[this->m_nameIds[a]] < this->m_nameRanks[this->m_nameIds[b]];
+                });
+                break;
+        }
+
+        if (!ascending)
+            std::reverse(rows.begin(), rows.end());
+
+        return rows;
+    }
+
+}
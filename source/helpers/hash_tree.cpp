@@ -0,0 +1,178 @@
+#include <helpers/hash_tree.hpp>
+#include <helpers/worker_pool.hpp>
+
+#include <mbedtls/sha256.h>
+#include <mbedtls/version.h>
+
+#include <algorithm>
+#include <atomic>
+#include <span>
+
+#if MBEDTLS_VERSION_MAJOR <= 2
+    #define mbedtls_sha256_starts mbedtls_sha256_starts_ret
+    #define mbedtls_sha256_update mbedtls_sha256_update_ret
+    #define mbedtls_sha256_finish mbedtls_sha256_finish_ret
+#endif
+
+namespace mal::hlp {
+
+    namespace {
+
+        // Leaves, inner nodes and the root are hashed with different prefixes so none of them can be passed off as another
+        enum NodeType : u8 {
+            Leaf  = 0x00,
+            Inner = 0x01,
+            Root  = 0x02
+        };
+
+        HashTree::Hash hashNode(NodeType type, std::initializer_list<std::span<const u8>> parts) {
+            HashTree::Hash result = { };
+
+            mbedtls_sha256_context ctx;
+            mbedtls_sha256_init(&ctx);
+            mbedtls_sha256_starts(&ctx, 0);
+
+            const u8 prefix = type;
+            mbedtls_sha256_update(&ctx, &prefix, sizeof(prefix));
+            for (const auto &part : parts)
+                mbedtls_sha256_update(&ctx, part.data(), part.size());
+
+            mbedtls_sha256_finish(&ctx, result.data());
+            mbedtls_sha256_free(&ctx);
+
+            return result;
+        }
+
+        HashTree::Hash hashParent(const std::vector<HashTree::Hash> &level, u64 index) {
+            const auto left = index * 2, right = left + 1;
+
+            // Odd nodes at the end of a level are carried up unchanged
+            if (right >= level.size())
+                return level[left];
+
+            return hashNode(Inner, { level[left], level[right] });
+        }
+
+    }
+
+    void HashTree::invalidate(u64 offset, u64 size) {
+        if (offset >= this->m_size || size == 0)
+            return;
+
+        const auto firstChunk = offset / ChunkSize;
+        const auto lastChunk  = (std::min(size, this->m_size - offset) + offset - 1) / ChunkSize;
+        for (auto chunk = firstChunk; chunk <= lastChunk; chunk++) {
+            if (this->m_dirty[chunk])
+                continue;
+
+            this->m_dirty[chunk] = true;
+            this->m_dirtyChunks.push_back(chunk);
+        }
+    }
+
+    void HashTree::resize(u64 size) {
+        if (size == this->m_size)
+            return;
+
+        const auto oldSize = this->m_size;
+        const auto chunkCount = (size + ChunkSize - 1) / ChunkSize;
+
+        this->m_size = size;
+        this->m_levels[0].resize(chunkCount);
+        this->m_dirty.resize(chunkCount);
+        std::erase_if(this->m_dirtyChunks, [chunkCount](u64 chunk) { return chunk >= chunkCount; });
+
+        // The chunk holding the old end either grew, shrank or is gone entirely, everything after it is new
+        const auto boundary = std::min(oldSize, size);
+        this->invalidate(boundary - boundary % ChunkSize, size);
+
+        this->m_rebuild = true;
+    }
+
+    bool HashTree::update(const SampleSource &sample, std::stop_token stopToken) {
+        if (!this->isDirty())
+            return true;
+
+        auto &leaves = this->m_levels[0];
+
+        // A resize can require a rebuild without leaving any chunks to rehash
+        if (!this->m_dirtyChunks.empty()) {
+            std::atomic<u64> nextChunk = 0;
+
+            const auto workerCount = std::min<u64>(WorkerPool::getConcurrency(), this->m_dirtyChunks.size());
+            WorkerPool::run(workerCount, [&](u32) {
+                std::vector<u8> buffer;
+
+                while (!stopToken.stop_requested()) {
+                    const auto index = nextChunk++;
+                    if (index >= this->m_dirtyChunks.size())
+                        break;
+
+                    const auto chunk  = this->m_dirtyChunks[index];
+                    const auto offset = chunk * ChunkSize;
+                    buffer.resize(std::min<u64>(ChunkSize, this->m_size - offset));
+                    sample.read(offset, buffer.data(), buffer.size());
+
+                    leaves[chunk] = hashNode(Leaf, { buffer });
+                }
+            });
+        }
+
+        if (stopToken.stop_requested())
+            return false;
+
+        for (const auto chunk : this->m_dirtyChunks)
+            this->m_dirty[chunk] = false;
+
+        if (this->m_rebuild)
+            this->rebuildLevels();
+        else
+            this->propagate(std::move(this->m_dirtyChunks));
+
+        this->m_dirtyChunks.clear();
+        this->m_rebuild = false;
+
+        this->updateRoot();
+
+        return true;
+    }
+
+    void HashTree::rebuildLevels() {
+        this->m_levels.resize(1);
+
+        while (this->m_levels.back().size() > 1) {
+            const auto &level = this->m_levels.back();
+
+            std::vector<Hash> parents((level.size() + 1) / 2);
+            for (u64 i = 0; i < parents.size(); i++)
+                parents[i] = hashParent(level, i);
+
+            this->m_levels.push_back(std::move(parents));
+        }
+    }
+
+    void HashTree::propagate(std::vector<u64> indices) {
+        std::sort(indices.begin(), indices.end());
+
+        for (size_t level = 0; level + 1 < this->m_levels.size(); level++) {
+            for (auto &index : indices)
+                index /= 2;
+            indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+            for (const auto index : indices)
+                this->m_levels[level + 1][index] = hashParent(this->m_levels[level], index);
+        }
+    }
+
+    void HashTree::updateRoot() {
+        std::array<u8, sizeof(u64)> size = { };
+        for (size_t i = 0; i < size.size(); i++)
+            size[i] = u8(this->m_size >> (i * 8));
+
+        const auto &top = this->m_levels.back();
+        const Hash empty = { };
+
+        this->m_root = hashNode(Root, { size, top.empty() ? empty : top.front() });
+    }
+
+}
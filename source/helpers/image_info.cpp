@@ -0,0 +1,182 @@
+#include <helpers/image_info.hpp>
+
+#include <hex/helpers/fmt.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace mal::hlp {
+
+    namespace {
+
+        template<typename T>
+        T readValue(const SampleSource &sample, u64 offset) {
+            T value = { };
+            if (offset + sizeof(T) <= sample.getSize())
+                sample.read(offset, reinterpret_cast<u8*>(&value), sizeof(T));
+
+            return value;
+        }
+
+        std::string readString(const SampleSource &sample, u64 offset, size_t maxSize) {
+            std::string result(std::min<u64>(maxSize, offset < sample.getSize() ? sample.getSize() - offset : 0), '\x00');
+            sample.read(offset, reinterpret_cast<u8*>(result.data()), result.size());
+
+            result.resize(std::strlen(result.c_str()));
+            return result;
+        }
+
+        void parsePE(const SampleSource &sample, ImageInfo &info) {
+            const u64 peHeader = readValue<u32>(sample, 0x3C);
+            if (readValue<u32>(sample, peHeader) != 0x0000'4550)
+                return;
+
+            const auto machine            = readValue<u16>(sample, peHeader + 0x04);
+            const auto sectionCount       = readValue<u16>(sample, peHeader + 0x06);
+            const auto optionalHeaderSize = readValue<u16>(sample, peHeader + 0x14);
+            const auto characteristics    = readValue<u16>(sample, peHeader + 0x16);
+            const auto optionalHeader     = peHeader + 0x18;
+
+            switch (readValue<u16>(sample, optionalHeader)) {
+                case 0x10B:
+                    info.imageBase = readValue<u32>(sample, optionalHeader + 0x1C);
+                    break;
+                case 0x20B:
+                    info.imageBase = readValue<u64>(sample, optionalHeader + 0x18);
+                    info.is64Bit = true;
+                    break;
+                default:
+                    return;
+            }
+
+            info.format     = ImageInfo::Format::PE;
+            info.type       = (characteristics & 0x2000) != 0 ? "DLL" : "EXE";
+            info.entryPoint = info.imageBase + readValue<u32>(sample, optionalHeader + 0x10);
+            info.timestamp  = readValue<u32>(sample, peHeader + 0x08);
+
+            switch (machine) {
+                case 0x014C: info.machine = "x86";      break;
+                case 0x8664: info.machine = "x86-64";   break;
+                case 0x01C4: info.machine = "ARM";      break;
+                case 0xAA64: info.machine = "AArch64";  break;
+                default:     info.machine = hex::format("0x{:04X}", machine); break;
+            }
+
+            const auto sectionTable = optionalHeader + optionalHeaderSize;
+            for (u16 i = 0; i < sectionCount; i++) {
+                const auto header = sectionTable + i * 0x28;
+                if (header + 0x28 > sample.getSize())
+                    break;
+
+                ImageInfo::Section section;
+                section.name           = readString(sample, header, 8);
+                section.virtualSize    = readValue<u32>(sample, header + 0x08);
+                section.virtualAddress = info.imageBase + readValue<u32>(sample, header + 0x0C);
+                section.fileSize       = readValue<u32>(sample, header + 0x10);
+                section.fileOffset     = readValue<u32>(sample, header + 0x14);
+
+                info.sections.push_back(std::move(section));
+            }
+        }
+
+        void parseELF(const SampleSource &sample, ImageInfo &info) {
+            const auto elfClass = readValue<u8>(sample, 0x04);
+            const auto encoding = readValue<u8>(sample, 0x05);
+            if ((elfClass != 1 && elfClass != 2) || encoding != 1)
+                return;
+
+            const bool is64Bit = elfClass == 2;
+            const auto type    = readValue<u16>(sample, 0x10);
+            const auto machine = readValue<u16>(sample, 0x12);
+
+            info.format     = ImageInfo::Format::ELF;
+            info.is64Bit    = is64Bit;
+            info.entryPoint = is64Bit ? readValue<u64>(sample, 0x18) : readValue<u32>(sample, 0x18);
+
+            switch (type) {
+                case 1:  info.type = "REL";  break;
+                case 2:  info.type = "EXEC"; break;
+                case 3:  info.type = "DYN";  break;
+                case 4:  info.type = "CORE"; break;
+                default: info.type = hex::format("0x{:04X}", type); break;
+            }
+
+            switch (machine) {
+                case 0x03: info.machine = "x86";     break;
+                case 0x3E: info.machine = "x86-64";  break;
+                case 0x28: info.machine = "ARM";     break;
+                case 0xB7: info.machine = "AArch64"; break;
+                case 0x08: info.machine = "MIPS";    break;
+                case 0xF3: info.machine = "RISC-V";  break;
+                default:   info.machine = hex::format("0x{:04X}", machine); break;
+            }
+
+            const u64 sectionTable = is64Bit ? readValue<u64>(sample, 0x28) : readValue<u32>(sample, 0x20);
+            const auto entrySize   = readValue<u16>(sample, is64Bit ? 0x3A : 0x2E);
+            const auto entryCount  = readValue<u16>(sample, is64Bit ? 0x3C : 0x30);
+            const auto nameIndex   = readValue<u16>(sample, is64Bit ? 0x3E : 0x32);
+            if (sectionTable == 0 || entrySize < (is64Bit ? 0x40 : 0x28))
+                return;
+
+            auto readSection = [&](u16 index) {
+                const auto header = sectionTable + u64(index) * entrySize;
+
+                ImageInfo::Section section;
+                const auto sectionType = readValue<u32>(sample, header + 0x04);
+                if (is64Bit) {
+                    section.virtualAddress = readValue<u64>(sample, header + 0x10);
+                    section.fileOffset     = readValue<u64>(sample, header + 0x18);
+                    section.virtualSize    = readValue<u64>(sample, header + 0x20);
+                } else {
+                    section.virtualAddress = readValue<u32>(sample, header + 0x0C);
+                    section.fileOffset     = readValue<u32>(sample, header + 0x10);
+                    section.virtualSize    = readValue<u32>(sample, header + 0x14);
+                }
+
+                // SHT_NOBITS sections like .bss take up memory but have no data in the file
+                section.fileSize = sectionType == 8 ? 0 : section.virtualSize;
+
+                return std::pair { section, readValue<u32>(sample, header) };
+            };
+
+            const auto nameTable = nameIndex < entryCount ? readSection(nameIndex).first.fileOffset : 0;
+            for (u16 i = 0; i < entryCount; i++) {
+                if (sectionTable + u64(i + 1) * entrySize > sample.getSize())
+                    break;
+
+                auto [section, nameOffset] = readSection(i);
+                if (nameTable != 0)
+                    section.name = readString(sample, nameTable + nameOffset, 64);
+
+                info.sections.push_back(std::move(section));
+            }
+        }
+
+    }
+
+    ImageInfo ImageInfo::parse(const SampleSource &sample) {
+        ImageInfo info;
+
+        if (readValue<u16>(sample, 0x00) == 0x5A4D)
+            parsePE(sample, info);
+        else if (readValue<u32>(sample, 0x00) == 0x464C'457F)
+            parseELF(sample, info);
+
+        return info;
+    }
+
+    std::optional<u64> ImageInfo::toFileOffset(u64 virtualAddress) const {
+        for (const auto &section : this->sections) {
+            // Only the part of a section that's actually stored in the file can be mapped back
+            const auto mappedSize = std::min(section.virtualSize == 0 ? section.fileSize : section.virtualSize, section.fileSize);
+            if (section.virtualAddress == 0 || mappedSize == 0)
+                continue;
+
+            if (virtualAddress >= section.virtualAddress && virtualAddress - section.virtualAddress < mappedSize)
+                return section.fileOffset + (virtualAddress - section.virtualAddress);
+        }
+
+        return std::nullopt;
+    }
+
+}
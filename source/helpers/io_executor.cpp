@@ -0,0 +1,233 @@
+#include <helpers/io_executor.hpp>
+
+#include <hex/helpers/logger.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace mal::hlp {
+
+    namespace {
+
+        // Upper bound of how long the event loop sleeps when no socket has anything to do, so timeouts are still checked
+        constexpr int PollInterval = 1000;
+
+    }
+
+    IoExecutor::IoExecutor() {
+        // Holds its own reference, so curl stays initialized until the last transfer has been torn down
+        curl_global_init(CURL_GLOBAL_ALL);
+
+        this->m_multi = curl_multi_init();
+        if (this->m_multi == nullptr) {
+            hex::log::error("Failed to initialize curl multi handle for Malcore requests");
+            return;
+        }
+
+        // Keep enough idle connections around that every transfer slot can reuse one
+        curl_multi_setopt(this->m_multi, CURLMOPT_MAXCONNECTS, long(MaxTransfers));
+
+        this->m_thread = std::jthread([this](std::stop_token stopToken) { this->run(stopToken); });
+    }
+
+    IoExecutor::~IoExecutor() {
+        if (this->m_thread.joinable()) {
+            this->m_thread.request_stop();
+            curl_multi_wakeup(this->m_multi);
+            this->m_thread.join();
+        }
+
+        for (auto handle : this->m_idleHandles)
+            curl_easy_cleanup(handle);
+
+        if (this->m_multi != nullptr)
+            curl_multi_cleanup(this->m_multi);
+
+        curl_global_cleanup();
+    }
+
+    IoExecutor &IoExecutor::get() {
+        static IoExecutor executor;
+
+        return executor;
+    }
+
+    CURL *IoExecutor::acquireHandle() {
+        auto &executor = get();
+        if (executor.m_multi == nullptr)
+            return nullptr;
+
+        {
+            std::scoped_lock lock(executor.m_mutex);
+            if (!executor.m_idleHandles.empty()) {
+                auto handle = executor.m_idleHandles.back();
+                executor.m_idleHandles.pop_back();
+
+                return handle;
+            }
+        }
+
+        return curl_easy_init();
+    }
+
+    void IoExecutor::releaseHandle(CURL *handle) {
+        curl_easy_reset(handle);
+
+        auto &executor = get();
+        {
+            std::scoped_lock lock(executor.m_mutex);
+            if (executor.m_idleHandles.size() < MaxTransfers) {
+                executor.m_idleHandles.push_back(handle);
+                return;
+            }
+        }
+
+        curl_easy_cleanup(handle);
+    }
+
+    u64 IoExecutor::start(CURL *handle, Completion completion) {
+        auto &executor = get();
+
+        u64 id;
+        {
+            std::scoped_lock lock(executor.m_mutex);
+            id = executor.m_nextId++;
+
+            // The id travels with the handle, so finished transfers can be matched up again
+            curl_easy_setopt(handle, CURLOPT_PRIVATE, reinterpret_cast<void*>(std::uintptr_t(id)));
+            executor.m_queued.emplace_back(id, Transfer { handle, std::move(completion) });
+        }
+
+        curl_multi_wakeup(executor.m_multi);
+
+        return id;
+    }
+
+    void IoExecutor::resume(u64 id) {
+        auto &executor = get();
+        {
+            std::scoped_lock lock(executor.m_mutex);
+            executor.m_resumed.push_back(id);
+        }
+
+        curl_multi_wakeup(executor.m_multi);
+    }
+
+    void IoExecutor::abort(u64 id) {
+        auto &executor = get();
+        {
+            std::scoped_lock lock(executor.m_mutex);
+            executor.m_aborted.push_back(id);
+        }
+
+        curl_multi_wakeup(executor.m_multi);
+    }
+
+    void IoExecutor::run(std::stop_token stopToken) {
+        while (!stopToken.stop_requested()) {
+            this->processCommands();
+
+            int running = 0;
+            curl_multi_perform(this->m_multi, &running);
+
+            // Messages don't survive removing their handle, so they're collected before any transfer is finished
+            std::vector<std::pair<u64, CURLcode>> finished;
+            int remaining = 0;
+            while (auto message = curl_multi_info_read(this->m_multi, &remaining)) {
+                if (message->msg != CURLMSG_DONE)
+                    continue;
+
+                void *id = nullptr;
+                curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &id);
+                finished.emplace_back(std::uintptr_t(id), message->data.result);
+            }
+
+            for (const auto &[id, code] : finished)
+                this->finish(id, code);
+
+            // Freed slots are handed to queued transfers right away instead of after the next poll
+            if (!finished.empty())
+                continue;
+
+            curl_multi_poll(this->m_multi, nullptr, 0, PollInterval, nullptr);
+        }
+
+        // Nobody must be left waiting for a transfer that's never going to complete
+        std::deque<std::pair<u64, Transfer>> queued;
+        {
+            std::scoped_lock lock(this->m_mutex);
+            queued = std::move(this->m_queued);
+        }
+
+        for (auto &[id, transfer] : queued)
+            transfer.completion(CURLE_ABORTED_BY_CALLBACK);
+        while (!this->m_active.empty())
+            this->finish(this->m_active.begin()->first, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    void IoExecutor::processCommands() {
+        std::vector<u64> resumed, aborted;
+        std::vector<std::pair<u64, Transfer>> abortedQueued;
+        {
+            std::scoped_lock lock(this->m_mutex);
+            std::swap(resumed, this->m_resumed);
+            std::swap(aborted, this->m_aborted);
+
+            // Transfers that never got to start are dropped from the queue before they take up a slot
+            std::erase_if(this->m_queued, [&](auto &entry) {
+                if (std::ranges::find(aborted, entry.first) == aborted.end())
+                    return false;
+
+                abortedQueued.push_back(std::move(entry));
+                return true;
+            });
+        }
+
+        for (auto &[id, transfer] : abortedQueued)
+            transfer.completion(CURLE_ABORTED_BY_CALLBACK);
+
+        // Ids of transfers that are already over are simply ignored
+        for (const auto id : aborted) {
+            if (this->m_active.contains(id))
+                this->finish(id, CURLE_ABORTED_BY_CALLBACK);
+        }
+
+        for (const auto id : resumed) {
+            if (auto it = this->m_active.find(id); it != this->m_active.end())
+                curl_easy_pause(it->second.handle, CURLPAUSE_CONT);
+        }
+
+        while (this->m_active.size() < MaxTransfers) {
+            std::pair<u64, Transfer> next;
+            {
+                std::scoped_lock lock(this->m_mutex);
+                if (this->m_queued.empty())
+                    break;
+
+                next = std::move(this->m_queued.front());
+                this->m_queued.pop_front();
+            }
+
+            if (const auto code = curl_multi_add_handle(this->m_multi, next.second.handle); code != CURLM_OK) {
+                hex::log::error("Failed to start Malcore transfer: {}", curl_multi_strerror(code));
+                next.second.completion(CURLE_FAILED_INIT);
+                continue;
+            }
+
+            this->m_active.emplace(std::move(next));
+        }
+    }
+
+    void IoExecutor::finish(u64 id, CURLcode code) {
+        auto it = this->m_active.find(id);
+        if (it == this->m_active.end())
+            return;
+
+        auto transfer = std::move(it->second);
+        this->m_active.erase(it);
+
+        curl_multi_remove_handle(this->m_multi, transfer.handle);
+        transfer.completion(code);
+    }
+
+}
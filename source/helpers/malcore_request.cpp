@@ -0,0 +1,367 @@
+#include <helpers/malcore_request.hpp>
+#include <helpers/io_executor.hpp>
+
+#include <hex/helpers/logger.hpp>
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <ctime>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+
+namespace mal::hlp {
+
+    namespace {
+
+        /**
+         * @brief Parses the value of a Retry-After header
+         * It's either a number of seconds or an HTTP date to wait for
+         */
+        std::optional<std::chrono::seconds> parseRetryAfter(std::string_view value) {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+                value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r' || value.back() == '\n'))
+                value.remove_suffix(1);
+
+            u64 seconds = 0;
+            if (auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), seconds); error == std::errc() && end == value.data() + value.size())
+                return std::chrono::seconds(seconds);
+
+            const auto date = curl_getdate(std::string(value).c_str(), nullptr);
+            if (date < 0)
+                return std::nullopt;
+
+            return std::chrono::seconds(std::max<i64>(date - std::time(nullptr), 0));
+        }
+
+    }
+
+    MalcoreRequest::MalcoreRequest(std::string url) : m_url(std::move(url)) { }
+
+    void MalcoreRequest::setSource(std::string mimeName, std::string fileName, u64 size, Reader reader) {
+        this->m_mimeName = std::move(mimeName);
+        this->m_fileName = std::move(fileName);
+        this->m_size     = size;
+        this->m_stream   = [size, reader = std::move(reader)](u64 offset, u8 *buffer, size_t bufferSize) -> std::optional<size_t> {
+            const auto readSize = std::min<u64>(bufferSize, size - offset);
+            if (readSize != 0)
+                reader(offset, buffer, readSize);
+
+            return readSize;
+        };
+    }
+
+    void MalcoreRequest::setSource(std::string mimeName, std::string fileName, Stream stream) {
+        this->m_mimeName = std::move(mimeName);
+        this->m_fileName = std::move(fileName);
+        this->m_size     = std::nullopt;
+        this->m_stream   = std::move(stream);
+    }
+
+    MalcoreRequest::Result MalcoreRequest::execute() {
+        Result result;
+
+        CURL *curl = IoExecutor::acquireHandle();
+        if (curl == nullptr) {
+            hex::log::error("Failed to initialize curl for Malcore request");
+            return result;
+        }
+
+        curl_easy_setopt(curl, CURLOPT_URL, this->m_url.c_str());
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "ImHex/1.0");
+        curl_easy_setopt(curl, CURLOPT_DEFAULT_PROTOCOL, "https");
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, long(std::chrono::milliseconds(ConnectTimeout).count()));
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, long(StallSpeed));
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, long(StallTime.count()));
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, long(BlockSize));
+
+        {
+            // curl keeps its own copies of the proxy URL and the certificates
+            std::scoped_lock lock(s_settingsMutex);
+            if (!s_proxyUrl.empty())
+                curl_easy_setopt(curl, CURLOPT_PROXY, s_proxyUrl.c_str());
+
+            if (s_caCertificates != nullptr && !s_caCertificates->empty()) {
+                curl_blob certificates = { const_cast<char*>(s_caCertificates->data()), s_caCertificates->size(), CURL_BLOB_COPY };
+                curl_easy_setopt(curl, CURLOPT_CAINFO_BLOB, &certificates);
+            } else {
+                #if defined(OS_WINDOWS)
+                    curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NATIVE_CA);
+                #endif
+            }
+        }
+
+        curl_slist *headers = nullptr;
+        for (const auto &[key, value] : this->m_headers) {
+            const auto header = key + ": " + value;
+            headers = curl_slist_append(headers, header.c_str());
+        }
+
+        // A body that pauses for its next block while curl still waits for "100 Continue" can be left paused for good,
+        // so streamed uploads are sent right away instead of asking the server first
+        if (this->m_stream)
+            headers = curl_slist_append(headers, "Expect:");
+
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+        curl_mime *mime = nullptr;
+        if (this->m_stream) {
+            // The file part is handed to curl block by block from the blocks the sending thread prepares
+            mime = curl_mime_init(curl);
+
+            // Fields go first, so the server knows how to treat the file before it arrives
+            for (const auto &[name, value] : this->m_fields) {
+                curl_mimepart *field = curl_mime_addpart(mime);
+                curl_mime_name(field, name.c_str());
+                curl_mime_data(field, value.c_str(), value.size());
+            }
+
+            curl_mimepart *part = curl_mime_addpart(mime);
+            curl_mime_name(part, this->m_mimeName.c_str());
+            curl_mime_filename(part, this->m_fileName.c_str());
+            if (!this->m_mimeType.empty())
+                curl_mime_type(part, this->m_mimeType.c_str());
+            curl_mime_data_cb(part, this->m_size.has_value() ? curl_off_t(*this->m_size) : -1,
+                [](char *buffer, size_t size, size_t count, void *userData) -> size_t {
+                    auto &request = *static_cast<MalcoreRequest*>(userData);
+
+                    std::unique_lock lock(request.m_transferMutex);
+                    if (request.m_cancelled)
+                        return CURL_READFUNC_ABORT;
+
+                    size_t written = 0;
+                    while (written < size * count && !request.m_blocks.empty()) {
+                        const auto &block = request.m_blocks.front();
+                        const auto copySize = std::min(size * count - written, block.size() - request.m_blockOffset);
+
+                        std::memcpy(buffer + written, block.data() + request.m_blockOffset, copySize);
+                        written += copySize;
+                        request.m_blockOffset += copySize;
+
+                        if (request.m_blockOffset == block.size()) {
+                            request.m_blocks.pop_front();
+                            request.m_blockOffset = 0;
+                        }
+                    }
+
+                    request.m_sendOffset += written;
+
+                    size_t readSize;
+                    if (written > 0)
+                        readSize = written;
+                    else if (request.m_bodyFailed)
+                        readSize = CURL_READFUNC_ABORT;
+                    else if (request.m_bodyComplete)
+                        readSize = 0;
+                    else {
+                        // Never wait for the next block on the executor thread, the transfer is resumed once it's ready
+                        request.m_waitingForBody = true;
+                        readSize = CURL_READFUNC_PAUSE;
+                    }
+
+                    lock.unlock();
+                    request.m_transferCondVar.notify_all();
+
+                    return readSize;
+                },
+                [](void *userData, curl_off_t offset, int origin) -> int {
+                    auto &request = *static_cast<MalcoreRequest*>(userData);
+
+                    if (origin != SEEK_SET || offset < 0)
+                        return CURL_SEEKFUNC_CANTSEEK;
+
+                    std::unique_lock lock(request.m_transferMutex);
+                    if (u64(offset) == request.m_sendOffset)
+                        return CURL_SEEKFUNC_OK;
+
+                    // Payloads of unknown size can only be sent again from the start
+                    if (request.m_size.has_value() ? u64(offset) > *request.m_size : offset != 0)
+                        return CURL_SEEKFUNC_CANTSEEK;
+
+                    // Everything that's been prepared so far is dropped and produced again from the new offset
+                    request.m_blocks.clear();
+                    request.m_blockOffset   = 0;
+                    request.m_produceOffset = offset;
+                    request.m_sendOffset    = offset;
+                    request.m_bodyComplete  = false;
+                    request.m_bodyFailed    = false;
+                    request.m_rewinds += 1;
+
+                    lock.unlock();
+                    request.m_transferCondVar.notify_all();
+
+                    return CURL_SEEKFUNC_OK;
+                },
+                nullptr, this);
+            curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+        } else {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, this->m_body.c_str());
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, curl_off_t(this->m_body.size()));
+        }
+
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result.data);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, +[](char *data, size_t size, size_t count, void *userData) -> size_t {
+            static_cast<std::string*>(userData)->append(data, size * count);
+
+            return size * count;
+        });
+
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &result);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, +[](char *data, size_t size, size_t count, void *userData) -> size_t {
+            constexpr static std::string_view Name = "retry-after:";
+            const std::string_view header(data, size * count);
+
+            const bool matches = header.size() > Name.size() && std::equal(Name.begin(), Name.end(), header.begin(), [](char a, char b) {
+                return a == std::tolower(static_cast<unsigned char>(b));
+            });
+
+            if (matches)
+                static_cast<Result*>(userData)->retryAfter = parseRetryAfter(header.substr(Name.size()));
+
+            return size * count;
+        });
+
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, this);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, +[](void *userData, curl_off_t, curl_off_t, curl_off_t, curl_off_t) -> int {
+            return static_cast<MalcoreRequest*>(userData)->m_cancelled ? 1 : 0;
+        });
+
+        {
+            std::scoped_lock lock(this->m_transferMutex);
+            this->m_blocks.clear();
+            this->m_blockOffset    = 0;
+            this->m_produceOffset  = 0;
+            this->m_sendOffset     = 0;
+            this->m_bodyComplete   = false;
+            this->m_bodyFailed     = false;
+            this->m_waitingForBody = false;
+            this->m_finished       = false;
+        }
+
+        const auto startTime = std::chrono::steady_clock::now();
+        const auto id = IoExecutor::start(curl, [this](CURLcode code) {
+            {
+                std::scoped_lock lock(this->m_transferMutex);
+                this->m_code     = code;
+                this->m_finished = true;
+            }
+
+            this->m_transferCondVar.notify_all();
+        });
+
+        this->waitForTransfer(id);
+
+        result.duration = std::chrono::steady_clock::now() - startTime;
+
+        const auto code = CURLcode(this->m_code);
+        if (code == CURLE_OK) {
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.statusCode);
+
+            curl_off_t bytesSent = 0;
+            curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &bytesSent);
+            result.bytesSent = bytesSent;
+
+            if (this->m_stream) {
+                hex::log::info("Uploaded {} bytes in {:.2f}s ({:.2f} MiB/s)",
+                    result.bytesSent, result.duration.count(),
+                    result.duration.count() > 0 ? (double(result.bytesSent) / 1_MiB) / result.duration.count() : 0.0);
+            }
+        } else {
+            hex::log::error("Malcore request to '{}' failed: {}", this->m_url, curl_easy_strerror(code));
+
+            curl_off_t connectTime = 0;
+            curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connectTime);
+
+            switch (code) {
+                case CURLE_COULDNT_RESOLVE_PROXY:
+                case CURLE_COULDNT_RESOLVE_HOST:
+                case CURLE_COULDNT_CONNECT:
+                case CURLE_SSL_CONNECT_ERROR:
+                    result.connectFailed = true;
+                    break;
+                case CURLE_OPERATION_TIMEDOUT:
+                    result.connectFailed = connectTime == 0;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        IoExecutor::releaseHandle(curl);
+
+        if (mime != nullptr)
+            curl_mime_free(mime);
+        curl_slist_free_all(headers);
+
+        {
+            std::scoped_lock lock(this->m_transferMutex);
+            this->m_blocks.clear();
+        }
+
+        return result;
+    }
+
+    void MalcoreRequest::waitForTransfer(u64 id) {
+        bool aborted = false;
+
+        std::unique_lock lock(this->m_transferMutex);
+        while (!this->m_finished) {
+            if (this->m_cancelled && !aborted) {
+                aborted = true;
+
+                lock.unlock();
+                IoExecutor::abort(id);
+                lock.lock();
+                continue;
+            }
+
+            // Keep a few blocks of the body prepared, so the transfer rarely has to pause for the next one
+            if (this->m_stream && !this->m_cancelled && !this->m_bodyComplete && !this->m_bodyFailed && this->m_blocks.size() < BlocksAhead) {
+                const auto offset  = this->m_produceOffset;
+                const auto rewinds = this->m_rewinds;
+                lock.unlock();
+
+                std::vector<u8> block(BlockSize);
+                const auto size = this->m_stream(offset, block.data(), block.size());
+
+                lock.lock();
+
+                // The transfer started over while the block was being produced
+                if (rewinds != this->m_rewinds)
+                    continue;
+
+                if (!size.has_value())
+                    this->m_bodyFailed = true;
+                else if (*size == 0)
+                    this->m_bodyComplete = true;
+                else {
+                    block.resize(*size);
+                    this->m_blocks.push_back(std::move(block));
+                    this->m_produceOffset += *size;
+                }
+
+                if (this->m_waitingForBody) {
+                    this->m_waitingForBody = false;
+
+                    lock.unlock();
+                    IoExecutor::resume(id);
+                    lock.lock();
+                }
+
+                continue;
+            }
+
+            this->m_transferCondVar.wait(lock);
+        }
+    }
+
+}
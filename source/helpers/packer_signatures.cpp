@@ -0,0 +1,206 @@
+#include <helpers/packer_signatures.hpp>
+
+#include <hex/helpers/logger.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <map>
+
+namespace mal::hlp {
+
+    std::optional<PackerSignatures::Pattern> PackerSignatures::Pattern::parse(std::string_view string) {
+        Pattern result;
+
+        while (!string.empty()) {
+            const auto tokenEnd = string.find(' ');
+            const auto token = string.substr(0, tokenEnd);
+            string.remove_prefix(tokenEnd == std::string_view::npos ? string.size() : tokenEnd + 1);
+
+            if (token.empty())
+                continue;
+
+            if (token == "??") {
+                result.bytes.push_back(0x00);
+                result.mask.push_back(0x00);
+                continue;
+            }
+
+            u8 byte = 0x00;
+            const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), byte, 16);
+            if (token.size() != 2 || error != std::errc() || end != token.data() + token.size())
+                return std::nullopt;
+
+            result.bytes.push_back(byte);
+            result.mask.push_back(0xFF);
+        }
+
+        if (result.bytes.empty())
+            return std::nullopt;
+
+        return result;
+    }
+
+    bool PackerSignatures::Pattern::matches(std::span<const u8> data) const {
+        if (data.size() < this->bytes.size())
+            return false;
+
+        for (size_t i = 0; i < this->bytes.size(); i++) {
+            if ((data[i] & this->mask[i]) != this->bytes[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    void PackerSignatures::load(std::string_view json) {
+        s_packers.clear();
+        s_entryPointRules.clear();
+        s_sectionRules.clear();
+        s_anywhereRules.clear();
+
+        const auto signatures = nlohmann::json::parse(json, nullptr, false);
+        if (signatures.is_discarded() || !signatures.contains("packers") || !signatures["packers"].is_array()) {
+            hex::log::error("Failed to parse packer signatures");
+            s_anchorMatcher = { };
+            return;
+        }
+
+        std::vector<std::vector<u8>> anchors;
+        for (const auto &packer : signatures["packers"]) {
+            const auto name  = packer.value("name", "");
+            const auto rules = packer.value("rules", nlohmann::json::array());
+            if (name.empty() || !rules.is_array()) {
+                hex::log::warn("Skipping invalid packer signature entry");
+                continue;
+            }
+
+            const u32 packerId = s_packers.size();
+            s_packers.push_back(name);
+
+            for (const auto &rule : rules) {
+                const auto type       = rule.value("type", "");
+                const auto confidence = std::min<u32>(rule.value("confidence", 0U), 100);
+
+                if (type == "section") {
+                    const auto sectionName = rule.value("name", "");
+                    if (sectionName.empty()) {
+                        hex::log::warn("Skipping section rule of packer '{}' without a name", name);
+                        continue;
+                    }
+
+                    s_sectionRules.push_back({ packerId, sectionName, confidence });
+                    continue;
+                }
+
+                auto pattern = Pattern::parse(rule.value("pattern", ""));
+                if (!pattern.has_value()) {
+                    hex::log::warn("Skipping {} rule of packer '{}' with an invalid pattern", type, name);
+                    continue;
+                }
+
+                if (type == "entry_point") {
+                    s_entryPointRules.push_back({ packerId, std::move(*pattern), confidence });
+                } else if (type == "anywhere") {
+                    // The longest run without wildcards is searched for, the rest of the pattern is verified on every hit
+                    size_t anchorOffset = 0, anchorSize = 0;
+                    for (size_t i = 0; i < pattern->mask.size();) {
+                        if (pattern->mask[i] == 0x00) {
+                            i += 1;
+                            continue;
+                        }
+
+                        auto runEnd = i;
+                        while (runEnd < pattern->mask.size() && pattern->mask[runEnd] != 0x00)
+                            runEnd += 1;
+
+                        if (runEnd - i > anchorSize) {
+                            anchorOffset = i;
+                            anchorSize   = runEnd - i;
+                        }
+
+                        i = runEnd;
+                    }
+
+                    if (anchorSize < MinAnchorSize) {
+                        hex::log::warn("Skipping anywhere rule of packer '{}' without at least {} consecutive fixed bytes", name, MinAnchorSize);
+                        continue;
+                    }
+
+                    anchors.emplace_back(pattern->bytes.begin() + anchorOffset, pattern->bytes.begin() + anchorOffset + anchorSize);
+                    s_anywhereRules.push_back({ packerId, std::move(*pattern), u32(anchorOffset), confidence });
+                } else {
+                    hex::log::warn("Skipping packer rule of unknown type '{}' for '{}'", type, name);
+                }
+            }
+        }
+
+        s_anchorMatcher = PatternMatcher(anchors);
+
+        hex::log::debug("Loaded {} packer signatures with {} rules", s_packers.size(), s_entryPointRules.size() + s_sectionRules.size() + s_anywhereRules.size());
+    }
+
+    std::vector<MalcoreApi::PackerInformation> PackerSignatures::scan(const SampleSource &sample, const ImageInfo &image, std::stop_token stopToken) {
+        std::map<u32, u32> confidences;
+        auto addMatch = [&confidences](u32 packer, u32 confidence) {
+            auto &best = confidences[packer];
+            best = std::max(best, confidence);
+        };
+
+        if (const auto entryPoint = image.getEntryPointOffset(); entryPoint.has_value() && *entryPoint < sample.getSize()) {
+            size_t maxSize = 0;
+            for (const auto &rule : s_entryPointRules)
+                maxSize = std::max(maxSize, rule.pattern.bytes.size());
+
+            std::vector<u8> buffer(std::min<u64>(maxSize, sample.getSize() - *entryPoint));
+            sample.read(*entryPoint, buffer.data(), buffer.size());
+
+            for (const auto &rule : s_entryPointRules) {
+                if (rule.pattern.matches(buffer))
+                    addMatch(rule.packer, rule.confidence);
+            }
+        }
+
+        for (const auto &rule : s_sectionRules) {
+            const auto found = std::any_of(image.sections.begin(), image.sections.end(), [&rule](const ImageInfo::Section &section) {
+                return section.name == rule.name;
+            });
+
+            if (found)
+                addMatch(rule.packer, rule.confidence);
+        }
+
+        const auto anchorMatches = s_anchorMatcher.locate(sample, stopToken, MaxAnchorMatches);
+        if (stopToken.stop_requested())
+            return { };
+
+        std::vector<u8> buffer;
+        for (size_t id = 0; id < anchorMatches.size(); id++) {
+            const auto &rule = s_anywhereRules[id];
+            buffer.resize(rule.pattern.bytes.size());
+
+            for (const auto offset : anchorMatches[id]) {
+                if (offset < rule.anchorOffset || offset - rule.anchorOffset + buffer.size() > sample.getSize())
+                    continue;
+
+                sample.read(offset - rule.anchorOffset, buffer.data(), buffer.size());
+                if (rule.pattern.matches(buffer)) {
+                    addMatch(rule.packer, rule.confidence);
+                    break;
+                }
+            }
+        }
+
+        std::vector<MalcoreApi::PackerInformation> result;
+        for (const auto &[packer, confidence] : confidences)
+            result.push_back({ s_packers[packer], confidence });
+
+        std::stable_sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+            return a.confidence > b.confidence;
+        });
+
+        return result;
+    }
+
+}
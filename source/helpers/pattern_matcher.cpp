@@ -0,0 +1,231 @@
+#include <helpers/pattern_matcher.hpp>
+#include <helpers/worker_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace mal::hlp {
+
+    PatternMatcher::PatternMatcher(const std::vector<std::vector<u8>> &patterns) {
+        // Only bytes that appear in any pattern get their own column in the transition table, all others share class 0
+        for (const auto &pattern : patterns) {
+            for (const auto byte : pattern) {
+                if (this->m_byteClasses[byte] == 0) {
+                    this->m_byteClasses[byte] = this->m_classCount;
+                    this->m_classCount += 1;
+                }
+            }
+        }
+
+        Trie trie;
+        trie.firstChild.push_back(None);
+        trie.nextSibling.push_back(None);
+        trie.byteClass.push_back(0);
+        this->m_outputs.push_back(None);
+
+        this->m_patternSizes.resize(patterns.size(), 0);
+        this->m_nextPatterns.resize(patterns.size(), None);
+        for (u32 id = 0; id < patterns.size(); id++) {
+            if (!patterns[id].empty())
+                this->addPattern(trie, patterns[id], id);
+        }
+
+        this->build(trie);
+    }
+
+    u32 PatternMatcher::Trie::findChild(u32 state, u32 byteClass) const {
+        for (auto child = this->firstChild[state]; child != None; child = this->nextSibling[child]) {
+            if (this->byteClass[child] == byteClass)
+                return child;
+        }
+
+        return None;
+    }
+
+    void PatternMatcher::addPattern(Trie &trie, std::span<const u8> bytes, u32 id) {
+        u32 state = 0;
+        for (const auto byte : bytes) {
+            const auto byteClass = this->m_byteClasses[byte];
+
+            auto child = trie.findChild(state, byteClass);
+            if (child == None) {
+                child = this->m_outputs.size();
+                trie.firstChild.push_back(None);
+                trie.nextSibling.push_back(trie.firstChild[state]);
+                trie.byteClass.push_back(byteClass);
+                trie.firstChild[state] = child;
+
+                this->m_outputs.push_back(None);
+            }
+
+            state = child;
+        }
+
+        this->m_patternSizes[id] = bytes.size();
+        this->m_nextPatterns[id] = this->m_outputs[state];
+        this->m_outputs[state] = id;
+        this->m_maxPatternSize = std::max(this->m_maxPatternSize, bytes.size());
+    }
+
+    void PatternMatcher::build(const Trie &trie) {
+        const auto classCount = this->m_classCount;
+        const auto stateCount = u32(this->m_outputs.size());
+
+        // States are renumbered breadth first, so every state's failure state and all full rows come before it
+        std::vector<u32> order = { 0 };
+        order.reserve(stateCount);
+        for (size_t i = 0; i < order.size(); i++) {
+            for (auto child = trie.firstChild[order[i]]; child != None; child = trie.nextSibling[child])
+                order.push_back(child);
+        }
+
+        std::vector<u32> ids(stateCount);
+        for (u32 id = 0; id < stateCount; id++)
+            ids[order[id]] = id;
+
+        std::vector<u32> outputs(stateCount);
+        this->m_edgeOffsets.reserve(stateCount + 1);
+        this->m_edgeClasses.reserve(stateCount - 1);
+        this->m_edgeTargets.reserve(stateCount - 1);
+        for (u32 id = 0; id < stateCount; id++) {
+            outputs[id] = this->m_outputs[order[id]];
+
+            const auto first = this->m_edgeClasses.size();
+            this->m_edgeOffsets.push_back(first);
+
+            for (auto child = trie.firstChild[order[id]]; child != None; child = trie.nextSibling[child]) {
+                this->m_edgeClasses.push_back(trie.byteClass[child]);
+                this->m_edgeTargets.push_back(ids[child]);
+            }
+
+            // Edges of a state are looked up by binary search. Most states only have one or two, so they're sorted in place
+            for (auto i = first + 1; i < this->m_edgeClasses.size(); i++) {
+                for (auto j = i; j > first && this->m_edgeClasses[j - 1] > this->m_edgeClasses[j]; j--) {
+                    std::swap(this->m_edgeClasses[j - 1], this->m_edgeClasses[j]);
+                    std::swap(this->m_edgeTargets[j - 1], this->m_edgeTargets[j]);
+                }
+            }
+        }
+        this->m_edgeOffsets.push_back(this->m_edgeClasses.size());
+        this->m_outputs = std::move(outputs);
+
+        this->m_denseStateCount = u32(std::clamp<u64>(MaxTableSize / (u64(classCount) * sizeof(u32)), 1, stateCount));
+        this->m_transitions.resize(u64(this->m_denseStateCount) * classCount, 0);
+        this->m_failures.resize(stateCount, 0);
+        this->m_outputLinks.resize(stateCount, None);
+
+        for (u32 state = 0; state < stateCount; state++) {
+            const auto failure = this->m_failures[state];
+            if (state != 0)
+                this->m_outputLinks[state] = this->m_outputs[failure] != None ? failure : this->m_outputLinks[failure];
+
+            // Full rows start out as a copy of their failure state's row, which is always complete already
+            if (state < this->m_denseStateCount && state != 0)
+                std::copy_n(this->m_transitions.begin() + u64(failure) * classCount, classCount, this->m_transitions.begin() + u64(state) * classCount);
+
+            for (auto edge = this->m_edgeOffsets[state]; edge < this->m_edgeOffsets[state + 1]; edge++) {
+                const auto byteClass = this->m_edgeClasses[edge];
+                const auto child     = this->m_edgeTargets[edge];
+
+                this->m_failures[child] = state == 0 ? 0 : this->step(failure, byteClass);
+                if (state < this->m_denseStateCount)
+                    this->m_transitions[u64(state) * classCount + byteClass] = child;
+            }
+        }
+    }
+
+    u32 PatternMatcher::findEdge(u32 state, u32 byteClass) const {
+        const auto begin = this->m_edgeClasses.begin() + this->m_edgeOffsets[state];
+        const auto end   = this->m_edgeClasses.begin() + this->m_edgeOffsets[state + 1];
+
+        const auto it = std::lower_bound(begin, end, byteClass);
+        if (it == end || *it != byteClass)
+            return None;
+
+        return this->m_edgeTargets[it - this->m_edgeClasses.begin()];
+    }
+
+    u32 PatternMatcher::step(u32 state, u32 byteClass) const {
+        // Failure states are always shallower, so the chain ends in a full row at the latest at the root
+        while (state >= this->m_denseStateCount) {
+            if (const auto next = this->findEdge(state, byteClass); next != None)
+                return next;
+
+            state = this->m_failures[state];
+        }
+
+        return this->m_transitions[u64(state) * this->m_classCount + byteClass];
+    }
+
+    void PatternMatcher::scan(std::span<const u8> data, u64 baseOffset, u64 endOffset, size_t maxMatches, std::vector<std::vector<u64>> &matches) const {
+        u32 state = 0;
+        for (u64 i = 0; i < data.size(); i++) {
+            state = this->step(state, this->m_byteClasses[data[i]]);
+
+            for (auto output = this->m_outputs[state] != None ? state : this->m_outputLinks[state]; output != None; output = this->m_outputLinks[output]) {
+                for (auto id = this->m_outputs[output]; id != None; id = this->m_nextPatterns[id]) {
+                    // Matches that start in the overlap with the next chunk are reported by that chunk instead
+                    const auto offset = baseOffset + i + 1 - this->m_patternSizes[id];
+                    if (offset >= endOffset)
+                        continue;
+
+                    if (matches[id].size() < maxMatches)
+                        matches[id].push_back(offset);
+                }
+            }
+        }
+    }
+
+    std::vector<std::vector<u64>> PatternMatcher::locate(const SampleSource &sample, std::stop_token stopToken, size_t maxMatches) const {
+        const auto patternCount = this->getPatternCount();
+
+        std::vector<std::vector<u64>> result(patternCount);
+        if (this->m_maxPatternSize == 0 || sample.getSize() == 0)
+            return result;
+
+        const auto size       = sample.getSize();
+        const auto chunkCount = (size + ChunkSize - 1) / ChunkSize;
+        const auto overlap    = this->m_maxPatternSize - 1;
+
+        const auto workerCount = std::clamp<size_t>(WorkerPool::getConcurrency(), 1, chunkCount);
+        std::vector<std::vector<std::vector<u64>>> workerMatches(workerCount, std::vector<std::vector<u64>>(patternCount));
+
+        std::atomic<u64> nextChunk = 0;
+        {
+            WorkerPool::run(workerCount, [&](u32 worker) {
+                std::vector<u8> buffer;
+
+                while (!stopToken.stop_requested()) {
+                    const auto chunk = nextChunk++;
+                    if (chunk >= chunkCount)
+                        break;
+
+                    // Every chunk is read together with the start of the next one, so matches crossing the chunk boundary are still found
+                    const auto start   = chunk * ChunkSize;
+                    const auto end     = std::min<u64>(start + ChunkSize, size);
+                    const auto readEnd = std::min<u64>(end + overlap, size);
+
+                    buffer.resize(readEnd - start);
+                    sample.read(start, buffer.data(), buffer.size());
+
+                    this->scan(buffer, start, end, maxMatches, workerMatches[worker]);
+                }
+            });
+        }
+
+        for (size_t id = 0; id < patternCount; id++) {
+            auto &matches = result[id];
+            for (auto &worker : workerMatches)
+                matches.insert(matches.end(), worker[id].begin(), worker[id].end());
+
+            std::sort(matches.begin(), matches.end());
+
+            if (matches.size() > maxMatches)
+                matches.resize(maxMatches);
+        }
+
+        return result;
+    }
+
+}
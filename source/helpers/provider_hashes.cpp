@@ -0,0 +1,99 @@
+#include <helpers/provider_hashes.hpp>
+
+#include <hex/api/event.hpp>
+#include <hex/helpers/logger.hpp>
+#include <hex/helpers/utils.hpp>
+
+#include <chrono>
+#include <limits>
+
+namespace mal::hlp {
+
+    using namespace hex;
+
+    void ProviderHashes::init() {
+        EventManager::subscribe<EventProviderDataModified>([](prv::Provider *provider, u64 offset, u64 size, const u8 *) {
+            invalidate(provider, offset, size);
+        });
+
+        // Inserting or removing bytes shifts everything that follows
+        EventManager::subscribe<EventProviderDataInserted>([](prv::Provider *provider, u64 offset, u64) {
+            invalidate(provider, offset, std::numeric_limits<u64>::max());
+        });
+
+        EventManager::subscribe<EventProviderDataRemoved>([](prv::Provider *provider, u64 offset, u64) {
+            invalidate(provider, offset, std::numeric_limits<u64>::max());
+        });
+
+        EventManager::subscribe<EventProviderDeleted>([](prv::Provider *provider) {
+            std::scoped_lock lock(s_entriesMutex);
+            s_entries.erase(provider);
+        });
+    }
+
+    SampleSource ProviderHashes::createSample(prv::Provider *provider) {
+        auto sample = SampleSource::fromProvider(provider);
+        sample.setDigester([provider](u64 limit, std::stop_token stopToken) {
+            return getDigest(provider, limit, stopToken);
+        });
+
+        return sample;
+    }
+
+    std::optional<SampleSource::Hash> ProviderHashes::getDigest(prv::Provider *provider, u64 limit, std::stop_token stopToken) {
+        std::shared_ptr<Entry> entry;
+        {
+            std::scoped_lock lock(s_entriesMutex);
+
+            auto &existing = s_entries[provider];
+            if (existing == nullptr)
+                existing = std::make_shared<Entry>();
+
+            entry = existing;
+        }
+
+        std::scoped_lock lock(entry->treeMutex);
+
+        auto &tree = entry->tree;
+        tree.resize(std::min(provider->getActualSize(), limit));
+        {
+            std::scoped_lock pendingLock(entry->pendingMutex);
+
+            for (const auto &region : entry->pending)
+                tree.invalidate(region.getStartAddress(), region.getSize());
+            entry->pending.clear();
+        }
+
+        if (tree.isDirty()) {
+            const auto startTime = std::chrono::steady_clock::now();
+            if (!tree.update(SampleSource::fromProvider(provider), stopToken))
+                return std::nullopt;
+
+            log::debug("Rehashed '{}' ({}) in {:.3f}ms", provider->getName(), hex::toByteString(tree.getSize()), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+        }
+
+        return tree.getRoot();
+    }
+
+    void ProviderHashes::invalidate(prv::Provider *provider, u64 address, u64 size) {
+        std::shared_ptr<Entry> entry;
+        {
+            std::scoped_lock lock(s_entriesMutex);
+
+            // Providers that were never hashed have nothing to invalidate
+            auto it = s_entries.find(provider);
+            if (it == s_entries.end())
+                return;
+
+            entry = it->second;
+        }
+
+        // Events carry provider addresses, the tree is indexed from the start of the data
+        const auto baseAddress = provider->getBaseAddress();
+        const auto offset = address > baseAddress ? address - baseAddress : 0;
+
+        std::scoped_lock lock(entry->pendingMutex);
+        entry->pending.push_back(Region { offset, size });
+    }
+
+}
@@ -0,0 +1,799 @@
+#include <helpers/report_pages.hpp>
+
+#include <helpers/status_parser.hpp>
+#include <helpers/worker_pool.hpp>
+
+#include <hex/helpers/logger.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <utility>
+
+namespace mal::hlp {
+
+    namespace {
+
+        // Pages only store the entry points themselves, this puts them back where StatusParser expects them
+        constexpr static std::string_view PagePrefix = R"({"data":{"dynamic_analysis":{"dynamic_analysis":[{"entry_points":[)";
+        constexpr static std::string_view PageSuffix = "]}]}}}";
+
+        struct Range {
+            size_t begin = 0, end = 0;
+        };
+
+        struct Call {
+            u64 pc = 0;
+            std::string_view name;
+        };
+
+        struct EntryPoint {
+            Range range;
+            std::string hash;
+            u32 apiCount = 0;
+
+            // Names are still quoted and escaped, they're only decoded once per call site
+            std::vector<Call> calls;
+        };
+
+        struct Layout {
+            std::vector<Range> sections;
+            std::vector<EntryPoint> entryPoints;
+            bool hasTraces = false;
+
+            // Index of the traces a paged summary has in place of the traces themselves
+            std::optional<Range> pageIndex;
+        };
+
+        struct PageIndex {
+            std::string uuid;
+            u32 pageSize = 0;
+            std::vector<ReportPages::TraceHeader> traces;
+        };
+
+        /**
+         * @brief Location inside of the response, following the same paths as StatusParser
+         */
+        enum class Node {
+            Skip,
+            Root,
+            Data,
+            DynamicAnalysis,
+            DynamicAnalysisList,
+            DynamicAnalysisEntry,
+            EntryPoints,
+            EntryPoint,
+            Apis,
+            Api
+        };
+
+        struct Frame {
+            Node node = Node::Skip;
+            bool isArray = false;
+            size_t begin = 0;
+
+            bool expectKey = false;
+            bool isSection = false;
+            std::string_view key;
+        };
+
+        Node getChildNode(const std::vector<Frame> &stack, bool isArray) {
+            if (stack.empty())
+                return isArray ? Node::Skip : Node::Root;
+
+            const auto &parent = stack.back();
+            const auto &key    = parent.key;
+
+            switch (parent.node) {
+                using enum Node;
+
+                case Root:
+                    if (!isArray && key == "data")
+                        return Data;
+                    break;
+                case Data:
+                    if (!isArray && key == "dynamic_analysis")
+                        return DynamicAnalysis;
+                    break;
+                case DynamicAnalysis:
+                    if (isArray && key == "dynamic_analysis")
+                        return DynamicAnalysisList;
+                    break;
+                case DynamicAnalysisList:
+                    if (!isArray)
+                        return DynamicAnalysisEntry;
+                    break;
+                case DynamicAnalysisEntry:
+                    if (isArray && key == "entry_points")
+                        return EntryPoints;
+                    break;
+                case EntryPoints:
+                    if (!isArray)
+                        return EntryPoint;
+                    break;
+                case EntryPoint:
+                    if (isArray && key == "apis")
+                        return Apis;
+                    break;
+                case Apis:
+                    if (!isArray)
+                        return Api;
+                    break;
+                default:
+                    break;
+            }
+
+            return Node::Skip;
+        }
+
+        bool isSectionValue(const std::vector<Frame> &stack) {
+            return !stack.empty() && stack.back().node == Node::Data && (stack.back().key == "dynamic_analysis" || stack.back().key == "dynamic_analysis_pages");
+        }
+
+        bool isPageIndexValue(const std::vector<Frame> &stack) {
+            return isSectionValue(stack) && stack.back().key == "dynamic_analysis_pages";
+        }
+
+        /**
+         * @brief Finds the dynamic analysis section and the boundaries of all entry points in it
+         * This only follows the structure of the response and doesn't decode anything but the entry points' hashes,
+         * so it's a lot cheaper than parsing the whole response. Whatever is kept gets validated by StatusParser later on
+         */
+        std::optional<Layout> scan(std::string_view text) {
+            Layout layout;
+            std::vector<Frame> stack;
+
+            auto addScalar = [&](Range range, bool isString) -> bool {
+                if (isSectionValue(stack)) {
+                    layout.sections.push_back(range);
+                } else if (isString && !stack.empty() && stack.back().node == Node::EntryPoint && stack.back().key == "apihash") {
+                    try {
+                        layout.entryPoints.back().hash = nlohmann::json::parse(text.substr(range.begin, range.end - range.begin)).get<std::string>();
+                    } catch (const std::exception &) {
+                        return false;
+                    }
+                } else if (isString && !stack.empty() && stack.back().node == Node::Api) {
+                    // Same as StatusParser, PCs are hex numbers with an optional prefix
+                    auto &call = layout.entryPoints.back().calls.back();
+                    if (stack.back().key == "api_name") {
+                        call.name = text.substr(range.begin, range.end - range.begin);
+                    } else if (stack.back().key == "pc") {
+                        auto value = text.substr(range.begin + 1, range.end - range.begin - 2);
+                        if (value.starts_with("0x") || value.starts_with("0X"))
+                            value.remove_prefix(2);
+                        std::from_chars(value.data(), value.data() + value.size(), call.pc, 16);
+                    }
+                }
+
+                return true;
+            };
+
+            size_t pos = 0;
+            while (true) {
+                while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+                    pos += 1;
+
+                if (pos >= text.size())
+                    break;
+
+                switch (const char c = text[pos]; c) {
+                    case '{':
+                    case '[': {
+                        const bool isArray = c == '[';
+                        const auto node = getChildNode(stack, isArray);
+
+                        if (node == Node::Api) {
+                            layout.entryPoints.back().apiCount += 1;
+                            layout.entryPoints.back().calls.emplace_back();
+                        }
+                        if (node == Node::DynamicAnalysisList)
+                            layout.hasTraces = true;
+                        if (node == Node::EntryPoint)
+                            layout.entryPoints.emplace_back().range = { pos, pos };
+
+                        const bool isSection = isSectionValue(stack);
+
+                        auto &frame = stack.emplace_back();
+                        frame.node      = node;
+                        frame.isArray   = isArray;
+                        frame.begin     = pos;
+                        frame.expectKey = !isArray;
+                        frame.isSection = isSection;
+
+                        pos += 1;
+                        break;
+                    }
+                    case '}':
+                    case ']': {
+                        if (stack.empty() || stack.back().isArray != (c == ']'))
+                            return std::nullopt;
+
+                        pos += 1;
+
+                        const auto frame = stack.back();
+                        stack.pop_back();
+
+                        if (frame.node == Node::EntryPoint)
+                            layout.entryPoints.back().range.end = pos;
+                        if (frame.isSection) {
+                            layout.sections.push_back({ frame.begin, pos });
+                            if (isPageIndexValue(stack))
+                                layout.pageIndex = Range { frame.begin, pos };
+                        }
+                        break;
+                    }
+                    case ',':
+                        if (stack.empty())
+                            return std::nullopt;
+
+                        stack.back().expectKey = !stack.back().isArray;
+                        pos += 1;
+                        break;
+                    case ':':
+                        if (stack.empty() || stack.back().isArray)
+                            return std::nullopt;
+
+                        pos += 1;
+                        break;
+                    case '"': {
+                        const auto begin = pos;
+
+                        // Jump from quote to quote, a quote only ends the string if it isn't preceded by an odd number of backslashes
+                        while (true) {
+                            pos = text.find('"', pos + 1);
+                            if (pos == std::string_view::npos)
+                                return std::nullopt;
+
+                            size_t backslashes = 0;
+                            while (text[pos - backslashes - 1] == '\\')
+                                backslashes += 1;
+
+                            if (backslashes % 2 == 0)
+                                break;
+                        }
+
+                        pos += 1;
+
+                        if (!stack.empty() && stack.back().expectKey) {
+                            stack.back().key = text.substr(begin + 1, pos - begin - 2);
+                            stack.back().expectKey = false;
+                        } else if (!addScalar({ begin, pos }, true)) {
+                            return std::nullopt;
+                        }
+                        break;
+                    }
+                    default: {
+                        const auto begin = pos;
+                        while (pos < text.size() && std::string_view(",]}: \t\n\r").find(text[pos]) == std::string_view::npos)
+                            pos += 1;
+
+                        if (pos == begin)
+                            return std::nullopt;
+
+                        if (!addScalar({ begin, pos }, false))
+                            return std::nullopt;
+                        break;
+                    }
+                }
+            }
+
+            if (!stack.empty())
+                return std::nullopt;
+
+            std::sort(layout.sections.begin(), layout.sections.end(), [](const Range &a, const Range &b) { return a.begin < b.begin; });
+
+            return layout;
+        }
+
+        /**
+         * @brief Parses the index of a paged summary. It only holds a few bytes per trace, so it's simply parsed as a whole
+         */
+        std::optional<PageIndex> parsePageIndex(std::string_view text, Range range) {
+            try {
+                const auto json = nlohmann::json::parse(text.substr(range.begin, range.end - range.begin));
+
+                PageIndex index;
+                index.uuid     = json.at("uuid").get<std::string>();
+                index.pageSize = json.at("page_size").get<u32>();
+                for (const auto &trace : json.at("traces"))
+                    index.traces.push_back({ trace.at("apihash").get<std::string>(), trace.at("api_count").get<u32>() });
+
+                if (index.uuid.empty() || index.pageSize == 0)
+                    return std::nullopt;
+
+                return index;
+            } catch (const std::exception &e) {
+                hex::log::error("Invalid Malcore dynamic analysis page index: {}", e.what());
+                return std::nullopt;
+            }
+        }
+
+        /**
+         * @brief Compresses the given entry points into a page
+         * @param text Response the entry points are in
+         * @param entryPoints Entry points of the page
+         * @param buffer Reused for the uncompressed entry points
+         * @return Page without its first trace set or std::nullopt if compressing failed
+         */
+        std::optional<ReportPages::StoredPage> compressEntryPoints(std::string_view text, std::span<const EntryPoint> entryPoints, std::string &buffer) {
+            buffer.clear();
+            for (const auto &entryPoint : entryPoints) {
+                if (!buffer.empty())
+                    buffer.push_back(',');
+                buffer.append(text.substr(entryPoint.range.begin, entryPoint.range.end - entryPoint.range.begin));
+            }
+
+            if (buffer.size() > std::numeric_limits<uLong>::max())
+                return std::nullopt;
+
+            ReportPages::StoredPage page;
+            page.rawSize = buffer.size();
+            page.data.resize(compressBound(buffer.size()));
+
+            uLongf compressedSize = page.data.size();
+            if (compress2(page.data.data(), &compressedSize, reinterpret_cast<const Bytef*>(buffer.data()), buffer.size(), Z_BEST_SPEED) != Z_OK)
+                return std::nullopt;
+
+            page.data.resize(compressedSize);
+            page.data.shrink_to_fit();
+
+            return page;
+        }
+
+        /**
+         * @brief Decodes a quoted JSON string, only going through the JSON parser if it has any escape sequences
+         */
+        std::string decodeString(std::string_view quoted) {
+            if (quoted.size() < 2)
+                return { };
+
+            if (!quoted.contains('\\'))
+                return std::string(quoted.substr(1, quoted.size() - 2));
+
+            try {
+                return nlohmann::json::parse(quoted).get<std::string>();
+            } catch (const std::exception &) {
+                return { };
+            }
+        }
+
+        /**
+         * @brief Call site of a single page, its name still quoted the way it's in the response
+         */
+        struct PageCallSite {
+            u64 pc = 0;
+            std::string_view name;
+            u32 count = 0;
+        };
+
+        /**
+         * @brief Collects the call sites of the given entry points, every PC only once
+         */
+        std::vector<PageCallSite> collectCallSites(std::span<const EntryPoint> entryPoints) {
+            std::vector<PageCallSite> callSites;
+            std::unordered_map<u64, u32> indices;
+
+            for (const auto &entryPoint : entryPoints) {
+                for (const auto &call : entryPoint.calls) {
+                    auto [it, inserted] = indices.try_emplace(call.pc, callSites.size());
+                    if (inserted)
+                        callSites.push_back({ call.pc, call.name, 0 });
+
+                    callSites[it->second].count += 1;
+                }
+            }
+
+            return callSites;
+        }
+
+        /**
+         * @brief Merges the call sites of pages into the ones that were collected before
+         * Names are only decoded once, the first time they show up
+         */
+        void mergeCallSites(ReportPages::CallSites &callSites, std::span<const std::vector<PageCallSite>> pages) {
+            std::unordered_map<u64, u32> indices;
+            std::unordered_map<std::string, u32> names;
+            for (u32 i = 0; i < callSites.sites.size(); i++)
+                indices.emplace(callSites.sites[i].pc, i);
+            for (u32 i = 0; i < callSites.names.size(); i++)
+                names.emplace(callSites.names[i], i);
+
+            std::unordered_map<std::string_view, u32> quotedNames;
+            for (const auto &page : pages) {
+                for (const auto &callSite : page) {
+                    auto [it, inserted] = indices.try_emplace(callSite.pc, callSites.sites.size());
+                    if (inserted) {
+                        auto [quoted, newQuoted] = quotedNames.try_emplace(callSite.name, 0);
+                        if (newQuoted) {
+                            auto [name, newName] = names.try_emplace(decodeString(callSite.name), callSites.names.size());
+                            if (newName)
+                                callSites.names.push_back(name->first);
+
+                            quoted->second = name->second;
+                        }
+
+                        callSites.sites.push_back({ callSite.pc, quoted->second, 0 });
+                    }
+
+                    callSites.sites[it->second].count += callSite.count;
+                }
+            }
+        }
+
+        std::string buildSummary(std::string_view text, std::span<const Range> sections) {
+            std::string summary;
+
+            size_t offset = 0;
+            for (const auto &section : sections) {
+                summary.append(text.substr(offset, section.begin - offset));
+                summary.append("null");
+                offset = section.end;
+            }
+            summary.append(text.substr(offset));
+
+            return summary;
+        }
+
+    }
+
+    std::optional<ReportPages> ReportPages::split(std::string_view status) {
+        auto layout = scan(status);
+        if (!layout.has_value())
+            return std::nullopt;
+
+        ReportPages result;
+        result.m_summary   = buildSummary(status, layout->sections);
+        result.m_hasTraces = layout->hasTraces;
+
+        // Paged summaries only have the index, their pages are fetched once they're needed
+        if (layout->pageIndex.has_value()) {
+            auto index = parsePageIndex(status, *layout->pageIndex);
+            if (!index.has_value())
+                return std::nullopt;
+
+            result.m_hasTraces    = true;
+            result.m_traceHeaders = std::move(index->traces);
+            result.m_remoteUuid   = std::move(index->uuid);
+
+            for (u64 trace = 0; trace < result.m_traceHeaders.size(); trace += index->pageSize)
+                result.m_pages.push_back({ u32(trace), 0, { } });
+
+            return result;
+        }
+
+        // Pages hold whole entry points, so a single huge trace still ends up on a page of its own
+        std::vector<std::pair<u32, u32>> pageRanges;
+        u64 pageSize = 0;
+        for (u32 i = 0; i < layout->entryPoints.size(); i++) {
+            const auto &entryPoint = layout->entryPoints[i];
+            const auto size = entryPoint.range.end - entryPoint.range.begin;
+
+            if (pageRanges.empty() || pageRanges.back().second - pageRanges.back().first == MaxTracesPerPage || pageSize + size > MaxPageSize) {
+                pageRanges.emplace_back(i, i);
+                pageSize = 0;
+            }
+
+            pageRanges.back().second += 1;
+            pageSize += size;
+
+            result.m_traceHeaders.push_back({ entryPoint.hash, entryPoint.apiCount });
+        }
+
+        result.m_pages.resize(pageRanges.size());
+        std::vector<std::vector<PageCallSite>> callSites(pageRanges.size());
+
+        std::atomic<size_t> nextPage = 0;
+        std::atomic<bool> failed = false;
+        {
+            const auto workerCount = std::clamp<size_t>(WorkerPool::getConcurrency(), 1, std::max<size_t>(pageRanges.size(), 1));
+
+            WorkerPool::run(workerCount, [&](u32) {
+                std::string text;
+
+                while (!failed) {
+                    const auto index = nextPage++;
+                    if (index >= pageRanges.size())
+                        break;
+
+                    const auto [first, last] = pageRanges[index];
+
+                    const auto entryPoints = std::span(layout->entryPoints).subspan(first, last - first);
+
+                    auto page = compressEntryPoints(status, entryPoints, text);
+                    if (!page.has_value()) {
+                        failed = true;
+                        break;
+                    }
+
+                    page->firstTrace = first;
+                    result.m_pages[index] = std::move(*page);
+                    callSites[index]      = collectCallSites(entryPoints);
+                }
+            });
+        }
+
+        if (failed) {
+            hex::log::error("Failed to compress Malcore dynamic analysis traces");
+            return std::nullopt;
+        }
+
+        mergeCallSites(result.m_callSites, callSites);
+
+        return result;
+    }
+
+    std::optional<std::string> ReportPages::extractSummary(std::string_view status, std::vector<TraceHeader> *traceHeaders) {
+        auto layout = scan(status);
+        if (!layout.has_value())
+            return std::nullopt;
+
+        std::optional<PageIndex> index;
+        if (layout->pageIndex.has_value()) {
+            index = parsePageIndex(status, *layout->pageIndex);
+            if (!index.has_value())
+                return std::nullopt;
+        }
+
+        if (traceHeaders != nullptr) {
+            traceHeaders->clear();
+            if (index.has_value()) {
+                *traceHeaders = std::move(index->traces);
+            } else {
+                for (auto &entryPoint : layout->entryPoints)
+                    traceHeaders->push_back({ std::move(entryPoint.hash), entryPoint.apiCount });
+            }
+        }
+
+        return buildSummary(status, layout->sections);
+    }
+
+    std::optional<ReportPages> ReportPages::fromStoredPages(std::vector<TraceHeader> traceHeaders, std::vector<StoredPage> pages, CallSites callSites, std::string remoteUuid) {
+        if (traceHeaders.empty() != pages.empty() || (!pages.empty() && pages.front().firstTrace != 0))
+            return std::nullopt;
+
+        for (u32 i = 0; i < pages.size(); i++) {
+            const auto &page = pages[i];
+            const auto nextTrace = i + 1 < pages.size() ? pages[i + 1].firstTrace : traceHeaders.size();
+
+            // Every page needs at least one trace, and deflate can't expand data by more than about 1032:1,
+            // so corrupted sizes are caught here instead of when a huge buffer gets allocated for them
+            if (page.firstTrace >= nextTrace || page.rawSize > page.data.size() * 1032 || page.rawSize > std::numeric_limits<uLong>::max())
+                return std::nullopt;
+
+            // Only pages that can still be fetched may be missing
+            if (page.data.empty() && remoteUuid.empty())
+                return std::nullopt;
+        }
+
+        if (std::ranges::any_of(callSites.sites, [&](const CallSites::Site &site) { return site.name >= callSites.names.size(); }))
+            return std::nullopt;
+
+        ReportPages result;
+        result.m_hasTraces    = !traceHeaders.empty();
+        result.m_traceHeaders = std::move(traceHeaders);
+        result.m_remoteUuid   = std::move(remoteUuid);
+        result.m_pages        = std::move(pages);
+        result.m_callSites    = std::move(callSites);
+
+        return result;
+    }
+
+    ReportPages::ReportPages(ReportPages &&other) noexcept
+        : m_summary(std::move(other.m_summary)), m_hasTraces(other.m_hasTraces),
+          m_traceHeaders(std::move(other.m_traceHeaders)), m_remoteUuid(std::move(other.m_remoteUuid)) {
+        std::scoped_lock lock(other.m_pagesMutex, other.m_cacheMutex);
+
+        this->m_pages     = std::move(other.m_pages);
+        this->m_callSites = std::move(other.m_callSites);
+        this->m_cache   = std::move(other.m_cache);
+        this->m_loading = std::move(other.m_loading);
+    }
+
+    u32 ReportPages::getPageOf(u32 trace) const {
+        const auto it = std::upper_bound(this->m_pages.begin(), this->m_pages.end(), trace, [](u32 trace, const StoredPage &page) {
+            return trace < page.firstTrace;
+        });
+
+        return std::max<u32>(std::distance(this->m_pages.begin(), it), 1) - 1;
+    }
+
+    std::vector<ReportPages::StoredPage> ReportPages::getStoredPages() const {
+        std::scoped_lock lock(this->m_pagesMutex);
+
+        return this->m_pages;
+    }
+
+    bool ReportPages::isPageStored(u32 page) const {
+        std::scoped_lock lock(this->m_pagesMutex);
+
+        return page < this->m_pages.size() && !this->m_pages[page].data.empty();
+    }
+
+    u32 ReportPages::getTraceCount(u32 page) const {
+        return (page + 1 < this->m_pages.size() ? this->m_pages[page + 1].firstTrace : this->m_traceHeaders.size()) - this->m_pages[page].firstTrace;
+    }
+
+    ReportPages::CallSites ReportPages::getCallSites(u32 *pageCount) const {
+        std::scoped_lock lock(this->m_pagesMutex);
+
+        if (pageCount != nullptr)
+            *pageCount = std::ranges::count_if(this->m_pages, [](const StoredPage &page) { return !page.data.empty(); });
+
+        return this->m_callSites;
+    }
+
+    u64 ReportPages::getRawSize() const {
+        std::scoped_lock lock(this->m_pagesMutex);
+
+        u64 size = 0;
+        for (const auto &page : this->m_pages)
+            size += page.rawSize;
+
+        return size;
+    }
+
+    u64 ReportPages::getStoredSize() const {
+        std::scoped_lock lock(this->m_pagesMutex);
+
+        u64 size = 0;
+        for (const auto &page : this->m_pages)
+            size += page.data.size();
+
+        return size;
+    }
+
+    u32 ReportPages::getCachedPageCount() const {
+        std::scoped_lock lock(this->m_cacheMutex);
+
+        return this->m_cache.size();
+    }
+
+    std::shared_ptr<const ReportPages::Page> ReportPages::findPage(u32 page) const {
+        std::scoped_lock lock(this->m_cacheMutex);
+
+        const auto it = std::find_if(this->m_cache.begin(), this->m_cache.end(), [page](const CachedPage &cached) { return cached.page == page; });
+        if (it == this->m_cache.end())
+            return nullptr;
+
+        it->lastUse = std::chrono::steady_clock::now();
+
+        return it->data;
+    }
+
+    std::shared_ptr<const ReportPages::Page> ReportPages::loadPage(u32 page) const {
+        if (auto cached = this->findPage(page); cached != nullptr)
+            return cached;
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        auto decoded = this->decodePage(page, true);
+        if (decoded.has_value()) {
+            hex::log::debug("Decoded page {} of Malcore traces ({} traces) in {:.3f}s", page, decoded->traces.size(), std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+        } else {
+            // Broken pages are kept as empty ones, so they aren't decoded over and over again
+            hex::log::error("Failed to decode page {} of Malcore traces", page);
+        }
+
+        auto result = std::make_shared<const Page>(decoded.has_value() ? std::move(*decoded) : Page());
+        this->insert(page, result);
+
+        return result;
+    }
+
+    std::optional<ReportPages::Page> ReportPages::decodePage(u32 page, bool buildIndices) const {
+        if (page >= this->m_pages.size())
+            return std::nullopt;
+
+        if (!this->isPageStored(page) && !this->fetchPage(page))
+            return std::nullopt;
+
+        // Pages never change again once they have data, so they're read without holding the lock
+        const auto &stored = this->m_pages[page];
+        const auto traceCount = this->getTraceCount(page);
+
+        std::string text(PagePrefix);
+        text.resize(PagePrefix.size() + stored.rawSize);
+
+        uLongf size = stored.rawSize;
+        if (uncompress(reinterpret_cast<Bytef*>(text.data() + PagePrefix.size()), &size, stored.data.data(), stored.data.size()) != Z_OK || size != stored.rawSize)
+            return std::nullopt;
+
+        text.append(PageSuffix);
+
+        auto parsed = StatusParser::parse(text);
+        if (!parsed.has_value() || !parsed->dynamicAnalysisResults.has_value() || parsed->dynamicAnalysisResults->size() != traceCount)
+            return std::nullopt;
+
+        Page result;
+        result.traces  = std::move(*parsed->dynamicAnalysisResults);
+        result.strings = std::move(parsed->strings);
+
+        if (buildIndices) {
+            for (const auto &trace : result.traces)
+                result.indices.emplace_back(trace, result.strings);
+        }
+
+        return result;
+    }
+
+    bool ReportPages::fetchPage(u32 page) const {
+        if (this->m_remoteUuid.empty())
+            return false;
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        const auto status = MalcoreApi::getStatusPage(this->m_remoteUuid, page);
+        if (!status.has_value())
+            return false;
+
+        // The page is kept compressed just like a locally split one, so it's decoded and stored the same way
+        const auto layout = scan(*status);
+        if (!layout.has_value() || layout->entryPoints.size() != this->getTraceCount(page))
+            return false;
+
+        std::string buffer;
+        auto stored = compressEntryPoints(*status, layout->entryPoints, buffer);
+        if (!stored.has_value())
+            return false;
+
+        hex::log::debug("Fetched page {} of Malcore traces ({} bytes) in {:.3f}s", page, status->size(), std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+
+        const std::array callSites = { collectCallSites(layout->entryPoints) };
+
+        std::scoped_lock lock(this->m_pagesMutex);
+
+        // Somebody else might have fetched the same page in the meantime
+        auto &target = this->m_pages[page];
+        if (target.data.empty()) {
+            target.rawSize = stored->rawSize;
+            target.data    = std::move(stored->data);
+            mergeCallSites(this->m_callSites, callSites);
+        }
+
+        return true;
+    }
+
+    bool ReportPages::beginLoading(u32 page) const {
+        std::scoped_lock lock(this->m_cacheMutex);
+
+        const bool cached = std::any_of(this->m_cache.begin(), this->m_cache.end(), [page](const CachedPage &cached) { return cached.page == page; });
+        if (cached)
+            return false;
+
+        return this->m_loading.insert(page).second;
+    }
+
+    void ReportPages::insert(u32 page, std::shared_ptr<const Page> data) const {
+        std::scoped_lock lock(this->m_cacheMutex);
+
+        const auto now = std::chrono::steady_clock::now();
+
+        this->m_loading.erase(page);
+
+        // Somebody else might have decoded the same page in the meantime
+        const bool cached = std::any_of(this->m_cache.begin(), this->m_cache.end(), [page](const CachedPage &cached) { return cached.page == page; });
+        if (!cached)
+            this->m_cache.push_back({ page, std::move(data), now });
+
+        while (this->m_cache.size() > MaxCachedPages) {
+            const auto oldest = std::min_element(this->m_cache.begin(), this->m_cache.end(), [](const CachedPage &a, const CachedPage &b) {
+                return a.lastUse < b.lastUse;
+            });
+
+            // Pages that are on screen get touched every frame. Those are never evicted, even if more of them are open than fit
+            if (now - oldest->lastUse < std::chrono::seconds(1))
+                break;
+
+            this->m_cache.erase(oldest);
+        }
+    }
+
+}
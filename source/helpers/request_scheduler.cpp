@@ -0,0 +1,156 @@
+#include <helpers/request_scheduler.hpp>
+
+#include <hex/helpers/logger.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace mal::hlp {
+
+    MalcoreRequest::Result RequestScheduler::execute(MalcoreRequest &request, Priority priority, std::stop_token stopToken) {
+        MalcoreRequest::Result result;
+
+        for (u32 attempt = 0; attempt < MaxAttempts; attempt++) {
+            if (!acquire(priority, stopToken))
+                return { };
+
+            result = request.execute();
+            if (stopToken.stop_requested() || !isRetryable(request, result) || attempt + 1 == MaxAttempts)
+                break;
+
+            const auto delay = getBackoff(attempt, result);
+            s_retried += 1;
+
+            if (result.statusCode == 429) {
+                s_throttled += 1;
+                hex::log::warn("Malcore API is throttling requests, pausing all requests for {:.1f}s", std::chrono::duration<double>(delay).count());
+
+                // The quota is shared, so nobody else should try either until the server is ready again
+                {
+                    std::scoped_lock lock(s_mutex);
+                    s_pausedUntil = std::max(s_pausedUntil, Clock::now() + delay);
+                }
+            } else {
+                hex::log::warn("Malcore request failed with status {}, retrying in {:.1f}s", result.statusCode, std::chrono::duration<double>(delay).count());
+
+                std::mutex mutex;
+                std::condition_variable_any wakeUp;
+
+                std::unique_lock lock(mutex);
+                wakeUp.wait_for(lock, stopToken, delay, [] { return false; });
+            }
+        }
+
+        return result;
+    }
+
+    void RequestScheduler::setRateLimit(u32 requestsPerMinute, u32 burst) {
+        {
+            std::scoped_lock lock(s_mutex);
+
+            s_rate   = requestsPerMinute / 60.0;
+            s_burst  = std::max<u32>(burst, 1);
+            s_tokens = std::min(s_tokens, s_burst);
+            s_generation += 1;
+        }
+
+        s_tokenAvailable.notify_all();
+    }
+
+    RequestScheduler::Counters RequestScheduler::getCounters() {
+        Counters counters;
+        {
+            std::scoped_lock lock(s_mutex);
+            counters.queued = std::accumulate(s_waiting.begin(), s_waiting.end(), u64(0));
+        }
+
+        counters.retried   = s_retried;
+        counters.throttled = s_throttled;
+
+        return counters;
+    }
+
+    bool RequestScheduler::acquire(Priority priority, std::stop_token stopToken) {
+        std::unique_lock lock(s_mutex);
+
+        auto &waiting = s_waiting[size_t(priority)];
+        waiting += 1;
+
+        bool acquired = false;
+        while (!stopToken.stop_requested()) {
+            const auto now = Clock::now();
+            refill(now);
+
+            // Tokens only go to the most important requests that are waiting
+            const bool preempted = std::any_of(s_waiting.begin(), s_waiting.begin() + size_t(priority), [](u32 count) { return count > 0; });
+            const bool limited   = s_rate > 0;
+
+            if (!preempted && now >= s_pausedUntil && (!limited || s_tokens >= 1.0)) {
+                if (limited)
+                    s_tokens -= 1.0;
+
+                acquired = true;
+                break;
+            }
+
+            auto wakeUpTime = now + std::chrono::seconds(1);
+            if (now < s_pausedUntil)
+                wakeUpTime = s_pausedUntil;
+            else if (!preempted && limited)
+                wakeUpTime = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((1.0 - s_tokens) / s_rate));
+
+            // Wake up early whenever somebody left the queue or the limit changed
+            const auto generation = s_generation;
+            s_tokenAvailable.wait_until(lock, stopToken, wakeUpTime, [generation] { return s_generation != generation; });
+        }
+
+        waiting -= 1;
+        s_generation += 1;
+        lock.unlock();
+
+        // Requests of lower priority might have been waiting for this one to leave
+        s_tokenAvailable.notify_all();
+
+        return acquired;
+    }
+
+    void RequestScheduler::refill(Clock::time_point now) {
+        const std::chrono::duration<double> elapsed = now - s_lastRefill;
+        s_lastRefill = now;
+
+        s_tokens = std::min(s_burst, s_tokens + elapsed.count() * s_rate);
+    }
+
+    bool RequestScheduler::isRetryable(const MalcoreRequest &request, const MalcoreRequest::Result &result) {
+        // Uploads create a new analysis every time they get through, so they're only sent again if the server can't have
+        // accepted them. Anything else, like a dropped connection halfway through the transfer, is left to the caller
+        if (!request.isIdempotent())
+            return result.connectFailed || result.statusCode == 429 || (result.statusCode == 503 && result.retryAfter.has_value());
+
+        switch (result.statusCode) {
+            case 0:     // Connection failures and timeouts
+            case 408:
+            case 429:
+            case 500:
+            case 502:
+            case 503:
+            case 504:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    RequestScheduler::Clock::duration RequestScheduler::getBackoff(u32 attempt, const MalcoreRequest::Result &result) {
+        if (result.retryAfter.has_value())
+            return std::min<Clock::duration>(*result.retryAfter, MaxRetryAfter);
+
+        thread_local std::mt19937 random(std::random_device{}());
+        std::uniform_real_distribution<double> jitter(0.75, 1.25);
+
+        const auto backoff = std::min<Clock::duration>(InitialBackoff * (1 << attempt), MaxBackoff);
+        return std::chrono::duration_cast<Clock::duration>(backoff * jitter(random));
+    }
+
+}
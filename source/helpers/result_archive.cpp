@@ -0,0 +1,323 @@
+#include <helpers/result_archive.hpp>
+#include <helpers/report_pages.hpp>
+
+#include <bit>
+#include <cstring>
+
+namespace mal::hlp {
+
+    namespace {
+
+        class Writer {
+        public:
+            template<std::unsigned_integral T>
+            void write(T value) {
+                for (size_t i = 0; i < sizeof(T); i++)
+                    this->m_data.push_back(u8(value >> (i * 8)));
+            }
+
+            void write(float value) {
+                this->write(std::bit_cast<u32>(value));
+            }
+
+            void write(std::string_view string) {
+                this->write(u32(string.size()));
+                this->m_data.insert(this->m_data.end(), string.begin(), string.end());
+            }
+
+            void write(std::span<const u8> bytes) {
+                this->write(u64(bytes.size()));
+                this->m_data.insert(this->m_data.end(), bytes.begin(), bytes.end());
+            }
+
+            std::vector<u8> &&get() {
+                return std::move(this->m_data);
+            }
+
+        private:
+            std::vector<u8> m_data;
+        };
+
+        /**
+         * @brief Bounds checked reader for the encoded data
+         * Reading past the end marks the reader as failed and yields zeros from then on, so decoders only need to check once at the end
+         */
+        class Reader {
+        public:
+            explicit Reader(std::span<const u8> data) : m_data(data) { }
+
+            template<std::unsigned_integral T>
+            T read() {
+                if (!this->ensure(sizeof(T)))
+                    return 0;
+
+                T value = 0;
+                for (size_t i = 0; i < sizeof(T); i++)
+                    value |= T(this->m_data[this->m_offset + i]) << (i * 8);
+                this->m_offset += sizeof(T);
+
+                return value;
+            }
+
+            float readFloat() {
+                return std::bit_cast<float>(this->read<u32>());
+            }
+
+            std::string readString() {
+                const auto size = this->read<u32>();
+                if (!this->ensure(size))
+                    return { };
+
+                std::string result(reinterpret_cast<const char*>(this->m_data.data() + this->m_offset), size);
+                this->m_offset += size;
+
+                return result;
+            }
+
+            std::vector<u8> readBytes() {
+                const auto size = this->read<u64>();
+                if (!this->ensure(size))
+                    return { };
+
+                std::vector<u8> result(this->m_data.begin() + this->m_offset, this->m_data.begin() + this->m_offset + size);
+                this->m_offset += size;
+
+                return result;
+            }
+
+            /**
+             * @brief Reads an element count and checks that at least that many elements of a minimum size can follow
+             * Keeps corrupted counts from reserving huge amounts of memory
+             */
+            u32 readCount(size_t minElementSize) {
+                const auto count = this->read<u32>();
+                if (!this->ensure(u64(count) * minElementSize))
+                    return 0;
+
+                return count;
+            }
+
+            bool readHeader(u32 magic, u16 version) {
+                return this->read<u32>() == magic && this->read<u16>() == version && !this->m_failed;
+            }
+
+            [[nodiscard]] bool isValid() const {
+                return !this->m_failed;
+            }
+
+            [[nodiscard]] bool isAtEnd() const {
+                return this->m_offset == this->m_data.size();
+            }
+
+        private:
+            bool ensure(u64 size) {
+                if (this->m_failed || size > this->m_data.size() - this->m_offset)
+                    this->m_failed = true;
+
+                return !this->m_failed;
+            }
+
+            std::span<const u8> m_data;
+            size_t m_offset = 0;
+            bool m_failed = false;
+        };
+
+        enum SummaryFlags : u8 {
+            HasThreatScore         = 1 << 0,
+            HasPackerInformation   = 1 << 1,
+            HasInterestingStrings  = 1 << 2,
+            HasDynamicAnalysis     = 1 << 3
+        };
+
+        constexpr size_t MatchRecordSize    = sizeof(u64) + sizeof(u32) + sizeof(u8);
+        constexpr size_t PageRecordSize     = sizeof(u32) + sizeof(u64) * 2;
+        constexpr size_t CallSiteRecordSize = sizeof(u64) + sizeof(u32) * 2;
+
+    }
+
+    std::vector<u8> ResultArchive::encodeSummary(const MalcoreApi::AnalysisResult &result, std::span<const std::vector<StringLocator::Match>> stringMatches, std::span<const TraceHeader> traces) {
+        Writer writer;
+        writer.write(SummaryMagic);
+        writer.write(SummaryVersion);
+
+        u8 flags = 0;
+        if (result.threatScore.has_value())        flags |= HasThreatScore;
+        if (result.packerInformation.has_value())  flags |= HasPackerInformation;
+        if (result.interestingStrings.has_value()) flags |= HasInterestingStrings;
+        if (!traces.empty())                       flags |= HasDynamicAnalysis;
+        writer.write(flags);
+
+        if (result.threatScore.has_value()) {
+            writer.write(result.threatScore->score);
+            writer.write(u32(result.threatScore->signatures.size()));
+            for (const auto &[title, description, discovered] : result.threatScore->signatures) {
+                writer.write(title);
+                writer.write(description);
+                writer.write(discovered);
+            }
+        }
+
+        if (result.packerInformation.has_value()) {
+            writer.write(result.packerInformation->name);
+            writer.write(result.packerInformation->confidence);
+        }
+
+        if (result.interestingStrings.has_value()) {
+            const auto &strings = *result.interestingStrings;
+
+            writer.write(u32(strings.size()));
+            for (u32 i = 0; i < strings.size(); i++) {
+                writer.write(strings[i]);
+
+                const auto matchCount = i < stringMatches.size() ? stringMatches[i].size() : 0;
+                writer.write(u32(matchCount));
+                for (size_t j = 0; j < matchCount; j++) {
+                    const auto &match = stringMatches[i][j];
+                    writer.write(match.offset);
+                    writer.write(match.size);
+                    writer.write(u8(match.encoding));
+                }
+            }
+        }
+
+        if (!traces.empty()) {
+            writer.write(u32(traces.size()));
+            for (const auto &trace : traces) {
+                writer.write(trace.hash);
+                writer.write(trace.apiCount);
+            }
+        }
+
+        return writer.get();
+    }
+
+    std::optional<ResultArchive::Summary> ResultArchive::decodeSummary(std::span<const u8> data) {
+        Reader reader(data);
+        if (!reader.readHeader(SummaryMagic, SummaryVersion))
+            return std::nullopt;
+
+        Summary summary;
+        auto &result = summary.result;
+
+        const auto flags = reader.read<u8>();
+
+        if (flags & HasThreatScore) {
+            auto &threatScore = result.threatScore.emplace();
+            threatScore.score = reader.readFloat();
+
+            const auto count = reader.readCount(sizeof(u32) * 3);
+            threatScore.signatures.reserve(count);
+            for (u32 i = 0; i < count; i++) {
+                auto title       = reader.readString();
+                auto description = reader.readString();
+                auto discovered  = reader.readString();
+                threatScore.signatures.push_back({ std::move(title), std::move(description), std::move(discovered) });
+            }
+        }
+
+        if (flags & HasPackerInformation) {
+            auto name = reader.readString();
+            result.packerInformation = MalcoreApi::PackerInformation { std::move(name), reader.read<u32>() };
+        }
+
+        if (flags & HasInterestingStrings) {
+            auto &strings = result.interestingStrings.emplace();
+
+            const auto count = reader.readCount(sizeof(u32) * 2);
+            strings.reserve(count);
+            summary.stringMatches.resize(count);
+            for (u32 i = 0; i < count; i++) {
+                strings.push_back(reader.readString());
+
+                const auto matchCount = reader.readCount(MatchRecordSize);
+                auto &matches = summary.stringMatches[i];
+                matches.reserve(matchCount);
+                for (u32 j = 0; j < matchCount; j++) {
+                    const auto offset   = reader.read<u64>();
+                    const auto size     = reader.read<u32>();
+                    const auto encoding = reader.read<u8>();
+                    if (encoding > u8(StringLocator::Encoding::UTF16LE))
+                        return std::nullopt;
+
+                    matches.push_back({ offset, size, StringLocator::Encoding(encoding) });
+                }
+            }
+        }
+
+        if (flags & HasDynamicAnalysis) {
+            const auto count = reader.readCount(sizeof(u32) * 2);
+            summary.traces.reserve(count);
+            for (u32 i = 0; i < count; i++) {
+                auto hash = reader.readString();
+                summary.traces.push_back({ std::move(hash), reader.read<u32>() });
+            }
+        }
+
+        if (!reader.isValid() || !reader.isAtEnd())
+            return std::nullopt;
+
+        return summary;
+    }
+
+    std::vector<u8> ResultArchive::encodeTraces(const ReportPages &pages) {
+        Writer writer;
+        writer.write(TracesMagic);
+        writer.write(TracesVersion);
+
+        writer.write(std::string_view(pages.getRemoteUuid()));
+
+        writer.write(u32(pages.getPageCount()));
+        for (const auto &page : pages.getStoredPages()) {
+            writer.write(page.firstTrace);
+            writer.write(page.rawSize);
+            writer.write(std::span<const u8>(page.data));
+        }
+
+        const auto callSites = pages.getCallSites();
+        writer.write(u32(callSites.names.size()));
+        for (const auto &name : callSites.names)
+            writer.write(std::string_view(name));
+
+        writer.write(u32(callSites.sites.size()));
+        for (const auto &site : callSites.sites) {
+            writer.write(site.pc);
+            writer.write(site.name);
+            writer.write(site.count);
+        }
+
+        return writer.get();
+    }
+
+    std::optional<ReportPages> ResultArchive::decodeTraces(std::span<const u8> data, std::vector<TraceHeader> traces) {
+        Reader reader(data);
+        if (!reader.readHeader(TracesMagic, TracesVersion))
+            return std::nullopt;
+
+        auto remoteUuid = reader.readString();
+
+        std::vector<ReportPages::StoredPage> pages(reader.readCount(PageRecordSize));
+        for (auto &page : pages) {
+            page.firstTrace = reader.read<u32>();
+            page.rawSize    = reader.read<u64>();
+            page.data       = reader.readBytes();
+        }
+
+        ReportPages::CallSites callSites;
+        callSites.names.resize(reader.readCount(sizeof(u32)));
+        for (auto &name : callSites.names)
+            name = reader.readString();
+
+        callSites.sites.resize(reader.readCount(CallSiteRecordSize));
+        for (auto &site : callSites.sites) {
+            site.pc    = reader.read<u64>();
+            site.name  = reader.read<u32>();
+            site.count = reader.read<u32>();
+        }
+
+        if (!reader.isValid() || !reader.isAtEnd())
+            return std::nullopt;
+
+        return ReportPages::fromStoredPages(std::move(traces), std::move(pages), std::move(callSites), std::move(remoteUuid));
+    }
+
+}
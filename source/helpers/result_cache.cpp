@@ -0,0 +1,183 @@
+#include <helpers/result_cache.hpp>
+
+#include <hex/helpers/crypto.hpp>
+#include <hex/helpers/fs.hpp>
+#include <hex/helpers/logger.hpp>
+#include <hex/helpers/utils.hpp>
+
+#include <nlohmann/json.hpp>
+#include <wolv/io/file.hpp>
+#include <wolv/utils/string.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <vector>
+
+namespace mal::hlp {
+
+    std::optional<ResultCache::Entry> ResultCache::get(const Hash &digest, u64 uploadLimit) {
+        if (s_forceRefresh)
+            return std::nullopt;
+
+        std::scoped_lock lock(s_mutex);
+
+        auto folder = getCacheFolder();
+        if (!folder.has_value())
+            return std::nullopt;
+
+        const auto path = *folder / getEntryName(digest, uploadLimit);
+
+        std::error_code error;
+        if (!std::fs::exists(path, error))
+            return std::nullopt;
+
+        if (isExpired(path)) {
+            std::fs::remove(path, error);
+            return std::nullopt;
+        }
+
+        wolv::io::File file(path, wolv::io::File::Mode::Read);
+        if (!file.isValid())
+            return std::nullopt;
+
+        // Entries start with the SHA-256 of the data and the size of the status response on their own lines. The status itself
+        // was validated when it was stored, so reading it back only needs to check that nothing got cut off
+        auto content = file.readString();
+
+        Entry entry;
+        const auto hash = content.size() > HashLength && content[HashLength] == '\n' ? hex::crypt::decode16(content.substr(0, HashLength)) : std::vector<u8>();
+        if (hash.size() == entry.hash.size())
+            std::copy(hash.begin(), hash.end(), entry.hash.begin());
+
+        const auto sizeEnd = content.find('\n', HashLength + 1);
+
+        u64 statusSize = 0;
+        bool valid = hash.size() == entry.hash.size() && sizeEnd != std::string::npos;
+        if (valid) {
+            const auto [end, errorCode] = std::from_chars(content.data() + HashLength + 1, content.data() + sizeEnd, statusSize);
+            valid = errorCode == std::errc() && end == content.data() + sizeEnd && content.size() - sizeEnd - 1 == statusSize;
+        }
+
+        if (!valid) {
+            hex::log::warn("Discarding corrupted Malcore cache entry '{}'", wolv::util::toUTF8String(path));
+
+            file.close();
+            std::fs::remove(path, error);
+
+            return std::nullopt;
+        }
+
+        entry.status = content.substr(sizeEnd + 1);
+
+        return entry;
+    }
+
+    void ResultCache::store(const Hash &digest, u64 uploadLimit, const Hash &hash, std::string_view status) {
+        // Only valid responses make it into the cache, so entries don't need to be validated again every time they're read
+        if (!nlohmann::json::accept(status)) {
+            hex::log::warn("Not caching invalid Malcore status response");
+            return;
+        }
+
+        std::scoped_lock lock(s_mutex);
+
+        auto folder = getCacheFolder();
+        if (!folder.has_value())
+            return;
+
+        {
+            wolv::io::File file(*folder / getEntryName(digest, uploadLimit), wolv::io::File::Mode::Create);
+            if (!file.isValid()) {
+                hex::log::error("Failed to create Malcore cache entry");
+                return;
+            }
+
+            file.writeString(hex::crypt::encode16({ hash.begin(), hash.end() }) + '\n' + std::to_string(status.size()) + '\n');
+            file.writeBuffer(reinterpret_cast<const u8*>(status.data()), status.size());
+        }
+
+        evict(*folder);
+    }
+
+    void ResultCache::clear() {
+        std::scoped_lock lock(s_mutex);
+
+        auto folder = getCacheFolder();
+        if (!folder.has_value())
+            return;
+
+        std::error_code error;
+        for (const auto &entry : std::fs::directory_iterator(*folder, error))
+            std::fs::remove(entry.path(), error);
+    }
+
+    std::optional<std::fs::path> ResultCache::getCacheFolder() {
+        for (const auto &path : hex::fs::getDefaultPaths(hex::fs::ImHexPath::Config)) {
+            const auto folder = path / "malcore" / "cache";
+
+            std::error_code error;
+            std::fs::create_directories(folder, error);
+            if (!error && hex::fs::isPathWritable(folder))
+                return folder;
+        }
+
+        return std::nullopt;
+    }
+
+    std::string ResultCache::getEntryName(const Hash &digest, u64 uploadLimit) {
+        return hex::format("{}_{:X}{}", hex::crypt::encode16({ digest.begin(), digest.end() }), uploadLimit, EntryExtension);
+    }
+
+    bool ResultCache::isExpired(const std::fs::path &path) {
+        std::error_code error;
+        const auto lastWrite = std::fs::last_write_time(path, error);
+        if (error)
+            return true;
+
+        return std::fs::file_time_type::clock::now() - lastWrite > s_maxAge.load();
+    }
+
+    void ResultCache::evict(const std::fs::path &folder) {
+        struct Entry {
+            std::fs::path path;
+            std::fs::file_time_type lastWrite;
+            u64 size;
+        };
+
+        std::vector<Entry> entries;
+        u64 totalSize = 0;
+
+        std::error_code error;
+        for (const auto &entry : std::fs::directory_iterator(folder, error)) {
+            if (!entry.is_regular_file(error))
+                continue;
+
+            // Entries of older versions used a different format, they'd only be discarded when read anyway
+            if (entry.path().extension() != EntryExtension || isExpired(entry.path())) {
+                std::fs::remove(entry.path(), error);
+                continue;
+            }
+
+            const auto size = entry.file_size(error);
+            entries.push_back({ entry.path(), entry.last_write_time(error), size });
+            totalSize += size;
+        }
+
+        if (totalSize <= s_maxSize)
+            return;
+
+        // Drop the oldest entries first until the cache fits into the configured size again
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+            return a.lastWrite < b.lastWrite;
+        });
+
+        for (const auto &entry : entries) {
+            if (totalSize <= s_maxSize)
+                break;
+
+            std::fs::remove(entry.path, error);
+            totalSize -= entry.size;
+        }
+    }
+
+}
@@ -0,0 +1,109 @@
+#include <helpers/sample_source.hpp>
+#include <helpers/hash_tree.hpp>
+
+#include <wolv/io/file.hpp>
+#include <wolv/literals.hpp>
+#include <wolv/utils/string.hpp>
+
+#include <mbedtls/sha256.h>
+#include <mbedtls/version.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if MBEDTLS_VERSION_MAJOR <= 2
+    #define mbedtls_sha256_starts mbedtls_sha256_starts_ret
+    #define mbedtls_sha256_update mbedtls_sha256_update_ret
+    #define mbedtls_sha256_finish mbedtls_sha256_finish_ret
+#endif
+
+namespace mal::hlp {
+
+    using namespace wolv::literals;
+
+    SampleSource SampleSource::fromProvider(hex::prv::Provider *provider, hex::Region region) {
+        return {
+            provider->getName(),
+            region.getSize(),
+            [provider, address = region.getStartAddress()](u64 offset, u8 *buffer, size_t size) {
+                provider->read(address + offset, buffer, size);
+            }
+        };
+    }
+
+    SampleSource SampleSource::fromProvider(hex::prv::Provider *provider) {
+        return fromProvider(provider, { provider->getBaseAddress(), provider->getActualSize() });
+    }
+
+    std::optional<SampleSource> SampleSource::fromFile(const std::fs::path &path) {
+        struct OpenFile {
+            explicit OpenFile(const std::fs::path &path) : file(path, wolv::io::File::Mode::Read) { }
+
+            wolv::io::File file;
+            std::mutex mutex;
+        };
+
+        auto openFile = std::make_shared<OpenFile>(path);
+        if (!openFile->file.isValid())
+            return std::nullopt;
+
+        const auto fileSize = openFile->file.getSize();
+
+        return SampleSource {
+            wolv::util::toUTF8String(path.filename()),
+            fileSize,
+            [openFile](u64 offset, u8 *buffer, size_t size) {
+                std::scoped_lock lock(openFile->mutex);
+
+                openFile->file.seek(offset);
+                openFile->file.readBuffer(buffer, size);
+            }
+        };
+    }
+
+    SampleSource SampleSource::fromReader(std::string name, u64 size, Reader reader) {
+        return { std::move(name), size, std::move(reader) };
+    }
+
+    SampleSource::Hash SampleSource::calculateHash(u64 limit) const {
+        if (this->m_hasher) {
+            if (auto hash = this->m_hasher(limit); hash.has_value())
+                return *hash;
+        }
+
+        Hash result = { };
+
+        mbedtls_sha256_context ctx;
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_starts(&ctx, 0);
+
+        const auto size = std::min(this->m_size, limit);
+        std::vector<u8> buffer(std::min<u64>(size, 1_MiB));
+        for (u64 offset = 0; offset < size; offset += buffer.size()) {
+            const auto readSize = std::min<u64>(buffer.size(), size - offset);
+
+            this->read(offset, buffer.data(), readSize);
+            mbedtls_sha256_update(&ctx, buffer.data(), readSize);
+        }
+
+        mbedtls_sha256_finish(&ctx, result.data());
+        mbedtls_sha256_free(&ctx);
+
+        return result;
+    }
+
+    std::optional<SampleSource::Hash> SampleSource::calculateDigest(u64 limit, std::stop_token stopToken) const {
+        if (this->m_digester)
+            return this->m_digester(limit, stopToken);
+
+        HashTree tree;
+        tree.resize(std::min(this->m_size, limit));
+        if (!tree.update(*this, stopToken))
+            return std::nullopt;
+
+        return tree.getRoot();
+    }
+
+}
@@ -0,0 +1,351 @@
+#include <helpers/status_parser.hpp>
+
+#include <hex/helpers/logger.hpp>
+
+#include <cstdlib>
+
+namespace mal::hlp {
+
+    std::optional<MalcoreApi::AnalysisResult> StatusParser::parse(std::string_view status) {
+        StatusParser parser(false);
+        if (!nlohmann::json::sax_parse(status.begin(), status.end(), &parser))
+            return std::nullopt;
+
+        parser.m_result.strings.freeze();
+
+        return std::move(parser.m_result);
+    }
+
+    std::optional<bool> StatusParser::isFinished(std::string_view status) {
+        StatusParser parser(true);
+
+        // The parser aborts on its own as soon as it has seen the message type, so a failed parse isn't an error by itself
+        nlohmann::json::sax_parse(status.begin(), status.end(), &parser);
+
+        if (!parser.m_messageType.has_value())
+            return std::nullopt;
+
+        return *parser.m_messageType == "success";
+    }
+
+    bool StatusParser::null() {
+        return this->scalar("null");
+    }
+
+    bool StatusParser::boolean(bool value) {
+        return this->scalar(value ? "true" : "false");
+    }
+
+    bool StatusParser::number_integer(number_integer_t value) {
+        return this->scalar(std::to_string(value));
+    }
+
+    bool StatusParser::number_unsigned(number_unsigned_t value) {
+        return this->scalar(std::to_string(value));
+    }
+
+    bool StatusParser::number_float(number_float_t, const string_t &string) {
+        return this->scalar(string);
+    }
+
+    bool StatusParser::string(string_t &value) {
+        if (this->isCapturing())
+            return this->scalar(nlohmann::json(value).dump());
+
+        const bool keepGoing = this->value(value);
+        this->advance();
+
+        return keepGoing;
+    }
+
+    bool StatusParser::binary(binary_t &) {
+        return this->scalar("null");
+    }
+
+    bool StatusParser::start_object(std::size_t) {
+        const auto node = this->enter(false);
+        if (node == Node::Discovered)
+            this->capture("{");
+
+        this->advance();
+        this->m_stack.push_back({ node, false });
+
+        return true;
+    }
+
+    bool StatusParser::key(string_t &value) {
+        auto &top = this->m_stack.back();
+        if (top.node == Node::Discovered) {
+            if (top.elements > 0)
+                this->m_discovered->push_back(',');
+
+            this->m_discovered->append(nlohmann::json(value).dump());
+            this->m_discovered->push_back(':');
+
+            top.elements += 1;
+        }
+
+        this->m_key = std::move(value);
+
+        return true;
+    }
+
+    bool StatusParser::end_object() {
+        const auto top = this->m_stack.back();
+        this->m_stack.pop_back();
+
+        switch (top.node) {
+            case Node::Discovered:
+                this->m_discovered->push_back('}');
+                break;
+            case Node::Api: {
+                auto &trace = this->m_result.dynamicAnalysisResults->back();
+                auto &api = trace.apis.back();
+                api.argumentCount = trace.arguments.size() - api.firstArgument;
+                break;
+            }
+            case Node::EntryPoint: {
+                auto &trace = this->m_result.dynamicAnalysisResults->back();
+                trace.apis.shrink_to_fit();
+                trace.arguments.shrink_to_fit();
+                break;
+            }
+            default:
+                break;
+        }
+
+        return true;
+    }
+
+    bool StatusParser::start_array(std::size_t) {
+        const auto node = this->enter(true);
+        if (node == Node::Discovered)
+            this->capture("[");
+
+        this->advance();
+        this->m_stack.push_back({ node, true });
+
+        return true;
+    }
+
+    bool StatusParser::end_array() {
+        if (this->m_stack.back().node == Node::Discovered)
+            this->m_discovered->push_back(']');
+
+        this->m_stack.pop_back();
+
+        return true;
+    }
+
+    bool StatusParser::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &exception) {
+        hex::log::error("Failed to parse Malcore status response: {}", exception.what());
+
+        return false;
+    }
+
+    StatusParser::Node StatusParser::enter(bool isArray) {
+        if (this->m_stack.empty())
+            return isArray ? Node::Skip : Node::Root;
+
+        const auto &parent = this->m_stack.back();
+        const auto &key    = this->m_key;
+
+        switch (parent.node) {
+            using enum Node;
+
+            case Root:
+                if (isArray && key == "messages")
+                    return Messages;
+                if (!isArray && key == "data" && !this->m_statusOnly)
+                    return Data;
+                break;
+            case Messages:
+                if (!isArray && parent.elements == 0)
+                    return FirstMessage;
+                break;
+            case Data:
+                if (!isArray && key == "threat_score")
+                    return ThreatScore;
+                if (isArray && key == "packer_information")
+                    return PackerList;
+                if (!isArray && key == "interesting_strings")
+                    return InterestingStrings;
+                if (!isArray && key == "dynamic_analysis")
+                    return DynamicAnalysis;
+                break;
+            case ThreatScore:
+                if (!isArray && key == "results") {
+                    this->m_result.threatScore.emplace();
+                    return ThreatScoreResults;
+                }
+                break;
+            case ThreatScoreResults:
+                if (isArray && key == "signatures")
+                    return Signatures;
+                break;
+            case Signatures:
+                if (!isArray) {
+                    this->m_discovered = &this->m_result.threatScore->signatures.emplace_back().discovered;
+                    return Signature;
+                }
+                break;
+            case Signature:
+                if (!isArray && key == "info")
+                    return SignatureInfo;
+                if (key == "discovered")
+                    return Discovered;
+                break;
+            case Discovered:
+                return Discovered;
+            case PackerList:
+                if (!isArray && parent.elements == 0) {
+                    this->m_result.packerInformation.emplace();
+                    return Packer;
+                }
+                break;
+            case InterestingStrings:
+                if (isArray && key == "results") {
+                    this->m_result.interestingStrings.emplace();
+                    return InterestingStringList;
+                }
+                break;
+            case DynamicAnalysis:
+                if (isArray && key == "dynamic_analysis") {
+                    this->m_result.dynamicAnalysisResults.emplace();
+                    return DynamicAnalysisList;
+                }
+                break;
+            case DynamicAnalysisList:
+                if (!isArray)
+                    return DynamicAnalysisEntry;
+                break;
+            case DynamicAnalysisEntry:
+                if (isArray && key == "entry_points")
+                    return EntryPoints;
+                break;
+            case EntryPoints:
+                if (!isArray) {
+                    this->m_result.dynamicAnalysisResults->emplace_back();
+                    return EntryPoint;
+                }
+                break;
+            case EntryPoint:
+                if (isArray && key == "apis")
+                    return Apis;
+                break;
+            case Apis:
+                if (!isArray) {
+                    auto &trace = this->m_result.dynamicAnalysisResults->back();
+                    trace.apis.push_back({ .firstArgument = u32(trace.arguments.size()) });
+                    return Api;
+                }
+                break;
+            case Api:
+                if (isArray && key == "args")
+                    return Arguments;
+                break;
+            default:
+                break;
+        }
+
+        return Node::Skip;
+    }
+
+    bool StatusParser::value(string_t &string) {
+        if (this->m_stack.empty())
+            return true;
+
+        const auto &key = this->m_key;
+
+        switch (this->m_stack.back().node) {
+            using enum Node;
+
+            case FirstMessage:
+                if (key == "type") {
+                    this->m_messageType = std::move(string);
+
+                    // That's all that's needed to know if an analysis is still running, stop reading here
+                    if (this->m_statusOnly)
+                        return false;
+                }
+                break;
+            case ThreatScoreResults:
+                if (key == "score")
+                    this->m_result.threatScore->score = std::strtof(string.c_str(), nullptr);
+                break;
+            case SignatureInfo:
+                if (key == "title")
+                    this->m_result.threatScore->signatures.back().title = std::move(string);
+                else if (key == "description")
+                    this->m_result.threatScore->signatures.back().description = std::move(string);
+                break;
+            case Packer:
+                if (key == "packer_name")
+                    this->m_result.packerInformation->name = std::move(string);
+                else if (key == "percent")
+                    this->m_result.packerInformation->confidence = std::strtoul(string.c_str(), nullptr, 10);
+                break;
+            case InterestingStringList:
+                this->m_result.interestingStrings->push_back(std::move(string));
+                break;
+            case EntryPoint:
+                if (key == "apihash")
+                    this->m_result.dynamicAnalysisResults->back().hash = std::move(string);
+                break;
+            case Api: {
+                auto &api = this->m_result.dynamicAnalysisResults->back().apis.back();
+                if (key == "api_name")
+                    api.apiName = this->m_result.strings.intern(string);
+                else if (key == "pc")
+                    api.pcValue = std::strtoull(string.c_str(), nullptr, 16);
+                else if (key == "ret_val")
+                    api.returnValue = this->m_result.strings.intern(string);
+                break;
+            }
+            case Arguments: {
+                // Classify arguments once here so drawing doesn't need to parse every argument each frame
+                char *end = nullptr;
+                std::strtoll(string.c_str(), &end, 0);
+                const bool isNumber = !string.empty() && end != nullptr && *end == '\0';
+
+                this->m_result.dynamicAnalysisResults->back().arguments.push_back({ this->m_result.strings.intern(string), isNumber });
+                break;
+            }
+            default:
+                break;
+        }
+
+        return true;
+    }
+
+    bool StatusParser::scalar(std::string_view text) {
+        if (this->isCapturing())
+            this->capture(text);
+
+        this->advance();
+
+        return true;
+    }
+
+    void StatusParser::advance() {
+        if (!this->m_stack.empty() && this->m_stack.back().isArray)
+            this->m_stack.back().elements += 1;
+    }
+
+    bool StatusParser::isCapturing() const {
+        if (this->m_stack.empty())
+            return false;
+
+        const auto &top = this->m_stack.back();
+        return top.node == Node::Discovered || (top.node == Node::Signature && this->m_key == "discovered");
+    }
+
+    void StatusParser::capture(std::string_view text) {
+        const auto &top = this->m_stack.back();
+        if (top.node == Node::Discovered && top.isArray && top.elements > 0)
+            this->m_discovered->push_back(',');
+
+        this->m_discovered->append(text);
+    }
+
+}
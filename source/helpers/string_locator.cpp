@@ -0,0 +1,89 @@
+#include <helpers/string_locator.hpp>
+
+#include <algorithm>
+
+namespace mal::hlp {
+
+    namespace {
+
+        std::vector<u8> toUtf16LE(std::string_view string) {
+            std::vector<u8> result;
+            result.reserve(string.size() * 2);
+
+            auto append = [&result](u16 unit) {
+                result.push_back(unit & 0xFF);
+                result.push_back(unit >> 8);
+            };
+
+            for (size_t i = 0; i < string.size();) {
+                const u8 lead = string[i];
+
+                u32 codePoint = lead;
+                size_t length = 1;
+                if ((lead & 0xE0) == 0xC0)      { codePoint = lead & 0x1F; length = 2; }
+                else if ((lead & 0xF0) == 0xE0) { codePoint = lead & 0x0F; length = 3; }
+                else if ((lead & 0xF8) == 0xF0) { codePoint = lead & 0x07; length = 4; }
+
+                if (i + length > string.size())
+                    length = string.size() - i;
+
+                for (size_t j = 1; j < length; j++)
+                    codePoint = (codePoint << 6) | (u8(string[i + j]) & 0x3F);
+
+                if (codePoint >= 0x10000) {
+                    codePoint -= 0x10000;
+                    append(0xD800 | (codePoint >> 10));
+                    append(0xDC00 | (codePoint & 0x3FF));
+                } else {
+                    append(codePoint);
+                }
+
+                i += length;
+            }
+
+            return result;
+        }
+
+    }
+
+    StringLocator::StringLocator(std::span<const std::string> strings) : m_stringCount(strings.size()) {
+        std::vector<std::vector<u8>> patterns;
+        for (u32 i = 0; i < strings.size(); i++) {
+            const auto &string = strings[i];
+            if (string.empty())
+                continue;
+
+            patterns.emplace_back(string.begin(), string.end());
+            this->m_patterns.push_back({ i, u32(string.size()), Encoding::ASCII });
+
+            patterns.push_back(toUtf16LE(string));
+            this->m_patterns.push_back({ i, u32(patterns.back().size()), Encoding::UTF16LE });
+        }
+
+        this->m_matcher = PatternMatcher(patterns);
+    }
+
+    std::vector<std::vector<StringLocator::Match>> StringLocator::locate(const SampleSource &sample, std::stop_token stopToken) const {
+        std::vector<std::vector<Match>> result(this->m_stringCount);
+
+        const auto offsets = this->m_matcher.locate(sample, stopToken, MaxMatchesPerString);
+        for (size_t id = 0; id < offsets.size(); id++) {
+            const auto &pattern = this->m_patterns[id];
+            for (const auto offset : offsets[id])
+                result[pattern.string].push_back({ offset, pattern.size, pattern.encoding });
+        }
+
+        // Both encodings of a string are separate patterns, so their matches need to be merged again
+        for (auto &matches : result) {
+            std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+                return a.offset < b.offset;
+            });
+
+            if (matches.size() > MaxMatchesPerString)
+                matches.resize(MaxMatchesPerString);
+        }
+
+        return result;
+    }
+
+}
@@ -0,0 +1,65 @@
+#include <helpers/string_pool.hpp>
+
+#include <functional>
+
+namespace mal::hlp {
+
+    StringPool::StringPool() {
+        this->m_offsets.push_back(0);
+        this->rehash(64);
+
+        this->intern("");
+    }
+
+    StringPool::Id StringPool::intern(std::string_view string) {
+        if (this->m_buckets.empty())
+            this->rehash(this->size() * 2 + 64);
+
+        // Open addressing with linear probing. Buckets only hold ids, the strings themselves live in the shared buffer
+        const auto mask = this->m_buckets.size() - 1;
+        auto bucket = std::hash<std::string_view>()(string) & mask;
+        while (this->m_buckets[bucket] != InvalidBucket) {
+            if (this->get(this->m_buckets[bucket]) == string)
+                return this->m_buckets[bucket];
+
+            bucket = (bucket + 1) & mask;
+        }
+
+        const Id id = this->size();
+        this->m_data.append(string);
+        this->m_offsets.push_back(this->m_data.size());
+        this->m_buckets[bucket] = id;
+
+        if (this->size() * 2 > this->m_buckets.size())
+            this->rehash(this->m_buckets.size() * 2);
+
+        return id;
+    }
+
+    void StringPool::freeze() {
+        this->m_buckets.clear();
+        this->m_buckets.shrink_to_fit();
+
+        this->m_data.shrink_to_fit();
+        this->m_offsets.shrink_to_fit();
+    }
+
+    void StringPool::rehash(size_t bucketCount) {
+        // Keep the bucket count a power of two so probing can mask instead of using a modulo
+        size_t newBucketCount = 1;
+        while (newBucketCount < bucketCount)
+            newBucketCount <<= 1;
+
+        this->m_buckets.assign(newBucketCount, InvalidBucket);
+
+        const auto mask = newBucketCount - 1;
+        for (Id id = 0; id < this->size(); id++) {
+            auto bucket = std::hash<std::string_view>()(this->get(id)) & mask;
+            while (this->m_buckets[bucket] != InvalidBucket)
+                bucket = (bucket + 1) & mask;
+
+            this->m_buckets[bucket] = id;
+        }
+    }
+
+}
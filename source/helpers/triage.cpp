@@ -0,0 +1,343 @@
+#include <helpers/triage.hpp>
+#include <helpers/packer_signatures.hpp>
+#include <helpers/worker_pool.hpp>
+
+#include <hex/helpers/crypto.hpp>
+
+#include <mbedtls/md5.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/version.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if MBEDTLS_VERSION_MAJOR <= 2
+    #define mbedtls_sha256_starts mbedtls_sha256_starts_ret
+    #define mbedtls_sha256_update mbedtls_sha256_update_ret
+    #define mbedtls_sha256_finish mbedtls_sha256_finish_ret
+    #define mbedtls_md5_starts mbedtls_md5_starts_ret
+    #define mbedtls_md5_update mbedtls_md5_update_ret
+    #define mbedtls_md5_finish mbedtls_md5_finish_ret
+#endif
+
+namespace mal::hlp {
+
+    namespace {
+
+        constexpr auto PrintableTable = [] {
+            std::array<bool, 256> table = { };
+            for (u32 c = 0x20; c < 0x7F; c++)
+                table[c] = true;
+            table['\t'] = true;
+
+            return table;
+        }();
+
+        bool isPrintable(u8 byte) {
+            return PrintableTable[byte];
+        }
+
+        /**
+         * @brief One bit per byte of a buffer for each of the byte classes strings are made of
+         */
+        struct ByteClasses {
+            std::vector<u64> printable, zero;
+
+            explicit ByteClasses(std::span<const u8> data) : printable((data.size() + 63) / 64), zero(printable.size()) {
+                // Eight bytes are classified at once, the high bit of each byte lane is set for the bytes in the class
+                constexpr u64 Ones = 0x0101010101010101, High = Ones * 0x80, Low = Ones * 0x7F;
+
+                const auto equalLanes = [](u64 lanes, u8 value) {
+                    const auto difference = lanes ^ (Ones * value);
+                    return ~(((difference & Low) + Low) | difference) & High;
+                };
+
+                // Gathers the high bits of all lanes into the lowest eight bits, in byte order
+                const auto laneBits = [](u64 lanes) {
+                    return ((lanes >> 7) * 0x0102040810204080) >> 56;
+                };
+
+                const auto fullWords = data.size() / 64;
+                for (size_t word = 0; word < fullWords; word++) {
+                    u64 printableBits = 0, zeroBits = 0;
+                    for (size_t lane = 0; lane < 8; lane++) {
+                        u64 lanes;
+                        std::memcpy(&lanes, data.data() + word * 64 + lane * 8, sizeof(lanes));
+                        if constexpr (std::endian::native == std::endian::big)
+                            lanes = std::byteswap(lanes);
+
+                        // Bytes below 0x80 whose low seven bits reach 0x20 without being 0x7F, plus tabs
+                        const auto low7  = lanes & Low;
+                        const auto range = (low7 + Ones * (0x80 - 0x20)) & ~(low7 + Ones * (0x80 - 0x7F)) & ~lanes & High;
+
+                        printableBits |= laneBits(range | equalLanes(lanes, '\t')) << (lane * 8);
+                        zeroBits      |= laneBits(equalLanes(lanes, 0x00)) << (lane * 8);
+                    }
+
+                    this->printable[word] = printableBits;
+                    this->zero[word]      = zeroBits;
+                }
+
+                // The tail that doesn't fill a whole word is classified byte by byte
+                for (size_t i = fullWords * 64; i < data.size(); i++) {
+                    this->printable[i / 64] |= u64(isPrintable(data[i])) << (i % 64);
+                    this->zero[i / 64]      |= u64(data[i] == 0x00) << (i % 64);
+                }
+            }
+
+            /**
+             * @brief Reads the 64 bits of a bitmap that start at a byte position, positions outside of the buffer read as cleared
+             */
+            static u64 bitsAt(const std::vector<u64> &bitmap, i64 position) {
+                const auto word  = position >> 6;
+                const auto shift = u32(position & 63);
+
+                const auto wordAt = [&](i64 index) -> u64 {
+                    return index >= 0 && u64(index) < bitmap.size() ? bitmap[index] : 0;
+                };
+
+                if (shift == 0)
+                    return wordAt(word);
+
+                return (wordAt(word) >> shift) | (wordAt(word + 1) << (64 - shift));
+            }
+
+            /**
+             * @brief Bits of the positions that hold a printable character followed by a zero byte
+             */
+            u64 utf16At(i64 position) const {
+                return bitsAt(this->printable, position) & bitsAt(this->zero, position + 1);
+            }
+        };
+
+        /**
+         * @brief Calls a function with every position of [begin, end) whose bit is set in the mask the word function returns
+         */
+        template<typename WordFunction, typename Callback>
+        void forEachCandidate(u64 begin, u64 end, WordFunction &&wordFunction, Callback &&callback) {
+            for (u64 base = begin & ~u64(63); base < end; base += 64) {
+                auto bits = wordFunction(i64(base));
+
+                if (base < begin)
+                    bits &= ~u64(0) << (begin - base);
+                if (end - base < 64)
+                    bits &= (u64(1) << (end - base)) - 1;
+
+                for (; bits != 0; bits &= bits - 1) {
+                    if (!callback(base + std::countr_zero(bits)))
+                        return;
+                }
+            }
+        }
+
+        /**
+         * @brief Extracts printable ASCII and UTF-16LE runs that start inside [begin, end) of a buffer
+         * The buffer may extend past end so runs crossing into the next chunk can be completed. Runs that already
+         * started before begin belong to the previous chunk and are skipped. Runs long enough to be a string are found
+         * on bitmaps of the buffer 64 bytes at a time, only the strings themselves are walked byte by byte
+         */
+        void extractStrings(std::span<const u8> data, u64 begin, u64 end, u64 baseOffset, std::vector<Triage::String> &strings) {
+            using enum StringLocator::Encoding;
+
+            const ByteClasses classes(data);
+
+            // Starts of printable runs that are followed by enough printable characters to make up a string
+            forEachCandidate(begin, end, [&](i64 position) {
+                auto bits = classes.bitsAt(classes.printable, position) & ~classes.bitsAt(classes.printable, position - 1);
+                for (size_t i = 1; i < Triage::MinStringLength; i++)
+                    bits &= classes.bitsAt(classes.printable, position + i64(i));
+
+                return bits;
+            }, [&](u64 start) {
+                if (strings.size() >= Triage::MaxStrings)
+                    return false;
+
+                auto runEnd = start;
+                while (runEnd < data.size() && isPrintable(data[runEnd]) && runEnd - start < Triage::MaxStringLength)
+                    runEnd += 1;
+
+                strings.push_back({ baseOffset + start, std::string(data.begin() + start, data.begin() + runEnd), ASCII });
+
+                return true;
+            });
+
+            // Same for characters that are each followed by a zero byte, one position past the previous one's zero byte
+            forEachCandidate(begin, end, [&](i64 position) {
+                auto bits = classes.utf16At(position) & ~classes.utf16At(position - 2);
+                for (size_t i = 1; i < Triage::MinStringLength; i++)
+                    bits &= classes.utf16At(position + i64(i * 2));
+
+                return bits;
+            }, [&](u64 start) {
+                if (strings.size() >= Triage::MaxStrings)
+                    return false;
+
+                std::string value;
+                for (auto j = start; j + 1 < data.size() && isPrintable(data[j]) && data[j + 1] == 0x00 && value.size() < Triage::MaxStringLength; j += 2)
+                    value.push_back(char(data[j]));
+
+                strings.push_back({ baseOffset + start, std::move(value), UTF16LE });
+
+                return true;
+            });
+        }
+
+        float calculateEntropy(std::span<const u8> data) {
+            // Runs of the same byte would otherwise wait on the previous increment of the same counter every time
+            std::array<std::array<u32, 256>, 4> partialCounts = { };
+
+            size_t i = 0;
+            for (; i + 4 <= data.size(); i += 4) {
+                partialCounts[0][data[i + 0]] += 1;
+                partialCounts[1][data[i + 1]] += 1;
+                partialCounts[2][data[i + 2]] += 1;
+                partialCounts[3][data[i + 3]] += 1;
+            }
+            for (; i < data.size(); i++)
+                partialCounts[0][data[i]] += 1;
+
+            double entropy = 0;
+            for (u32 byte = 0; byte < 256; byte++) {
+                const auto count = partialCounts[0][byte] + partialCounts[1][byte] + partialCounts[2][byte] + partialCounts[3][byte];
+                if (count == 0)
+                    continue;
+
+                const auto probability = double(count) / data.size();
+                entropy -= probability * std::log2(probability);
+            }
+
+            return float(entropy / 8.0);
+        }
+
+        /**
+         * @brief Streams a whole sample through a hash function
+         */
+        template<typename Update>
+        void hashSample(const SampleSource &sample, std::stop_token stopToken, Update &&update) {
+            const auto size = sample.getSize();
+            std::vector<u8> buffer(std::min<u64>(size, 1_MiB));
+            for (u64 offset = 0; offset < size && !stopToken.stop_requested(); offset += buffer.size()) {
+                const auto readSize = std::min<u64>(buffer.size(), size - offset);
+
+                sample.read(offset, buffer.data(), readSize);
+                update(buffer.data(), readSize);
+            }
+        }
+
+        void calculateSha256(const SampleSource &sample, std::stop_token stopToken, Triage::Result &result) {
+            std::array<u8, 32> sha256 = { };
+
+            mbedtls_sha256_context context;
+            mbedtls_sha256_init(&context);
+            mbedtls_sha256_starts(&context, 0);
+            hashSample(sample, stopToken, [&](const u8 *data, size_t size) { mbedtls_sha256_update(&context, data, size); });
+            mbedtls_sha256_finish(&context, sha256.data());
+            mbedtls_sha256_free(&context);
+
+            result.sha256 = hex::crypt::encode16({ sha256.begin(), sha256.end() });
+        }
+
+        void calculateMd5(const SampleSource &sample, std::stop_token stopToken, Triage::Result &result) {
+            std::array<u8, 16> md5 = { };
+
+            mbedtls_md5_context context;
+            mbedtls_md5_init(&context);
+            mbedtls_md5_starts(&context);
+            hashSample(sample, stopToken, [&](const u8 *data, size_t size) { mbedtls_md5_update(&context, data, size); });
+            mbedtls_md5_finish(&context, md5.data());
+            mbedtls_md5_free(&context);
+
+            result.md5 = hex::crypt::encode16({ md5.begin(), md5.end() });
+        }
+
+    }
+
+    std::optional<Triage::Result> Triage::run(const SampleSource &sample, std::stop_token stopToken) {
+        const auto startTime = std::chrono::steady_clock::now();
+
+        Result result;
+        result.image = ImageInfo::parse(sample);
+
+        const auto size = sample.getSize();
+
+        // Entropy blocks are a power of two so every chunk always holds a whole number of them
+        result.entropyBlockSize = std::max<u64>(4_KiB, std::bit_ceil((size + EntropyBlockCount - 1) / EntropyBlockCount));
+        result.entropy.resize((size + result.entropyBlockSize - 1) / result.entropyBlockSize);
+
+        const auto chunkSize  = std::max<u64>(ChunkSize, result.entropyBlockSize);
+        const auto chunkCount = (size + chunkSize - 1) / chunkSize;
+
+        std::vector<std::vector<String>> chunkStrings(chunkCount);
+        {
+            // Neither hash can be split up, so each gets a participant of its own while the others work through the chunks
+            const auto chunkWorkerCount = std::clamp<u64>(std::max<u32>(WorkerPool::getConcurrency(), 2) - 2, 1, std::max<u64>(chunkCount, 1));
+
+            std::atomic<u64> nextChunk = 0;
+            WorkerPool::run(chunkWorkerCount + 2, [&](u32 participant) {
+                // Once they're done hashing, the hashing participants help out with whatever chunks are left
+                if (participant == 0)
+                    calculateSha256(sample, stopToken, result);
+                else if (participant == 1)
+                    calculateMd5(sample, stopToken, result);
+
+                std::vector<u8> buffer;
+
+                while (!stopToken.stop_requested()) {
+                    const auto chunk = nextChunk++;
+                    if (chunk >= chunkCount)
+                        break;
+
+                    // Read a little bit before and after the chunk so strings can be told apart at the chunk boundaries
+                    const auto start     = chunk * chunkSize;
+                    const auto end       = std::min<u64>(start + chunkSize, size);
+                    const auto readStart = start >= 2 ? start - 2 : 0;
+                    const auto readEnd   = std::min<u64>(end + MaxStringLength * 2, size);
+
+                    buffer.resize(readEnd - readStart);
+                    sample.read(readStart, buffer.data(), buffer.size());
+
+                    const std::span<const u8> data = buffer;
+                    for (auto offset = start; offset < end; offset += result.entropyBlockSize) {
+                        const auto blockSize = std::min<u64>(result.entropyBlockSize, end - offset);
+                        result.entropy[offset / result.entropyBlockSize] = calculateEntropy(data.subspan(offset - readStart, blockSize));
+                    }
+
+                    extractStrings(data, start - readStart, end - readStart, readStart, chunkStrings[chunk]);
+                }
+            });
+        }
+
+        if (stopToken.stop_requested())
+            return std::nullopt;
+
+        for (auto &strings : chunkStrings) {
+            const auto remaining = MaxStrings - result.strings.size();
+            if (strings.size() > remaining) {
+                strings.resize(remaining);
+                result.stringsTruncated = true;
+            }
+
+            std::move(strings.begin(), strings.end(), std::back_inserter(result.strings));
+
+            if (result.stringsTruncated)
+                break;
+        }
+
+        std::sort(result.strings.begin(), result.strings.end(), [](const String &a, const String &b) {
+            return a.offset < b.offset;
+        });
+
+        result.packers = PackerSignatures::scan(sample, result.image, stopToken);
+        if (stopToken.stop_requested())
+            return std::nullopt;
+
+        result.duration = std::chrono::steady_clock::now() - startTime;
+
+        return result;
+    }
+
+}
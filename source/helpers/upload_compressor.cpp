@@ -0,0 +1,165 @@
+#include <helpers/upload_compressor.hpp>
+#include <helpers/worker_pool.hpp>
+
+#include <hex/helpers/logger.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <span>
+
+namespace mal::hlp {
+
+    namespace {
+
+        struct Block {
+            std::vector<u8> data;
+            uLong crc = 0;
+            uLong size = 0;
+            bool valid = false;
+        };
+
+        /**
+         * @brief Deflates a single block as raw deflate data
+         * All blocks but the last one end in a sync flush so they're byte aligned and don't carry the final block marker
+         */
+        bool deflateBlock(std::span<const u8> input, bool last, std::vector<u8> &output) {
+            z_stream stream = { };
+            if (deflateInit2(&stream, UploadCompressor::Level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return false;
+
+            output.resize(deflateBound(&stream, input.size()) + 16);
+
+            stream.next_in   = const_cast<Bytef*>(input.data());
+            stream.avail_in  = input.size();
+            stream.next_out  = output.data();
+            stream.avail_out = output.size();
+
+            const auto flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+            const auto code  = deflate(&stream, flush);
+
+            output.resize(output.size() - stream.avail_out);
+            deflateEnd(&stream);
+
+            return last ? code == Z_STREAM_END : code == Z_OK && stream.avail_in == 0;
+        }
+
+    }
+
+    UploadCompressor::UploadCompressor(SampleSource sample, u64 size, std::stop_token stopToken)
+        : m_sample(std::move(sample)), m_size(size), m_stopToken(std::move(stopToken)), m_blockCount(std::max<u64>((size + BlockSize - 1) / BlockSize, 1)) {
+        this->restart();
+    }
+
+    void UploadCompressor::restart() {
+        // Minimal gzip header: no file name, no modification time, unknown operating system
+        constexpr static std::array<u8, 10> Header = { 0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF };
+
+        this->m_pending.assign(Header.begin(), Header.end());
+        this->m_pendingOffset = 0;
+        this->m_position      = 0;
+        this->m_nextBlock     = 0;
+        this->m_stage         = Stage::Blocks;
+        this->m_crc           = crc32(0, nullptr, 0);
+        this->m_duration      = { };
+    }
+
+    bool UploadCompressor::compressNextBatch() {
+        const auto startTime = std::chrono::steady_clock::now();
+
+        const auto firstBlock = this->m_nextBlock;
+        const auto batchSize  = std::min<u64>(WorkerPool::getConcurrency(), this->m_blockCount - firstBlock);
+        std::vector<Block> blocks(batchSize);
+
+        std::atomic<u64> nextBlock = 0;
+        WorkerPool::run(batchSize, [&](u32) {
+            std::vector<u8> buffer;
+
+            while (!this->m_stopToken.stop_requested()) {
+                const auto index = nextBlock++;
+                if (index >= batchSize)
+                    break;
+
+                const auto offset = (firstBlock + index) * BlockSize;
+                buffer.resize(std::min<u64>(BlockSize, this->m_size - offset));
+                this->m_sample.read(offset, buffer.data(), buffer.size());
+
+                auto &block = blocks[index];
+                block.size  = buffer.size();
+                block.crc   = crc32(0, buffer.data(), buffer.size());
+                block.valid = deflateBlock(buffer, firstBlock + index == this->m_blockCount - 1, block.data);
+            }
+        });
+
+        if (this->m_stopToken.stop_requested())
+            return false;
+
+        this->m_pending.clear();
+        this->m_pendingOffset = 0;
+
+        for (const auto &block : blocks) {
+            if (!block.valid) {
+                hex::log::error("Failed to compress upload payload");
+                return false;
+            }
+
+            this->m_pending.insert(this->m_pending.end(), block.data.begin(), block.data.end());
+            this->m_crc = crc32_combine(this->m_crc, block.crc, block.size);
+        }
+
+        this->m_nextBlock += batchSize;
+        this->m_duration  += std::chrono::steady_clock::now() - startTime;
+
+        return true;
+    }
+
+    std::optional<size_t> UploadCompressor::read(u64 offset, u8 *buffer, size_t size) {
+        if (offset != this->m_position) {
+            // Streams can only be sent again from the start, compressed data that was already handed out isn't kept around
+            if (offset != 0)
+                return std::nullopt;
+
+            this->restart();
+        }
+
+        size_t written = 0;
+        while (written < size) {
+            if (this->m_pendingOffset == this->m_pending.size()) {
+                if (this->m_stage == Stage::Blocks) {
+                    if (!this->compressNextBatch())
+                        return std::nullopt;
+
+                    if (this->m_nextBlock == this->m_blockCount)
+                        this->m_stage = Stage::Trailer;
+                } else if (this->m_stage == Stage::Trailer) {
+                    this->m_pending.clear();
+                    this->m_pendingOffset = 0;
+
+                    for (const auto value : { u32(this->m_crc), u32(this->m_size) }) {
+                        for (u32 i = 0; i < 4; i++)
+                            this->m_pending.push_back((value >> (i * 8)) & 0xFF);
+                    }
+
+                    this->m_stage = Stage::Done;
+                } else {
+                    break;
+                }
+
+                continue;
+            }
+
+            const auto count = std::min(size - written, this->m_pending.size() - this->m_pendingOffset);
+            std::copy_n(this->m_pending.begin() + this->m_pendingOffset, count, buffer + written);
+
+            this->m_pendingOffset += count;
+            written += count;
+        }
+
+        this->m_position += written;
+
+        return written;
+    }
+
+}
@@ -0,0 +1,92 @@
+#include <helpers/worker_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace mal::hlp {
+
+    WorkerPool::WorkerPool() {
+        for (u32 i = 0; i < getConcurrency(); i++) {
+            this->m_workers.emplace_back([this](std::stop_token stopToken) {
+                while (true) {
+                    std::function<void()> job;
+
+                    {
+                        std::unique_lock lock(this->m_queueMutex);
+                        if (!this->m_queueCondVar.wait(lock, stopToken, [this] { return !this->m_queue.empty(); }))
+                            return;
+
+                        job = std::move(this->m_queue.front());
+                        this->m_queue.pop_front();
+                    }
+
+                    job();
+                }
+            });
+        }
+    }
+
+    WorkerPool &WorkerPool::get() {
+        static WorkerPool pool;
+
+        return pool;
+    }
+
+    u32 WorkerPool::getConcurrency() {
+        return std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    void WorkerPool::run(u32 participants, const std::function<void(u32 participant)> &job) {
+        if (participants == 0)
+            return;
+
+        struct State {
+            std::atomic<u32> nextParticipant = 0;
+
+            std::mutex mutex;
+            std::condition_variable finished;
+            u32 finishedCount = 0;
+        };
+
+        auto state = std::make_shared<State>();
+
+        // Helpers that only get to run once everything has been claimed return right away, they never touch the job
+        const auto participate = [state, participants, &job] {
+            u32 count = 0;
+            while (true) {
+                const auto participant = state->nextParticipant++;
+                if (participant >= participants)
+                    break;
+
+                job(participant);
+                count += 1;
+            }
+
+            if (count > 0) {
+                std::scoped_lock lock(state->mutex);
+                state->finishedCount += count;
+                state->finished.notify_all();
+            }
+        };
+
+        auto &pool = get();
+        for (u32 i = 1; i < participants; i++)
+            pool.enqueue(participate);
+
+        participate();
+
+        std::unique_lock lock(state->mutex);
+        state->finished.wait(lock, [&] { return state->finishedCount == participants; });
+    }
+
+    void WorkerPool::enqueue(std::function<void()> job) {
+        {
+            std::scoped_lock lock(this->m_queueMutex);
+            this->m_queue.push_back(std::move(job));
+        }
+
+        this->m_queueCondVar.notify_one();
+    }
+
+}
@@ -0,0 +1,791 @@
+/*
+ * Local stand-in for the Malcore API, used to exercise and benchmark the client without the real service.
+ * It doesn't depend on ImHex at all so it can be started on any machine that runs the benchmarks
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+    using u8  = std::uint8_t;
+    using u32 = std::uint32_t;
+    using u64 = std::uint64_t;
+
+    struct Options {
+        u32 port = 8417;
+
+        // Delay added before every response
+        std::chrono::milliseconds latency = std::chrono::milliseconds(0);
+
+        // Upload bandwidth in bytes per second the server reads request bodies with, 0 for unlimited
+        u64 uploadRate = 0;
+
+        // Number of status polls that report a running analysis before it's finished
+        u32 pendingPolls = 2;
+
+        // Every nth request is throttled with a 429, fails with a 503 or has its connection dropped. 0 disables each of them
+        u32 throttleEvery = 0, failEvery = 0, dropEvery = 0;
+        u32 retryAfter = 1;
+
+        // Number of traces per page of a paged status request
+        u32 pageSize = 16;
+
+        bool lookup = false;
+        bool gzip = false;
+        bool paging = false;
+
+        // Finished status response that's replayed for every analysis, a report of the configured size is generated otherwise
+        std::string report;
+        u32 traceCount = 4, callCount = 1000, stringCount = 100, signatureCount = 10;
+    };
+
+    void printUsage() {
+        std::fputs(
+            "Usage: malcore_mock [options]\n"
+            "Serves the Malcore API endpoints used by the client on localhost\n"
+            "\n"
+            "Options:\n"
+            "  --port <port>            Port to listen on (default: 8417)\n"
+            "  --latency <ms>           Delay added before every response\n"
+            "  --upload-rate <MiB/s>    Bandwidth request bodies are read with, 0 for unlimited\n"
+            "  --pending <count>        Polls that report a running analysis before it's finished (default: 2)\n"
+            "  --throttle-every <n>     Answer every nth request with 429 Too Many Requests\n"
+            "  --retry-after <s>        Retry-After sent with throttled requests (default: 1)\n"
+            "  --fail-every <n>         Answer every nth request with 503 Service Unavailable\n"
+            "  --drop-every <n>         Close the connection of every nth request without answering\n"
+            "  --paging                 Advertise paged status requests, answered with a summary and the traces page by page\n"
+            "  --page-size <count>      Traces per page of paged status requests (default: 16)\n"
+            "  --lookup                 Advertise and answer /lookup with reports of samples that were uploaded before\n"
+            "  --gzip                   Advertise and accept gzip encoded uploads, they're rejected with 415 otherwise\n"
+            "  --report <file>          Replay a recorded status response instead of generating one\n"
+            "  --traces <count>         Traces in a generated report (default: 4)\n"
+            "  --calls <count>          API calls per trace in a generated report (default: 1000)\n"
+            "  --strings <count>        Interesting strings in a generated report (default: 100)\n"
+            "  --signatures <count>     Signatures in a generated report (default: 10)\n",
+            stderr);
+    }
+
+    std::optional<Options> parseArguments(std::span<char*> arguments) {
+        Options options;
+
+        for (size_t i = 0; i < arguments.size(); i++) {
+            const std::string_view argument = arguments[i];
+
+            if (argument == "--lookup") {
+                options.lookup = true;
+                continue;
+            }
+
+            if (argument == "--gzip") {
+                options.gzip = true;
+                continue;
+            }
+
+            if (argument == "--paging") {
+                options.paging = true;
+                continue;
+            }
+
+            if (!argument.starts_with("--") || i + 1 >= arguments.size()) {
+                std::fprintf(stderr, "Invalid argument %s\n", arguments[i]);
+                return std::nullopt;
+            }
+
+            const std::string value = arguments[++i];
+            const auto number = u32(std::strtoul(value.c_str(), nullptr, 10));
+
+            if (argument == "--port")                   options.port = number;
+            else if (argument == "--latency")           options.latency = std::chrono::milliseconds(number);
+            else if (argument == "--upload-rate")       options.uploadRate = u64(number) * 1024 * 1024;
+            else if (argument == "--pending")           options.pendingPolls = number;
+            else if (argument == "--throttle-every")    options.throttleEvery = number;
+            else if (argument == "--retry-after")       options.retryAfter = number;
+            else if (argument == "--fail-every")        options.failEvery = number;
+            else if (argument == "--drop-every")        options.dropEvery = number;
+            else if (argument == "--page-size")         options.pageSize = std::max<u32>(number, 1);
+            else if (argument == "--traces")            options.traceCount = number;
+            else if (argument == "--calls")             options.callCount = number;
+            else if (argument == "--strings")           options.stringCount = number;
+            else if (argument == "--signatures")        options.signatureCount = number;
+            else if (argument == "--report") {
+                std::ifstream file(value, std::ios::binary);
+                if (!file) {
+                    std::fprintf(stderr, "Failed to open report %s\n", value.c_str());
+                    return std::nullopt;
+                }
+
+                options.report.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", arguments[i - 1]);
+                return std::nullopt;
+            }
+        }
+
+        return options;
+    }
+
+    /**
+     * @brief Minimal SHA-256, only used to recognize samples that were uploaded before
+     */
+    class Sha256 {
+    public:
+        void update(std::span<const u8> data) {
+            for (const auto byte : data) {
+                this->m_block[this->m_blockSize++] = byte;
+                if (this->m_blockSize == this->m_block.size()) {
+                    this->transform();
+                    this->m_blockSize = 0;
+                }
+            }
+
+            this->m_length += data.size();
+        }
+
+        std::string finish() {
+            const u64 bitLength = this->m_length * 8;
+
+            const u8 padding = 0x80;
+            this->update({ &padding, 1 });
+            while (this->m_blockSize != 56) {
+                const u8 zero = 0x00;
+                this->update({ &zero, 1 });
+            }
+
+            for (int i = 7; i >= 0; i--) {
+                const u8 byte = u8(bitLength >> (i * 8));
+                this->update({ &byte, 1 });
+            }
+
+            std::string result;
+            for (const auto word : this->m_state) {
+                char buffer[9];
+                std::snprintf(buffer, sizeof(buffer), "%08X", word);
+                result += buffer;
+            }
+
+            return result;
+        }
+
+    private:
+        static u32 rotate(u32 value, u32 count) {
+            return (value >> count) | (value << (32 - count));
+        }
+
+        void transform() {
+            constexpr static std::array<u32, 64> K = {
+                0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+                0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+                0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+                0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+                0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+                0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+                0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+                0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+            };
+
+            std::array<u32, 64> w = { };
+            for (u32 i = 0; i < 16; i++)
+                w[i] = u32(this->m_block[i * 4]) << 24 | u32(this->m_block[i * 4 + 1]) << 16 | u32(this->m_block[i * 4 + 2]) << 8 | this->m_block[i * 4 + 3];
+            for (u32 i = 16; i < 64; i++) {
+                const auto s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                const auto s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            auto [a, b, c, d, e, f, g, h] = this->m_state;
+            for (u32 i = 0; i < 64; i++) {
+                const auto t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+                const auto t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+
+            const std::array<u32, 8> result = { a, b, c, d, e, f, g, h };
+            for (u32 i = 0; i < 8; i++)
+                this->m_state[i] += result[i];
+        }
+
+        std::array<u32, 8> m_state = { 0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+        std::array<u8, 64> m_block = { };
+        size_t m_blockSize = 0;
+        u64 m_length = 0;
+    };
+
+    /**
+     * @brief Finished status response, split the same way a paging backend would serve it
+     */
+    struct Report {
+        std::string full;
+        std::vector<std::string> entryPoints;
+
+        // Summary without its closing braces, the page index that follows it names the analysis it belongs to
+        std::string summary;
+        std::string traceIndex;
+    };
+
+    Report generateReport(const Options &options) {
+        constexpr static std::array ApiNames = {
+            "CreateFileW", "ReadFile", "WriteFile", "CloseHandle", "VirtualAlloc", "VirtualProtect", "LoadLibraryA",
+            "GetProcAddress", "RegOpenKeyExW", "RegSetValueExW", "CreateProcessW", "WinHttpSendRequest", "Sleep"
+        };
+
+        std::string data = R"("threat_score":{"results":{"score":"73.5","signatures":[)";
+        for (u32 i = 0; i < options.signatureCount; i++) {
+            if (i != 0)
+                data += ',';
+            data += R"({"info":{"title":"Signature )" + std::to_string(i) + R"(","description":"Generated signature )" + std::to_string(i) +
+                    R"("},"discovered":[{"offset":)" + std::to_string(i * 0x100) + "}]}";
+        }
+        data += R"(]}},"packer_information":[{"packer_name":"UPX","percent":"87"}],"interesting_strings":{"results":[)";
+        for (u32 i = 0; i < options.stringCount; i++) {
+            if (i != 0)
+                data += ',';
+            data += "\"http://example.com/" + std::to_string(i) + "\"";
+        }
+        data += "]}";
+
+        Report report;
+        for (u32 trace = 0; trace < options.traceCount; trace++) {
+            std::string entryPoint = R"({"apihash":")" + std::to_string(0xA000 + trace) + R"(","apis":[)";
+            for (u32 call = 0; call < options.callCount; call++) {
+                if (call != 0)
+                    entryPoint += ',';
+
+                char pc[32];
+                std::snprintf(pc, sizeof(pc), "0x%X", 0x401000 + call * 8);
+                entryPoint += R"({"api_name":")" + std::string(ApiNames[(call * 7 + trace) % ApiNames.size()]) + R"(","pc":")" + pc +
+                              R"(","args":["0x)" + std::to_string(call % 64) + R"(","C:\\Windows\\file)" + std::to_string(call % 97) +
+                              R"(.dll","0"],"ret_val":"0x1"})";
+            }
+            entryPoint += "]}";
+
+            report.entryPoints.push_back(std::move(entryPoint));
+
+            if (trace != 0)
+                report.traceIndex += ',';
+            report.traceIndex += R"({"apihash":")" + std::to_string(0xA000 + trace) + R"(","api_count":)" + std::to_string(options.callCount) + "}";
+        }
+
+        std::string traces = R"("dynamic_analysis":{"dynamic_analysis":[{"entry_points":[)";
+        for (size_t i = 0; i < report.entryPoints.size(); i++) {
+            if (i != 0)
+                traces += ',';
+            traces += report.entryPoints[i];
+        }
+        traces += "]}]}";
+
+        constexpr static std::string_view Messages = R"({"messages":[{"type":"success","message":"Analysis finished"}],"data":{)";
+        report.full    = std::string(Messages) + data + ',' + traces + "}}";
+        report.summary = std::string(Messages) + data;
+
+        return report;
+    }
+
+    struct Request {
+        std::string method, path;
+        std::map<std::string, std::string> headers;
+        std::string body;
+    };
+
+    struct Response {
+        Response(int status, std::string body = { }, std::vector<std::string> headers = { })
+            : status(status), body(std::move(body)), headers(std::move(headers)) { }
+
+        static Response dropped() {
+            Response response(0);
+            response.drop = true;
+
+            return response;
+        }
+
+        int status;
+        std::string body;
+        std::vector<std::string> headers;
+        bool drop = false;
+    };
+
+    class Connection {
+    public:
+        explicit Connection(int socket) : m_socket(socket) { }
+        ~Connection() { ::close(this->m_socket); }
+
+        bool readLine(std::string &line) {
+            line.clear();
+
+            while (true) {
+                if (auto end = this->m_buffer.find("\r\n"); end != std::string::npos) {
+                    line = this->m_buffer.substr(0, end);
+                    this->m_buffer.erase(0, end + 2);
+                    return true;
+                }
+
+                if (!this->fill())
+                    return false;
+            }
+        }
+
+        bool readBytes(size_t size, std::string &output, u64 rate) {
+            const auto startTime = std::chrono::steady_clock::now();
+            const auto startSize = output.size();
+
+            while (size > 0) {
+                if (this->m_buffer.empty() && !this->fill())
+                    return false;
+
+                const auto chunk = std::min(size, this->m_buffer.size());
+                output.append(this->m_buffer, 0, chunk);
+                this->m_buffer.erase(0, chunk);
+                size -= chunk;
+
+                // Throttle to the configured bandwidth by falling behind the data that already arrived
+                if (rate > 0) {
+                    const auto expected = std::chrono::duration<double>(double(output.size() - startSize) / double(rate));
+                    std::this_thread::sleep_until(startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(expected));
+                }
+            }
+
+            return true;
+        }
+
+        bool write(std::string_view data) {
+            while (!data.empty()) {
+                const auto written = ::send(this->m_socket, data.data(), data.size(), MSG_NOSIGNAL);
+                if (written <= 0)
+                    return false;
+
+                data.remove_prefix(written);
+            }
+
+            return true;
+        }
+
+    private:
+        bool fill() {
+            char buffer[64 * 1024];
+            const auto received = ::recv(this->m_socket, buffer, sizeof(buffer), 0);
+            if (received <= 0)
+                return false;
+
+            this->m_buffer.append(buffer, received);
+            return true;
+        }
+
+        int m_socket;
+        std::string m_buffer;
+    };
+
+    std::string toLower(std::string string) {
+        std::transform(string.begin(), string.end(), string.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+        return string;
+    }
+
+    std::optional<Request> readRequest(Connection &connection, const Options &options) {
+        Request request;
+
+        std::string line;
+        if (!connection.readLine(line))
+            return std::nullopt;
+
+        std::istringstream requestLine(line);
+        requestLine >> request.method >> request.path;
+
+        while (connection.readLine(line) && !line.empty()) {
+            const auto colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+
+            auto value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            request.headers[toLower(line.substr(0, colon))] = value;
+        }
+
+        if (auto it = request.headers.find("expect"); it != request.headers.end() && toLower(it->second) == "100-continue")
+            connection.write("HTTP/1.1 100 Continue\r\n\r\n");
+
+        if (auto it = request.headers.find("transfer-encoding"); it != request.headers.end() && toLower(it->second) == "chunked") {
+            while (true) {
+                if (!connection.readLine(line))
+                    return std::nullopt;
+
+                const auto size = std::strtoull(line.c_str(), nullptr, 16);
+                if (size == 0)
+                    break;
+
+                if (!connection.readBytes(size, request.body, options.uploadRate) || !connection.readLine(line))
+                    return std::nullopt;
+            }
+
+            // Trailers aren't used by anything, skip them
+            while (connection.readLine(line) && !line.empty()) { }
+        } else if (auto it = request.headers.find("content-length"); it != request.headers.end()) {
+            if (!connection.readBytes(std::strtoull(it->second.c_str(), nullptr, 10), request.body, options.uploadRate))
+                return std::nullopt;
+        }
+
+        return request;
+    }
+
+    std::string getFormValue(std::string_view body, std::string_view name) {
+        size_t pos = 0;
+        while (pos < body.size()) {
+            auto end = body.find('&', pos);
+            if (end == std::string_view::npos)
+                end = body.size();
+
+            const auto field = body.substr(pos, end - pos);
+            if (field.starts_with(name) && field.size() > name.size() && field[name.size()] == '=')
+                return std::string(field.substr(name.size() + 1));
+
+            pos = end + 1;
+        }
+
+        return { };
+    }
+
+    struct FormPart {
+        std::string_view headers, data;
+    };
+
+    /**
+     * @brief Splits a multipart body into the headers and content of each of its parts
+     */
+    std::vector<FormPart> getFormParts(const Request &request) {
+        const auto contentType = request.headers.find("content-type");
+        if (contentType == request.headers.end())
+            return { };
+
+        const auto boundaryPos = contentType->second.find("boundary=");
+        if (boundaryPos == std::string::npos)
+            return { };
+
+        const auto boundary = "--" + contentType->second.substr(boundaryPos + 9);
+        const std::string_view body = request.body;
+
+        std::vector<FormPart> parts;
+        for (auto partStart = body.find(boundary); partStart != std::string_view::npos;) {
+            // The last boundary is followed by two dashes and has no part after it
+            if (body.substr(partStart + boundary.size(), 2) == "--")
+                break;
+
+            const auto dataStart = body.find("\r\n\r\n", partStart);
+            const auto dataEnd   = body.find("\r\n" + boundary, dataStart);
+            if (dataStart == std::string_view::npos || dataEnd == std::string_view::npos)
+                break;
+
+            parts.push_back({ body.substr(partStart, dataStart - partStart), body.substr(dataStart + 4, dataEnd - dataStart - 4) });
+            partStart = dataEnd + 2;
+        }
+
+        return parts;
+    }
+
+    /**
+     * @brief Finds the first part that carries a file
+     */
+    std::optional<FormPart> getFilePart(std::span<const FormPart> parts) {
+        for (const auto &part : parts) {
+            if (toLower(std::string(part.headers)).contains("filename="))
+                return part;
+        }
+
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Finds the value of a plain form field
+     */
+    std::optional<std::string_view> getFieldValue(std::span<const FormPart> parts, std::string_view name) {
+        const auto disposition = "name=\"" + std::string(name) + "\"";
+        for (const auto &part : parts) {
+            const auto headers = toLower(std::string(part.headers));
+            if (headers.contains(disposition) && !headers.contains("filename="))
+                return part.data;
+        }
+
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Decompresses a gzip stream
+     */
+    std::optional<std::string> inflateGzip(std::string_view data) {
+        z_stream stream = { };
+        if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+            return std::nullopt;
+
+        stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = uInt(data.size());
+
+        std::string result;
+        int code = Z_OK;
+        while (code == Z_OK) {
+            std::array<char, 64 * 1024> buffer;
+            stream.next_out  = reinterpret_cast<Bytef*>(buffer.data());
+            stream.avail_out = buffer.size();
+
+            code = inflate(&stream, Z_NO_FLUSH);
+            result.append(buffer.data(), buffer.size() - stream.avail_out);
+        }
+
+        inflateEnd(&stream);
+
+        if (code != Z_STREAM_END)
+            return std::nullopt;
+
+        return result;
+    }
+
+    class Server {
+    public:
+        explicit Server(Options options) : m_options(std::move(options)) {
+            if (!this->m_options.report.empty()) {
+                this->m_report.full = this->m_options.report;
+
+                // Recorded responses aren't taken apart again, so they're always served as a whole
+                if (this->m_options.paging) {
+                    std::fputs("Paged status requests are only supported with generated reports, serving the recorded one as a whole\n", stderr);
+                    this->m_options.paging = false;
+                }
+            } else {
+                this->m_report = generateReport(this->m_options);
+            }
+        }
+
+        Response handle(const Request &request) {
+            const auto index = ++this->m_requestCount;
+
+            if (this->m_options.latency.count() > 0)
+                std::this_thread::sleep_for(this->m_options.latency);
+
+            if (this->m_options.dropEvery != 0 && index % this->m_options.dropEvery == 0)
+                return Response::dropped();
+            if (this->m_options.throttleEvery != 0 && index % this->m_options.throttleEvery == 0)
+                return Response(429, R"({"messages":[{"type":"error","message":"Too many requests"}]})", { "Retry-After: " + std::to_string(this->m_options.retryAfter) });
+            if (this->m_options.failEvery != 0 && index % this->m_options.failEvery == 0)
+                return Response(503, R"({"messages":[{"type":"error","message":"Service unavailable"}]})");
+
+            if (request.method != "POST")
+                return Response(405);
+
+            if (request.path.ends_with("/upload"))
+                return this->upload(request);
+            if (request.path.ends_with("/status"))
+                return this->status(request);
+            if (request.path.ends_with("/lookup") && this->m_options.lookup)
+                return this->lookup(request);
+            if (request.path.ends_with("/capabilities"))
+                return this->capabilities();
+
+            return Response(404, R"({"messages":[{"type":"error","message":"Not found"}]})");
+        }
+
+    private:
+        Response upload(const Request &request) {
+            const auto parts = getFormParts(request);
+            const auto part = getFilePart(parts);
+            if (!part.has_value())
+                return Response(400, R"({"messages":[{"type":"error","message":"No file given"}]})");
+
+            std::string_view data = part->data;
+
+            // The encoding of the file is given in a form field of its own, only gzip is known
+            std::optional<std::string> inflated;
+            if (const auto encoding = getFieldValue(parts, "encoding"); encoding.has_value() && *encoding != "identity") {
+                if (!this->m_options.gzip || *encoding != "gzip")
+                    return Response(415, R"({"messages":[{"type":"error","message":"Unsupported content encoding"}]})");
+
+                inflated = inflateGzip(data);
+                if (!inflated.has_value())
+                    return Response(400, R"({"messages":[{"type":"error","message":"Invalid gzip data"}]})");
+
+                data = *inflated;
+            }
+
+            Sha256 hash;
+            hash.update({ reinterpret_cast<const u8*>(data.data()), data.size() });
+
+            std::scoped_lock lock(this->m_mutex);
+            const auto uuid = "mock-" + std::to_string(this->m_analyses.size());
+            this->m_analyses[uuid] = 0;
+            this->m_uploadedHashes[hash.finish()] = uuid;
+
+            return Response(200, R"({"data":{"data":{"uuid":")" + uuid + R"("}}})");
+        }
+
+        Response status(const Request &request) {
+            const auto uuid = getFormValue(request.body, "uuid");
+
+            {
+                std::scoped_lock lock(this->m_mutex);
+
+                auto it = this->m_analyses.find(uuid);
+                if (it == this->m_analyses.end())
+                    return Response(404, R"({"messages":[{"type":"error","message":"Unknown analysis"}]})");
+
+                if (it->second < this->m_options.pendingPolls) {
+                    it->second += 1;
+                    return Response(200, R"({"messages":[{"type":"info","message":"Analysis in progress"}],"data":null})");
+                }
+            }
+
+            // Paging backends answer with a summary first and hand out the traces page by page, all others ignore the parameters
+            if (!this->m_options.paging)
+                return Response(200, this->m_report.full);
+
+            const auto page = getFormValue(request.body, "page");
+            if (page.empty()) {
+                if (getFormValue(request.body, "section") != "summary")
+                    return Response(200, this->m_report.full);
+
+                return Response(200, this->m_report.summary + R"(,"dynamic_analysis_pages":{"uuid":")" + uuid + R"(","page_size":)" +
+                    std::to_string(this->m_options.pageSize) + R"(,"traces":[)" + this->m_report.traceIndex + "]}}}");
+            }
+
+            const auto first = std::strtoull(page.c_str(), nullptr, 10) * this->m_options.pageSize;
+            std::string body = R"({"messages":[{"type":"success","message":"Analysis finished"}],"data":{"dynamic_analysis":{"dynamic_analysis":[{"entry_points":[)";
+            for (size_t i = first; i < std::min<size_t>(first + this->m_options.pageSize, this->m_report.entryPoints.size()); i++) {
+                if (i != first)
+                    body += ',';
+                body += this->m_report.entryPoints[i];
+            }
+            body += "]}]}}}";
+
+            return Response(200, std::move(body));
+        }
+
+        // Like the real API, a mock without any optional features doesn't know about the endpoint at all
+        Response capabilities() const {
+            if (!this->m_options.lookup && !this->m_options.gzip && !this->m_options.paging)
+                return Response(404, R"({"messages":[{"type":"error","message":"Not found"}]})");
+
+            return Response(200, std::string(R"({"data":{"capabilities":{"hash_lookup":)") + (this->m_options.lookup ? "true" : "false") +
+                R"(,"paged_status":)" + (this->m_options.paging ? "true" : "false") +
+                R"(,"upload_encodings":[)" + (this->m_options.gzip ? R"("gzip")" : "") + "]}}}");
+        }
+
+        Response lookup(const Request &request) {
+            auto hash = getFormValue(request.body, "hash");
+            std::transform(hash.begin(), hash.end(), hash.begin(), [](unsigned char c) { return char(std::toupper(c)); });
+
+            std::scoped_lock lock(this->m_mutex);
+            if (!this->m_uploadedHashes.contains(hash))
+                return Response(404, R"({"messages":[{"type":"error","message":"Unknown sample"}]})");
+
+            return Response(200, this->m_report.full);
+        }
+
+    private:
+        Options m_options;
+        Report m_report;
+
+        std::atomic<u64> m_requestCount = 0;
+
+        std::mutex m_mutex;
+        std::map<std::string, u32> m_analyses;
+        std::map<std::string, std::string> m_uploadedHashes;
+    };
+
+    std::string_view getReason(int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 415: return "Unsupported Media Type";
+            case 429: return "Too Many Requests";
+            case 503: return "Service Unavailable";
+            default:  return "Unknown";
+        }
+    }
+
+    void serve(Server &server, const Options &options, int socket) {
+        Connection connection(socket);
+
+        // Connections are kept alive, just like the real API does, so the client can reuse them
+        while (true) {
+            const auto request = readRequest(connection, options);
+            if (!request.has_value())
+                return;
+
+            const auto response = server.handle(*request);
+            if (response.drop)
+                return;
+
+            std::string head = "HTTP/1.1 " + std::to_string(response.status) + " " + std::string(getReason(response.status)) + "\r\n";
+            head += "Content-Type: application/json\r\n";
+            head += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+            for (const auto &header : response.headers)
+                head += header + "\r\n";
+            head += "\r\n";
+
+            if (!connection.write(head) || !connection.write(response.body))
+                return;
+        }
+    }
+
+}
+
+int main(int argc, char **argv) {
+    const auto options = parseArguments(std::span(argv + 1, argv + argc));
+    if (!options.has_value()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::perror("socket");
+        return EXIT_FAILURE;
+    }
+
+    const int enable = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address = { };
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(options->port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 256) != 0) {
+        std::perror("bind");
+        return EXIT_FAILURE;
+    }
+
+    Server server(*options);
+    std::fprintf(stderr, "Mock Malcore API listening on http://127.0.0.1:%u\n", options->port);
+
+    while (true) {
+        const int socket = ::accept(listener, nullptr, nullptr);
+        if (socket < 0)
+            continue;
+
+        ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        std::thread([&server, &options = *options, socket] { serve(server, options, socket); }).detach();
+    }
+}
@@ -0,0 +1,388 @@
+#include <views/view_batch_analysis.hpp>
+
+#include <helpers/analysis_runner.hpp>
+#include <helpers/provider_hashes.hpp>
+#include <helpers/report_pages.hpp>
+#include <helpers/request_scheduler.hpp>
+#include <helpers/status_parser.hpp>
+#include <popups/popup_notification.hpp>
+
+#include <hex/api/content_registry.hpp>
+#include <hex/api/event.hpp>
+#include <hex/api/imhex_api.hpp>
+#include <hex/api/localization.hpp>
+#include <hex/api/task.hpp>
+#include <hex/helpers/crypto.hpp>
+#include <hex/helpers/fs.hpp>
+#include <hex/helpers/logger.hpp>
+
+#include <wolv/literals.hpp>
+#include <wolv/utils/guards.hpp>
+#include <wolv/utils/string.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace mal {
+
+    using namespace hex;
+    using namespace std::literals::chrono_literals;
+    using namespace wolv::literals;
+
+    ViewBatchAnalysis::ViewBatchAnalysis() : View("mal.view.malcore_batch") {
+        ContentRegistry::Interface::addMenuItem({ "hex.builtin.menu.extras", "mal.malcore.menu.batch_analyze_providers" }, 10001, Shortcut::None, [this] {
+            this->analyzeOpenProviders();
+        }, [this] {
+            return ImHexApi::Provider::isValid() && !this->m_running;
+        });
+
+        ContentRegistry::Interface::addMenuItem({ "hex.builtin.menu.extras", "mal.malcore.menu.batch_analyze_directory" }, 10002, Shortcut::None, [this] {
+            fs::openFileBrowser(fs::DialogMode::Folder, { }, [this](const std::fs::path &path) {
+                this->analyzeDirectory(path);
+            });
+        }, [this] {
+            return !this->m_running;
+        });
+
+        // Rows of a provider are cancelled as soon as it's about to close, so their digests are already winding down
+        // by the time the provider is gone and its leases have to wait for them
+        EventManager::subscribe<EventProviderClosing>(this, [this](prv::Provider *provider, bool *) {
+            this->cancelProviderJobs(provider);
+        });
+
+        EventManager::subscribe<EventProviderClosed>(this, [this](prv::Provider *provider) {
+            this->revokeProviderJobs(provider);
+        });
+    }
+
+    ViewBatchAnalysis::~ViewBatchAnalysis() {
+        EventManager::unsubscribe<EventProviderClosing>(this);
+        EventManager::unsubscribe<EventProviderClosed>(this);
+    }
+
+    void ViewBatchAnalysis::drawContent() {
+        if (ImGui::Begin(LangEntry(this->getUnlocalizedName()), &this->getWindowOpenState())) {
+            std::scoped_lock lock(this->m_entriesMutex);
+
+            if (this->m_wallTime.has_value())
+                ImGui::TextFormatted("mal.view.malcore_batch.wall_time"_lang, this->m_entries.size(), *this->m_wallTime);
+            else
+                ImGui::TextSpinner("mal.malcore.analyzing"_lang);
+
+            const auto requests = hlp::RequestScheduler::getCounters();
+            ImGui::TextFormatted("mal.view.malcore_batch.requests"_lang, requests.queued, requests.retried, requests.throttled);
+
+            if (ImGui::BeginTable("##batch", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingFixedFit, ImGui::GetContentRegionAvail())) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("mal.view.malcore_batch.name"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore_batch.hash"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore_batch.state"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore_batch.threat_score"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore_batch.time"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore_batch.packer"_lang, ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableHeadersRow();
+
+                ImGuiListClipper clipper;
+                clipper.Begin(this->m_entries.size());
+
+                while (clipper.Step()) {
+                    for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                        const auto &entry = this->m_entries[i];
+
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(entry.name.c_str());
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(entry.hash.c_str());
+                        ImGui::TableNextColumn();
+
+                        using enum State;
+                        switch (entry.state) {
+                            case Queued:    ImGui::TextUnformatted("mal.view.malcore_batch.state.queued"_lang);      break;
+                            case Analyzing: ImGui::TextSpinner("mal.view.malcore_batch.state.analyzing"_lang);       break;
+                            case Done:      ImGui::TextUnformatted("mal.view.malcore_batch.state.done"_lang);        break;
+                            case Failed:    ImGui::TextUnformatted("mal.view.malcore_batch.state.failed"_lang);      break;
+                            case Cancelled: ImGui::TextUnformatted("mal.view.malcore_batch.state.cancelled"_lang);   break;
+                        }
+                        ImGui::TableNextColumn();
+                        if (entry.threatScore.has_value())
+                            ImGui::TextFormatted("{:.0f}%", *entry.threatScore);
+                        ImGui::TableNextColumn();
+                        if (entry.duration.has_value()) {
+                            ImGui::TextFormatted("{:.2f}s", *entry.duration);
+                            ImGui::SameLine();
+
+                            using enum hlp::AnalysisRunner::Origin;
+                            if (entry.shared)
+                                ImGui::TextFormattedDisabled("{}", "mal.view.malcore_batch.time.shared"_lang);
+                            else if (entry.origin == Cache)
+                                ImGui::TextFormattedDisabled("{}", "mal.view.malcore_batch.time.cache"_lang);
+                            else if (entry.origin == Lookup)
+                                ImGui::TextFormattedDisabled("{}", "mal.view.malcore_batch.time.lookup"_lang);
+                            else if (entry.bandwidth.has_value())
+                                ImGui::TextFormattedDisabled("{:.2f} MiB/s", *entry.bandwidth / 1_MiB);
+                        }
+                        ImGui::TableNextColumn();
+                        if (entry.packer.has_value())
+                            ImGui::TextFormatted("{} ({}%)", entry.packer->name, entry.packer->confidence);
+                    }
+                }
+
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+    }
+
+    void ViewBatchAnalysis::analyzeOpenProviders() {
+        std::vector<Job> jobs;
+        for (const auto &provider : ImHexApi::Provider::getProviders()) {
+            auto lease = std::make_shared<ProviderLease>();
+            lease->provider = provider;
+
+            jobs.push_back({ .name = provider->getName(), .provider = provider, .lease = std::move(lease) });
+        }
+
+        this->startBatch(std::move(jobs));
+    }
+
+    void ViewBatchAnalysis::analyzeDirectory(const std::fs::path &path) {
+        std::vector<Job> jobs;
+
+        std::error_code error;
+        for (const auto &entry : std::fs::directory_iterator(path, error)) {
+            if (!entry.is_regular_file(error))
+                continue;
+
+            jobs.push_back({ .name = wolv::util::toUTF8String(entry.path().filename()), .path = entry.path() });
+        }
+
+        this->startBatch(std::move(jobs));
+    }
+
+    void ViewBatchAnalysis::startBatch(std::vector<Job> jobs) {
+        if (jobs.empty())
+            return;
+
+        if (!hlp::MalcoreApi::hasApiKey()) {
+            PopupError::open("mal.malcore.popup.error.no_api_key"_lang);
+            return;
+        }
+
+        const auto jobCount = jobs.size();
+        {
+            std::scoped_lock lock(this->m_entriesMutex);
+
+            this->m_entries.clear();
+            for (const auto &job : jobs)
+                this->m_entries.push_back({ .name = job.name });
+
+            this->m_jobs = std::move(jobs);
+            this->m_wallTime.reset();
+        }
+
+        this->m_hasEntries = true;
+        this->m_running = true;
+        this->getWindowOpenState() = true;
+
+        TaskManager::createTask("mal.malcore.batch.analyzing"_lang, jobCount, [this, jobCount](Task &task) {
+            ON_SCOPE_EXIT { this->m_running = false; };
+
+            // The interrupt callback may outlive this task's frame, so it shares ownership of the stop source
+            auto stopSource = std::make_shared<std::stop_source>();
+            task.setInterruptCallback([this, stopSource] {
+                stopSource->request_stop();
+
+                std::scoped_lock lock(this->m_entriesMutex);
+                for (auto &job : this->m_jobs)
+                    job.stopSource.request_stop();
+            });
+
+            const auto startTime = std::chrono::steady_clock::now();
+
+            std::atomic<size_t> nextJob = 0, finishedJobs = 0;
+            {
+                // Each worker keeps exactly one sample in flight, so the worker count bounds the number of concurrent uploads and polls
+                std::vector<std::jthread> workers;
+                const auto workerCount = std::min<size_t>(s_maxInFlight, jobCount);
+                for (size_t i = 0; i < workerCount; i++) {
+                    workers.emplace_back([&] {
+                        while (!stopSource->stop_requested()) {
+                            const auto index = nextJob++;
+                            if (index >= jobCount)
+                                break;
+
+                            this->analyzeJob(index);
+                            finishedJobs += 1;
+                        }
+                    });
+                }
+
+                while (finishedJobs < jobCount && !stopSource->stop_requested()) {
+                    task.update(finishedJobs);
+                    std::this_thread::sleep_for(100ms);
+                }
+            }
+
+            const std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - startTime;
+            log::info("Malcore batch analysis of {} samples finished in {:.2f}s", jobCount, wallTime.count());
+
+            std::scoped_lock lock(this->m_entriesMutex);
+            this->m_wallTime = wallTime.count();
+        });
+    }
+
+    void ViewBatchAnalysis::analyzeJob(size_t index) {
+        std::string name;
+        std::optional<std::fs::path> path;
+        std::shared_ptr<ProviderLease> lease;
+        std::stop_token stopToken;
+        {
+            std::scoped_lock lock(this->m_entriesMutex);
+
+            // Rows whose provider was closed while they were queued are already marked as cancelled
+            auto &job = this->m_jobs[index];
+            if (job.stopSource.stop_requested())
+                return;
+
+            name      = job.name;
+            path      = job.path;
+            lease     = job.lease;
+            stopToken = job.stopSource.get_token();
+
+            this->m_entries[index].state = State::Analyzing;
+        }
+
+        auto sample = lease != nullptr ? std::optional(createSample(lease, std::move(name))) : hlp::SampleSource::fromFile(*path);
+        if (!sample.has_value()) {
+            std::scoped_lock lock(this->m_entriesMutex);
+            this->m_entries[index].state = State::Failed;
+            return;
+        }
+
+        auto result = hlp::AnalysisRunner::run(*sample, stopToken, hlp::RequestScheduler::Priority::Batch);
+
+        // Files are closed again as soon as their analysis is done
+        sample.reset();
+
+        std::optional<float> threatScore;
+        std::optional<hlp::MalcoreApi::PackerInformation> packer;
+        if (result.status.has_value()) {
+            // The table only shows the verdict, so the traces are cut out before parsing instead of being decoded for nothing
+            auto summary = hlp::ReportPages::extractSummary(*result.status);
+            if (auto analysis = summary.has_value() ? hlp::StatusParser::parse(*summary) : std::nullopt; analysis.has_value()) {
+                if (analysis->threatScore.has_value())
+                    threatScore = analysis->threatScore->score;
+                packer = std::move(analysis->packerInformation);
+            }
+        }
+
+        std::scoped_lock lock(this->m_entriesMutex);
+
+        using enum hlp::AnalysisRunner::Error;
+
+        auto &entry = this->m_entries[index];
+        entry.hash        = crypt::encode16({ result.hash.begin(), result.hash.end() });
+        entry.state       = result.error == None ? State::Done : result.error == Cancelled ? State::Cancelled : State::Failed;
+        entry.threatScore = threatScore;
+        entry.packer      = std::move(packer);
+        entry.duration    = result.duration.count();
+        entry.bandwidth   = result.getUploadBandwidth();
+        entry.origin      = result.origin;
+        entry.shared      = result.shared;
+    }
+
+    void ViewBatchAnalysis::cancelProviderJobs(prv::Provider *provider) {
+        std::scoped_lock lock(this->m_entriesMutex);
+
+        for (size_t i = 0; i < this->m_jobs.size(); i++) {
+            auto &job = this->m_jobs[i];
+            if (job.provider != provider)
+                continue;
+
+            job.stopSource.request_stop();
+            if (this->m_entries[i].state == State::Queued)
+                this->m_entries[i].state = State::Cancelled;
+        }
+    }
+
+    void ViewBatchAnalysis::revokeProviderJobs(prv::Provider *provider) {
+        // Providers closed without asking first never announced it
+        this->cancelProviderJobs(provider);
+
+        std::vector<std::shared_ptr<ProviderLease>> leases;
+        {
+            std::scoped_lock lock(this->m_entriesMutex);
+
+            for (auto &job : this->m_jobs) {
+                if (job.provider != provider)
+                    continue;
+
+                job.provider = nullptr;
+                leases.push_back(job.lease);
+            }
+        }
+
+        // Waits for accesses that are still running, everything after this only sees the lease as revoked
+        for (const auto &lease : leases)
+            lease->revoke();
+    }
+
+    prv::Provider *ViewBatchAnalysis::ProviderLease::pin() {
+        std::scoped_lock lock(this->mutex);
+        if (this->provider != nullptr)
+            this->pins += 1;
+
+        return this->provider;
+    }
+
+    void ViewBatchAnalysis::ProviderLease::unpin() {
+        {
+            std::scoped_lock lock(this->mutex);
+            this->pins -= 1;
+        }
+
+        this->unpinned.notify_all();
+    }
+
+    void ViewBatchAnalysis::ProviderLease::revoke() {
+        std::unique_lock lock(this->mutex);
+        this->provider = nullptr;
+
+        this->unpinned.wait(lock, [this] { return this->pins == 0; });
+    }
+
+    hlp::SampleSource ViewBatchAnalysis::createSample(const std::shared_ptr<ProviderLease> &lease, std::string name) {
+        u64 size = 0;
+        if (auto provider = lease->pin(); provider != nullptr) {
+            ON_SCOPE_EXIT { lease->unpin(); };
+            size = provider->getActualSize();
+        }
+
+        // Reads of a closed provider come back empty, its row was cancelled before the lease got revoked
+        auto sample = hlp::SampleSource::fromReader(std::move(name), size, [lease](u64 offset, u8 *buffer, size_t size) {
+            auto provider = lease->pin();
+            if (provider == nullptr) {
+                std::fill_n(buffer, size, 0x00);
+                return;
+            }
+
+            ON_SCOPE_EXIT { lease->unpin(); };
+            provider->read(provider->getBaseAddress() + offset, buffer, size);
+        });
+
+        // The digest runs on the job's stop token, which is requested as soon as the provider is about to close
+        sample.setDigester([lease](u64 limit, std::stop_token stopToken) -> std::optional<hlp::SampleSource::Hash> {
+            auto provider = lease->pin();
+            if (provider == nullptr)
+                return std::nullopt;
+
+            ON_SCOPE_EXIT { lease->unpin(); };
+            return hlp::ProviderHashes::getDigest(provider, limit, stopToken);
+        });
+
+        return sample;
+    }
+
+}
@@ -0,0 +1,1272 @@
+#include <views/view_malcore.hpp>
+
+#include <helpers/address_map.hpp>
+#include <helpers/analysis_runner.hpp>
+#include <helpers/provider_hashes.hpp>
+#include <helpers/request_scheduler.hpp>
+#include <helpers/status_parser.hpp>
+#include <popups/popup_notification.hpp>
+
+#include <hex/api/content_registry.hpp>
+#include <hex/api/imhex_api.hpp>
+#include <hex/api/localization.hpp>
+#include <hex/api/project_file_manager.hpp>
+#include <hex/api/task.hpp>
+#include <hex/api/theme_manager.hpp>
+#include <hex/helpers/crypto.hpp>
+#include <hex/helpers/fs.hpp>
+#include <hex/helpers/logger.hpp>
+#include <hex/helpers/tar.hpp>
+#include <hex/helpers/utils.hpp>
+
+#include <wolv/io/file.hpp>
+#include <wolv/utils/guards.hpp>
+#include <wolv/utils/string.hpp>
+
+#include <fonts/codicons_font.h>
+#include <romfs/romfs.hpp>
+#include <fmt/chrono.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+namespace mal {
+
+    using namespace hex;
+
+    namespace {
+
+        ImGui::Texture s_bannerTexture;
+
+        bool isProviderOpen(prv::Provider *provider) {
+            const auto &providers = ImHexApi::Provider::getProviders();
+            return std::find(providers.begin(), providers.end(), provider) != providers.end();
+        }
+
+    }
+
+    ViewMalcore::ViewMalcore() : View("mal.view.malcore") {
+        EventManager::subscribe<RequestChangeTheme>(this, [](const std::string &) {
+            auto loadFromRomfs = [&](const std::string &path) {
+                auto textureData = romfs::get(path);
+
+                return ImGui::Texture(reinterpret_cast<const ImU8*>(textureData.data()), textureData.size());
+            };
+
+            s_bannerTexture = loadFromRomfs(hex::format("assets/malcore_banner{}.png", ThemeManager::getThemeImagePostfix()));
+
+            if (!s_bannerTexture.isValid()) {
+                log::error("Failed to load banner texture!");
+            }
+        });
+
+        // A single provider each for highlights and tooltips that answers from the current snapshot's annotation index,
+        // instead of registering a separate highlight for every single annotation
+        this->m_highlightProvider = ImHexApi::HexEditor::addBackgroundHighlightingProvider([this](u64 address, const u8 *, size_t, bool) -> std::optional<color_t> {
+            if (!ImHexApi::Provider::isValid())
+                return std::nullopt;
+
+            const auto analysis = this->m_analysis.get();
+            if (analysis == nullptr)
+                return std::nullopt;
+
+            return analysis->annotations.getColor(address);
+        });
+
+        this->m_tooltipProvider = ImHexApi::HexEditor::addTooltipProvider([this](u64 address, const u8 *, size_t) {
+            if (!ImHexApi::Provider::isValid())
+                return;
+
+            const auto analysis = this->m_analysis.get();
+            if (analysis == nullptr)
+                return;
+
+            const auto annotations = analysis->annotations.find(address);
+            if (annotations.empty())
+                return;
+
+            ImGui::BeginTooltip();
+            for (const auto id : annotations) {
+                const auto &annotation = analysis->annotations.get(id);
+
+                ImGui::PushID(id);
+                ImGui::ColorButton("##color", ImColor(annotation.color), ImGuiColorEditFlags_NoTooltip, ImVec2(ImGui::GetTextLineHeight(), ImGui::GetTextLineHeight()));
+                ImGui::SameLine();
+                ImGui::TextUnformatted(annotation.label.c_str());
+                ImGui::PopID();
+            }
+            ImGui::EndTooltip();
+        });
+
+        this->registerProjectHandler();
+    }
+
+    ViewMalcore::~ViewMalcore() {
+        EventManager::unsubscribe<RequestChangeTheme>(this);
+
+        ImHexApi::HexEditor::removeBackgroundHighlightingProvider(this->m_highlightProvider);
+        ImHexApi::HexEditor::removeTooltipProvider(this->m_tooltipProvider);
+    }
+
+    void ViewMalcore::drawContent() {
+        const auto drawStartTime = std::chrono::steady_clock::now();
+
+        if (ImGui::Begin(LangEntry(this->getUnlocalizedName()), &this->getWindowOpenState())) {
+            if (ImGui::BeginChild("##scroll", ImVec2(0, 0), false, ImGuiWindowFlags_AlwaysVerticalScrollbar)) {
+                const auto triage = ImHexApi::Provider::isValid() ? this->m_triage.get() : nullptr;
+                if (triage != nullptr)
+                    drawTriage(*triage);
+
+                const auto analysis = ImHexApi::Provider::isValid() ? this->m_analysis.get() : nullptr;
+
+                // The verdict of the remote analysis always wins, local signatures only fill the gap until it's there
+                if (analysis != nullptr && analysis->packerInformation.has_value()) {
+                    ImGui::Header("mal.view.malcore.packer"_lang, true);
+
+                    const auto &packer = analysis->packerInformation.value();
+                    ImGui::TextFormattedWrapped("mal.view.malcore.packer.text"_lang, packer.name, packer.confidence);
+
+                    ImGui::NewLine();
+                } else if (triage != nullptr && !triage->packers.empty()) {
+                    ImGui::Header("mal.view.malcore.packer"_lang, true);
+
+                    const auto &packer = triage->packers.front();
+                    ImGui::TextFormattedWrapped("mal.view.malcore.packer.local"_lang, packer.name, packer.confidence);
+
+                    ImGui::NewLine();
+                }
+
+                if (analysis != nullptr) {
+                    if (analysis->threatScore.has_value()) {
+                        ImGui::Header("mal.view.malcore.threat_score"_lang, true);
+
+                        const auto &threatScore = analysis->threatScore.value();
+
+                        auto color = [&threatScore]{
+                            ImColor color;
+                            color.SetHSV(3 - (threatScore.score / 100.0f) * 3, 0.8F, 0.8F);
+
+                            return color;
+                        }();
+
+                        ImGui::PushStyleColor(ImGuiCol_PlotHistogram, u32(color));
+                        ImGui::PushItemWidth(-1);
+                        const auto text = hex::format("mal.view.malcore.threat_score.text"_lang, threatScore.score);
+                        ImGui::ProgressBar(threatScore.score / 100.0f, ImVec2(0, 0), text.c_str());
+                        ImGui::PopItemWidth();
+                        ImGui::PopStyleColor();
+
+                        ImGui::NewLine();
+
+                        int id = 1;
+                        for (const auto &[title, description, discovered] : threatScore.signatures) {
+                            ImGui::PushID(id);
+                            if (ImGui::CollapsingHeader(title.c_str())) {
+                                ImGui::TextFormattedWrapped("{}", description);
+                                ImGui::NewLine();
+                            }
+                            ImGui::PopID();
+
+                            id += 1;
+                        }
+
+                        ImGui::NewLine();
+                    }
+
+                    if (analysis->tracePages != nullptr) {
+                        ImGui::Header("mal.view.malcore.dynamic_analysis"_lang, true);
+
+                        ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
+                        const auto &pages = analysis->tracePages;
+
+                        auto &traceFilters = this->m_traceFilters.get();
+                        traceFilters.resize(analysis->traceHeaders.size());
+
+                        // Only the pages of expanded traces get decoded, the headers alone come straight from the split response
+                        for (u32 i = 0; i < analysis->traceHeaders.size(); i++) {
+                            const auto &header = analysis->traceHeaders[i];
+
+                            ImGui::PushID(i + 1);
+                            if (ImGui::CollapsingHeader(header.hash.c_str())) {
+                                const auto pageIndex = pages->getPageOf(i);
+                                const auto trace     = i - pages->getFirstTrace(pageIndex);
+
+                                if (const auto page = pages->findPage(pageIndex); page == nullptr) {
+                                    ImGui::TextSpinner(hex::format("mal.view.malcore.dynamic_analysis.loading"_lang, header.apiCount).c_str());
+                                    this->startPageLoadTask(ImHexApi::Provider::get(), analysis, pageIndex);
+                                } else if (trace < page->traces.size()) {
+                                    drawTrace(page->traces[trace], page->strings, page->indices[trace], traceFilters[i]);
+                                } else {
+                                    ImGui::TextUnformatted("mal.view.malcore.dynamic_analysis.broken"_lang);
+                                }
+
+                                ImGui::NewLine();
+                            }
+                            ImGui::PopID();
+                        }
+                        ImGui::PopStyleVar();
+
+                        ImGui::NewLine();
+                    }
+
+                    if (analysis->interestingStrings.has_value()) {
+                        ImGui::Header("mal.view.malcore.interesting_strings"_lang, true);
+
+                        drawInterestingStrings(*analysis);
+
+                        ImGui::NewLine();
+                    }
+
+                    this->drawComparison(ImHexApi::Provider::get(), analysis);
+
+                    // Timings aren't stored in projects, there's nothing to diagnose for restored analyses
+                    if (!analysis->restored)
+                        drawDiagnostics(*analysis, this->m_drawDuration);
+                }
+            }
+            ImGui::EndChild();
+        }
+        ImGui::End();
+
+        this->m_drawDuration = std::chrono::steady_clock::now() - drawStartTime;
+    }
+
+    void ViewMalcore::drawTrace(const hlp::MalcoreApi::DynamicAnalysisResult &trace, const hlp::StringPool &strings, const hlp::ApiTraceIndex &index, TraceFilter &filter) {
+        const auto inputWidth = (ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ItemSpacing.x * 3) / 4;
+
+        ImGui::PushItemWidth(inputWidth);
+        filter.dirty |= ImGui::InputTextWithHint("##name", "mal.view.malcore.dynamic_analysis.filter.name"_lang, filter.name);
+        ImGui::SameLine();
+        filter.dirty |= ImGui::InputTextWithHint("##pc_start", "mal.view.malcore.dynamic_analysis.filter.pc_start"_lang, filter.pcStart, ImGuiInputTextFlags_CharsHexadecimal);
+        ImGui::SameLine();
+        filter.dirty |= ImGui::InputTextWithHint("##pc_end", "mal.view.malcore.dynamic_analysis.filter.pc_end"_lang, filter.pcEnd, ImGuiInputTextFlags_CharsHexadecimal);
+        ImGui::SameLine();
+        filter.dirty |= ImGui::InputTextWithHint("##argument", "mal.view.malcore.dynamic_analysis.filter.argument"_lang, filter.argument);
+        ImGui::PopItemWidth();
+
+        if (ImGui::BeginTable("API", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Sortable)) {
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.index"_lang, ImGuiTableColumnFlags_DefaultSort);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.pc"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.function"_lang);
+            ImGui::TableHeadersRow();
+
+            if (auto sortSpecs = ImGui::TableGetSortSpecs(); sortSpecs != nullptr && sortSpecs->SpecsDirty && sortSpecs->SpecsCount > 0) {
+                const auto &spec = sortSpecs->Specs[0];
+
+                using enum hlp::ApiTraceIndex::SortColumn;
+                constexpr static std::array Columns = { Index, Pc, Name };
+
+                filter.sortColumn = Columns[spec.ColumnIndex];
+                filter.ascending  = spec.SortDirection == ImGuiSortDirection_Ascending;
+                filter.dirty      = true;
+
+                sortSpecs->SpecsDirty = false;
+            }
+
+            // Only query the index again when the filter or the sorting changed, not every frame
+            if (filter.dirty) {
+                auto parseAddress = [](const std::string &string) -> std::optional<u64> {
+                    if (string.empty())
+                        return std::nullopt;
+
+                    return std::strtoull(string.c_str(), nullptr, 16);
+                };
+
+                hlp::ApiTraceIndex::Filter query;
+                query.name     = filter.name;
+                query.pcStart  = parseAddress(filter.pcStart);
+                query.pcEnd    = parseAddress(filter.pcEnd);
+                query.argument = filter.argument;
+
+                filter.rows  = index.query(trace, strings, query, filter.sortColumn, filter.ascending);
+                filter.dirty = false;
+            }
+
+            // Traces can contain hundreds of thousands of calls, only lay out the rows that are actually visible
+            ImGuiListClipper clipper;
+            clipper.Begin(filter.rows.size());
+
+            while (clipper.Step()) {
+                for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                    const auto row = filter.rows[i];
+
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextFormatted("{}", row);
+                    drawApiCall(trace.apis[row], trace, strings);
+                }
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::TextFormatted("mal.view.malcore.dynamic_analysis.filter.count"_lang, filter.rows.size(), trace.apis.size());
+    }
+
+    void ViewMalcore::drawApiCall(const hlp::MalcoreApi::Api &api, const hlp::MalcoreApi::DynamicAnalysisResult &trace, const hlp::StringPool &strings) {
+        ImGui::TableNextColumn();
+        ImGui::TextFormatted("0x{:02X}", api.pcValue);
+        ImGui::TableNextColumn();
+
+        const auto name = strings.get(api.apiName);
+        ImGui::TextUnformatted(name.data(), name.data() + name.size());
+        ImGui::SameLine(0, 0);
+        ImGui::TextUnformatted("(");
+
+        const auto arguments = trace.getArguments(api);
+        for (u32 i = 0; i < arguments.size(); i++) {
+            const auto &argument = arguments[i];
+
+            ImGui::SameLine(0, 0);
+            if (argument.isNumber)
+                ImGui::TextFormattedColored(ImColor(0xFF9BC64D), "{}", strings.get(argument.value));
+            else
+                ImGui::TextFormattedColored(ImColor(0xFF7070E0), "\"{}\"", strings.get(argument.value));
+
+            if (i != arguments.size() - 1) {
+                ImGui::SameLine(0, 0);
+                ImGui::TextUnformatted(", ");
+            }
+        }
+        ImGui::SameLine(0, 0);
+        ImGui::TextUnformatted(")");
+        if (api.returnValue != hlp::StringPool::Empty) {
+            ImGui::SameLine(0, 0);
+            ImGui::TextUnformatted(" -> ");
+            ImGui::SameLine(0, 0);
+            ImGui::TextFormattedColored(ImColor(0xFF9BC64D), "{}", strings.get(api.returnValue));
+        }
+    }
+
+    void ViewMalcore::drawTriage(const hlp::Triage::Result &triage) {
+        ImGui::Header("mal.view.malcore.triage"_lang, true);
+
+        const auto &image = triage.image;
+        if (ImGui::BeginTable("##triage", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            auto drawRow = [](const char *name, const std::string &value) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(value.c_str());
+            };
+
+            switch (image.format) {
+                using enum hlp::ImageInfo::Format;
+
+                case PE:      drawRow("mal.view.malcore.triage.format"_lang, hex::format("PE ({})", image.is64Bit ? "64 bit" : "32 bit"));  break;
+                case ELF:     drawRow("mal.view.malcore.triage.format"_lang, hex::format("ELF ({})", image.is64Bit ? "64 bit" : "32 bit")); break;
+                case Unknown: drawRow("mal.view.malcore.triage.format"_lang, "mal.view.malcore.triage.format.unknown"_lang);                  break;
+            }
+
+            if (image.format != hlp::ImageInfo::Format::Unknown) {
+                drawRow("mal.view.malcore.triage.machine"_lang, image.machine);
+                drawRow("mal.view.malcore.triage.type"_lang, image.type);
+                drawRow("mal.view.malcore.triage.entry_point"_lang, hex::format("0x{:X}", image.entryPoint));
+                if (image.format == hlp::ImageInfo::Format::PE)
+                    drawRow("mal.view.malcore.triage.image_base"_lang, hex::format("0x{:X}", image.imageBase));
+                if (image.timestamp.has_value())
+                    drawRow("mal.view.malcore.triage.timestamp"_lang, hex::format("{:%Y-%m-%d %H:%M:%S}", fmt::gmtime(std::time_t(*image.timestamp))));
+            }
+
+            drawRow("mal.view.malcore.triage.sha256"_lang, triage.sha256);
+            drawRow("mal.view.malcore.triage.md5"_lang, triage.md5);
+            drawRow("mal.view.malcore.triage.duration"_lang, hex::format("{:.3f}s", triage.duration.count()));
+
+            ImGui::EndTable();
+        }
+
+        ImGui::NewLine();
+        ImGui::TextUnformatted("mal.view.malcore.triage.entropy"_lang);
+        ImGui::PlotLines("##entropy", triage.entropy.data(), triage.entropy.size(), 0, nullptr, 0.0F, 1.0F, ImVec2(ImGui::GetContentRegionAvail().x, 80_scaled));
+
+        if (!image.sections.empty()) {
+            ImGui::NewLine();
+            ImGui::TextUnformatted("mal.view.malcore.triage.sections"_lang);
+            if (ImGui::BeginTable("##sections", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+                ImGui::TableSetupColumn("mal.view.malcore.triage.section.name"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore.triage.section.address"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore.triage.section.virtual_size"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore.triage.section.offset"_lang);
+                ImGui::TableSetupColumn("mal.view.malcore.triage.section.size"_lang);
+                ImGui::TableHeadersRow();
+
+                for (const auto &section : image.sections) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(section.name.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::TextFormatted("0x{:X}", section.virtualAddress);
+                    ImGui::TableNextColumn();
+                    ImGui::TextFormatted("0x{:X}", section.virtualSize);
+                    ImGui::TableNextColumn();
+                    ImGui::TextFormatted("0x{:X}", section.fileOffset);
+                    ImGui::TableNextColumn();
+                    ImGui::TextFormatted("0x{:X}", section.fileSize);
+                }
+
+                ImGui::EndTable();
+            }
+        }
+
+        ImGui::NewLine();
+        ImGui::TextUnformatted("mal.view.malcore.triage.strings"_lang);
+        if (triage.stringsTruncated)
+            ImGui::TextFormatted("mal.view.malcore.triage.strings.truncated"_lang, triage.strings.size());
+
+        if (ImGui::BeginTable("##triage_strings", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit, scaled(ImVec2(0, 250)))) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("mal.view.malcore.triage.strings.offset"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.triage.strings.type"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.triage.strings.value"_lang, ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(triage.strings.size());
+
+            while (clipper.Step()) {
+                for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                    const auto &string = triage.strings[i];
+                    const bool isWide = string.encoding == hlp::StringLocator::Encoding::UTF16LE;
+
+                    ImGui::PushID(i);
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    if (ImGui::Hyperlink(hex::format("0x{:08X}", string.offset).c_str()))
+                        ImHexApi::HexEditor::setSelection(string.offset, string.value.size() * (isWide ? 2 : 1));
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(isWide ? "UTF-16LE" : "ASCII");
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(string.value.c_str());
+                    ImGui::PopID();
+                }
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::NewLine();
+    }
+
+    void ViewMalcore::drawInterestingStrings(const Analysis &analysis) {
+        const static std::vector<hlp::StringLocator::Match> NoMatches;
+        const auto &interestingStrings = analysis.interestingStrings.value();
+
+        if (ImGui::BeginTable("##interesting_strings", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, scaled(ImVec2(0, 250)))) {
+            ImGui::TableSetupColumn("##value", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("##matches", ImGuiTableColumnFlags_WidthFixed, 150_scaled);
+
+            for (u32 i = 0; i < interestingStrings.size(); i++) {
+                const auto &string = interestingStrings[i];
+                const auto &matches = i < analysis.stringMatches.size() ? analysis.stringMatches[i] : NoMatches;
+
+                ImGui::PushID(i);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+
+                const bool open = ImGui::TreeNodeEx(string.c_str(), ImGuiTreeNodeFlags_SpanFullWidth | (matches.empty() ? ImGuiTreeNodeFlags_Leaf : ImGuiTreeNodeFlags_None));
+                ImGui::TableNextColumn();
+                ImGui::TextFormatted("mal.view.malcore.interesting_strings.matches"_lang, matches.size());
+
+                if (open) {
+                    for (const auto &match : matches) {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Indent();
+                        if (ImGui::Hyperlink(hex::format("0x{:08X}", match.offset).c_str()))
+                            ImHexApi::HexEditor::setSelection(match.offset, match.size);
+                        ImGui::Unindent();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(match.encoding == hlp::StringLocator::Encoding::ASCII ? "ASCII" : "UTF-16LE");
+                    }
+
+                    ImGui::TreePop();
+                }
+                ImGui::PopID();
+            }
+
+            ImGui::EndTable();
+        }
+    }
+
+    void ViewMalcore::drawDiagnostics(const Analysis &analysis, std::chrono::duration<double> drawDuration) {
+        if (!ImGui::CollapsingHeader("mal.view.malcore.diagnostics"_lang))
+            return;
+
+        const auto &result  = analysis.runResult;
+        const auto &metrics = result.metrics;
+
+        if (ImGui::BeginTable("##diagnostics", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            auto drawRow = [](const char *name, const std::string &value) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(value.c_str());
+            };
+
+            switch (result.origin) {
+                using enum hlp::AnalysisRunner::Origin;
+
+                case Cache:  drawRow("mal.view.malcore.diagnostics.origin"_lang, "mal.view.malcore.diagnostics.origin.cache"_lang);  break;
+                case Lookup: drawRow("mal.view.malcore.diagnostics.origin"_lang, "mal.view.malcore.diagnostics.origin.lookup"_lang); break;
+                case Upload: drawRow("mal.view.malcore.diagnostics.origin"_lang, "mal.view.malcore.diagnostics.origin.upload"_lang); break;
+            }
+            if (result.shared)
+                drawRow("mal.view.malcore.diagnostics.shared"_lang, "mal.view.malcore.diagnostics.shared.text"_lang);
+
+            drawRow("mal.view.malcore.diagnostics.duration"_lang, hex::format("{:.3f}s", result.duration.count()));
+            drawRow("mal.view.malcore.diagnostics.first_result"_lang, hex::format("{:.3f}s", metrics.timeToFirstResult.count()));
+            for (u32 phase = 0; phase < u32(hlp::AnalysisMetrics::Phase::Count); phase++) {
+                const auto name = hlp::AnalysisMetrics::getPhaseName(hlp::AnalysisMetrics::Phase(phase));
+                drawRow(LangEntry(hex::format("mal.view.malcore.diagnostics.phase.{}", name)), hex::format("{:.3f}s", metrics.durations[phase].count()));
+            }
+            drawRow("mal.view.malcore.diagnostics.phase.draw"_lang, hex::format("{:.2f}ms", drawDuration.count() * 1000));
+
+            drawRow("mal.view.malcore.diagnostics.sample_size"_lang, hex::toByteString(metrics.sampleSize));
+            drawRow("mal.view.malcore.diagnostics.bytes_sent"_lang, hex::toByteString(metrics.bytesSent));
+            drawRow("mal.view.malcore.diagnostics.bytes_received"_lang, hex::toByteString(metrics.bytesReceived));
+            if (result.compressionRatio.has_value())
+                drawRow("mal.view.malcore.diagnostics.compression"_lang, hex::format("{:.2f}x, {:.2f}s", *result.compressionRatio, result.uploadTimeSaved.count()));
+            drawRow("mal.view.malcore.diagnostics.poll_count"_lang, hex::format("{}", metrics.pollCount));
+
+            drawRow("mal.view.malcore.diagnostics.status_size"_lang, hex::toByteString(metrics.statusSize));
+            drawRow("mal.view.malcore.diagnostics.signatures"_lang, hex::format("{}", metrics.signatureCount));
+            drawRow("mal.view.malcore.diagnostics.api_calls"_lang, hex::format("{}", metrics.apiCallCount));
+            drawRow("mal.view.malcore.diagnostics.pooled_strings"_lang, hex::format("{}", metrics.pooledStringCount));
+            if (const auto &pages = analysis.tracePages; pages != nullptr)
+                drawRow("mal.view.malcore.diagnostics.trace_pages"_lang, hex::format("{}, {} / {}, {}", pages->getPageCount(), hex::toByteString(pages->getStoredSize()), hex::toByteString(pages->getRawSize()), pages->getCachedPageCount()));
+            drawRow("mal.view.malcore.diagnostics.string_matches"_lang, hex::format("{}", metrics.stringMatchCount));
+            drawRow("mal.view.malcore.diagnostics.annotations"_lang, hex::format("{}", metrics.annotationCount));
+
+            const auto requests = hlp::RequestScheduler::getCounters();
+            drawRow("mal.view.malcore.diagnostics.requests"_lang, hex::format("{}, {}, {}", requests.queued, requests.retried, requests.throttled));
+
+            ImGui::EndTable();
+        }
+
+        if (ImGui::Button("mal.view.malcore.diagnostics.export"_lang)) {
+            auto json = metrics.toJson();
+            json["sha256"]   = crypt::encode16({ result.hash.begin(), result.hash.end() });
+            json["digest"]   = crypt::encode16({ result.digest.begin(), result.digest.end() });
+            json["origin"]   = result.origin == hlp::AnalysisRunner::Origin::Cache ? "cache" : result.origin == hlp::AnalysisRunner::Origin::Lookup ? "lookup" : "upload";
+            json["shared"]   = result.shared;
+            json["duration"] = result.duration.count();
+            json["durations"]["draw"] = drawDuration.count();
+            if (result.compressionRatio.has_value()) {
+                json["transfer"]["compression_ratio"] = *result.compressionRatio;
+                json["transfer"]["upload_time_saved"] = result.uploadTimeSaved.count();
+            }
+
+            fs::openFileBrowser(fs::DialogMode::Save, { { "JSON", "json" } }, [json = std::move(json)](const std::fs::path &path) {
+                wolv::io::File file(path, wolv::io::File::Mode::Create);
+                if (!file.isValid()) {
+                    log::error("Failed to export Malcore diagnostics to '{}'", wolv::util::toUTF8String(path));
+                    return;
+                }
+
+                file.writeString(json.dump(4));
+            });
+        }
+
+        ImGui::NewLine();
+    }
+
+    void ViewMalcore::drawComparison(prv::Provider *provider, const std::shared_ptr<const Analysis> &analysis) {
+        if (!ImGui::CollapsingHeader("mal.view.malcore.compare"_lang))
+            return;
+
+        auto &comparison = this->m_comparisons.get(provider);
+        if (comparison.other != nullptr && !isProviderOpen(comparison.other)) {
+            stopTraceDiff(comparison);
+            comparison = { };
+        }
+
+        // Only providers that have an analysis of their own can be compared against
+        const auto preview = comparison.other != nullptr ? comparison.other->getName() : std::string("mal.view.malcore.compare.select"_lang);
+        if (ImGui::BeginCombo("mal.view.malcore.compare.with"_lang, preview.c_str())) {
+            for (const auto other : ImHexApi::Provider::getProviders()) {
+                if (other == provider || this->m_analysis.get(other) == nullptr)
+                    continue;
+
+                ImGui::PushID(other);
+                if (ImGui::Selectable(other->getName().c_str(), other == comparison.other)) {
+                    stopTraceDiff(comparison);
+                    comparison = { };
+                    comparison.other = other;
+                }
+                ImGui::PopID();
+            }
+
+            ImGui::EndCombo();
+        }
+
+        if (comparison.other == nullptr)
+            return;
+
+        const auto other = this->m_analysis.get(comparison.other);
+        if (other == nullptr)
+            return;
+
+        // Set differences are cheap, so they're simply redone whenever either side got a new snapshot
+        if (comparison.left != analysis || comparison.right != other) {
+            auto getTitles = [](const Analysis &analysis) {
+                std::vector<std::string> titles;
+                if (analysis.threatScore.has_value()) {
+                    for (const auto &signature : analysis.threatScore->signatures)
+                        titles.push_back(signature.title);
+                }
+
+                return titles;
+            };
+
+            comparison.left       = analysis;
+            comparison.right      = other;
+            comparison.signatures = hlp::AnalysisDiff::compareSets(getTitles(*analysis), getTitles(*other));
+            comparison.strings    = hlp::AnalysisDiff::compareSets(analysis->interestingStrings.value_or(std::vector<std::string>()), other->interestingStrings.value_or(std::vector<std::string>()));
+            comparison.leftTrace  = 0;
+            comparison.rightTrace = 0;
+            comparison.traceDiff.reset();
+            stopTraceDiff(comparison);
+        }
+
+        auto getPacker = [](const Analysis &analysis) -> std::string {
+            if (!analysis.packerInformation.has_value())
+                return "-";
+
+            return hex::format("{} ({}%)", analysis.packerInformation->name, analysis.packerInformation->confidence);
+        };
+
+        ImGui::NewLine();
+        ImGui::TextFormatted("mal.view.malcore.compare.packer"_lang, getPacker(*analysis), getPacker(*other));
+
+        drawSetDiff("mal.view.malcore.compare.signatures"_lang, comparison.signatures);
+        drawSetDiff("mal.view.malcore.compare.strings"_lang, comparison.strings);
+
+        if (!analysis->traceHeaders.empty() && !other->traceHeaders.empty()) {
+            auto selectTrace = [&comparison](const char *label, const std::vector<hlp::ResultArchive::TraceHeader> &traces, u32 &selected) {
+                if (ImGui::BeginCombo(label, traces[selected].hash.c_str())) {
+                    for (u32 i = 0; i < traces.size(); i++) {
+                        ImGui::PushID(i);
+                        if (ImGui::Selectable(traces[i].hash.c_str(), i == selected) && i != selected) {
+                            selected = i;
+                            comparison.traceDiff.reset();
+                            stopTraceDiff(comparison);
+                        }
+                        ImGui::PopID();
+                    }
+
+                    ImGui::EndCombo();
+                }
+            };
+
+            ImGui::NewLine();
+            selectTrace("mal.view.malcore.compare.left_trace"_lang, analysis->traceHeaders, comparison.leftTrace);
+            selectTrace("mal.view.malcore.compare.right_trace"_lang, other->traceHeaders, comparison.rightTrace);
+
+            if (comparison.traceDiff == nullptr) {
+                this->startTraceDiffTask(provider, comparison);
+                ImGui::TextSpinner("mal.view.malcore.compare.diffing"_lang);
+            } else {
+                drawTraceDiff(comparison);
+            }
+        }
+
+        ImGui::NewLine();
+    }
+
+    void ViewMalcore::drawSetDiff(const char *name, const hlp::AnalysisDiff::SetDiff &diff) {
+        const auto label = hex::format("{}: {}", name, hex::format("mal.view.malcore.compare.set_summary"_lang, diff.common, diff.removed.size(), diff.added.size()));
+        if (!ImGui::TreeNodeEx(label.c_str(), diff.removed.empty() && diff.added.empty() ? ImGuiTreeNodeFlags_Leaf : ImGuiTreeNodeFlags_None))
+            return;
+
+        if (ImGui::BeginTable(name, 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, scaled(ImVec2(0, 200)))) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("mal.view.malcore.compare.only_left"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.compare.only_right"_lang);
+            ImGui::TableHeadersRow();
+
+            ImGuiListClipper clipper;
+            clipper.Begin(std::max(diff.removed.size(), diff.added.size()));
+
+            while (clipper.Step()) {
+                for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    if (size_t(i) < diff.removed.size())
+                        ImGui::TextFormattedColored(ImColor(0xFF7070E0), "{}", diff.removed[i]);
+                    ImGui::TableNextColumn();
+                    if (size_t(i) < diff.added.size())
+                        ImGui::TextFormattedColored(ImColor(0xFF9BC64D), "{}", diff.added[i]);
+                }
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::TreePop();
+    }
+
+    void ViewMalcore::drawTraceDiff(const Comparison &comparison) {
+        using enum hlp::AnalysisDiff::RowType;
+
+        const auto &diff  = *comparison.traceDiff;
+        const auto &left  = comparison.leftSource;
+        const auto &right = comparison.rightSource;
+
+        ImGui::TextFormatted("mal.view.malcore.compare.trace_summary"_lang, diff.getCount(Equal), diff.getCount(Changed), diff.getCount(Replaced), diff.getCount(Removed), diff.getCount(Inserted));
+
+        if (ImGui::BeginTable("##trace_diff", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit, scaled(ImVec2(0, 400)))) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.index"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.pc"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.function"_lang, ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.index"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.pc"_lang);
+            ImGui::TableSetupColumn("mal.view.malcore.dynamic_analysis.function"_lang, ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            auto drawSide = [](u32 index, const TraceRef &source, std::optional<color_t> color, int firstColumn) {
+                if (color.has_value()) {
+                    for (int column = firstColumn; column < firstColumn + 3; column++)
+                        ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, *color, column);
+                }
+
+                ImGui::TableNextColumn();
+                if (index == hlp::AnalysisDiff::NoCall || source.trace == nullptr) {
+                    ImGui::TableNextColumn();
+                    ImGui::TableNextColumn();
+                    return;
+                }
+
+                ImGui::TextFormatted("{}", index);
+                drawApiCall(source.trace->apis[index], *source.trace, *source.strings);
+            };
+
+            // Traces can contain hundreds of thousands of calls, only lay out the rows that are actually visible
+            ImGuiListClipper clipper;
+            clipper.Begin(diff.rows.size());
+
+            while (clipper.Step()) {
+                for (auto i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                    const auto &row = diff.rows[i];
+
+                    std::optional<color_t> leftColor, rightColor;
+                    switch (row.type) {
+                        case Equal:                                                     break;
+                        case Changed:  leftColor = rightColor = 0x4050C0E0;             break;
+                        case Replaced: leftColor = 0x407070E0; rightColor = 0x409BC64D; break;
+                        case Removed:  leftColor = 0x407070E0;                          break;
+                        case Inserted: rightColor = 0x409BC64D;                         break;
+                    }
+
+                    ImGui::TableNextRow();
+                    drawSide(row.left, left, leftColor, 0);
+                    drawSide(row.right, right, rightColor, 3);
+                }
+            }
+
+            ImGui::EndTable();
+        }
+    }
+
+    void ViewMalcore::drawAlwaysVisible() {
+        const auto windowWidth = 450_scaled;
+        ImGui::SetNextWindowSize(ImVec2(windowWidth, 0), ImGuiCond_Always);
+        if (ImGui::BeginPopupModal("mal.malcore.popup.api_key"_lang, nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+            if (!hlp::MalcoreApi::hasApiKey()) {
+                const auto imageSize = scaled(s_bannerTexture.getSize() * 0.35F);
+
+                ImGui::SetCursorPosX((windowWidth - imageSize.x) / 2.0F);
+                ImGui::Image(s_bannerTexture, imageSize);
+
+                ImGui::NewLine();
+
+                ImGui::TextFormattedWrapped("{}", "mal.malcore.popup.api_key.description"_lang);
+                ImGui::NewLine();
+                ImGui::TextFormattedWrapped("{}", "mal.malcore.popup.api_key.register"_lang);
+
+                if (ImGui::Hyperlink("https://link.malcore.io/imhex/register"))
+                    hex::openWebpage("https://link.malcore.io/imhex/register");
+
+                ImGui::NewLine();
+
+                ImGui::PushItemWidth(windowWidth - ImGui::GetStyle().FramePadding.x * 4.0F);
+                if (ImGui::InputTextIcon("##api_key", ICON_VS_SYMBOL_KEY, this->m_apiKey, ImGuiInputTextFlags_EnterReturnsTrue)) {
+                    setApiKey(this->m_apiKey);
+                    this->startAnalysisTask();
+
+                    ImGui::CloseCurrentPopup();
+                }
+                ImGui::PopItemWidth();
+
+                View::confirmButtons("hex.builtin.common.okay"_lang, "hex.builtin.common.cancel"_lang,
+                    [this] {
+                        setApiKey(this->m_apiKey);
+                        this->startAnalysisTask();
+                        ImGui::CloseCurrentPopup();
+                    },
+                    [] {
+                        ImGui::CloseCurrentPopup();
+                    }
+                );
+            } else {
+                ImGui::TextFormattedWrapped("{}", "mal.malcore.popup.upload.description"_lang);
+
+                ImGui::NewLine();
+
+                View::confirmButtons("hex.builtin.common.okay"_lang, "hex.builtin.common.cancel"_lang,
+                    [this] {
+                        this->startAnalysisTask();
+                        ImGui::CloseCurrentPopup();
+                    },
+                    [] {
+                        ImGui::CloseCurrentPopup();
+                    }
+                );
+            }
+
+            ImGui::EndPopup();
+        }
+    }
+
+    hlp::AnnotationIndex ViewMalcore::buildAnnotations(prv::Provider *provider, const Analysis &analysis, u32 *annotatedPageCount) {
+        hlp::AnnotationIndex annotations;
+
+        // Call sites are collected while the pages are built, so none of the pages get decoded here.
+        // Pages that are still on the service aren't fetched just to annotate them
+        if (analysis.tracePages != nullptr) {
+            const auto addressMap = hlp::AddressMap::fromProvider(provider);
+
+            const auto callSites = analysis.tracePages->getCallSites(annotatedPageCount);
+            for (const auto &site : callSites.sites) {
+                const auto address = addressMap.toAddress(site.pc);
+                if (!address.has_value())
+                    continue;
+
+                annotations.add({ *address, 1 }, 0x609BC64D, hex::format("mal.view.malcore.annotation.api_call"_lang, callSites.names[site.name], site.pc, site.count));
+            }
+        }
+
+        if (analysis.interestingStrings.has_value()) {
+            for (u32 i = 0; i < analysis.stringMatches.size(); i++) {
+                const auto &string = (*analysis.interestingStrings)[i];
+
+                for (const auto &match : analysis.stringMatches[i])
+                    annotations.add({ match.offset, match.size }, 0x607070E0, hex::format("mal.view.malcore.annotation.string"_lang, string));
+            }
+        }
+
+        annotations.build();
+
+        return annotations;
+    }
+
+    std::optional<ViewMalcore::TraceRef> ViewMalcore::loadTrace(const std::shared_ptr<const Analysis> &analysis, u32 index) {
+        if (analysis->tracePages != nullptr && index < analysis->traceHeaders.size()) {
+            const auto pageIndex = analysis->tracePages->getPageOf(index);
+            const auto trace     = index - analysis->tracePages->getFirstTrace(pageIndex);
+
+            // Pages that are shown already are reused. All others are decoded without the indices the diff doesn't need,
+            // and they don't push the shown ones out of the decoded pages
+            auto page = analysis->tracePages->findPage(pageIndex);
+            if (page == nullptr) {
+                auto decoded = analysis->tracePages->decodePage(pageIndex);
+                if (decoded.has_value())
+                    page = std::make_shared<const hlp::ReportPages::Page>(std::move(*decoded));
+            }
+
+            if (page == nullptr || trace >= page->traces.size())
+                return std::nullopt;
+
+            return TraceRef { page, &page->traces[trace], &page->strings };
+        }
+
+        return std::nullopt;
+    }
+
+    void ViewMalcore::startTriageTask(prv::Provider *provider, std::shared_ptr<std::promise<std::optional<hlp::SampleSource::Hash>>> sha256) {
+        this->m_triage.get(provider).reset();
+        const auto generation = ++this->m_triageGeneration.get(provider);
+
+        TaskManager::createTask("mal.malcore.triage"_lang, 0, [this, provider, generation, sha256 = std::move(sha256)](auto &task) {
+            // Whoever waits for the hash calculates it on their own if the triage doesn't get to it
+            std::optional<hlp::SampleSource::Hash> hash;
+            ON_SCOPE_EXIT {
+                if (sha256 != nullptr)
+                    sha256->set_value(hash);
+            };
+
+            // The interrupt callback can be called after this task returned, so it shares ownership of the stop source
+            auto stopSource = std::make_shared<std::stop_source>();
+            task.setInterruptCallback([stopSource] { stopSource->request_stop(); });
+
+            auto triage = hlp::Triage::run(hlp::SampleSource::fromProvider(provider), stopSource->get_token());
+            if (!triage.has_value())
+                return;
+
+            log::info("Local triage of '{}' finished in {:.3f}s", provider->getName(), triage->duration.count());
+
+            if (const auto bytes = crypt::decode16(triage->sha256); bytes.size() == std::tuple_size_v<hlp::SampleSource::Hash>) {
+                hash.emplace();
+                std::copy(bytes.begin(), bytes.end(), hash->begin());
+            }
+
+            // Offsets are relative to the start of the sample, turn them into provider addresses
+            for (auto &string : triage->strings)
+                string.offset += provider->getBaseAddress();
+
+            TaskManager::doLater([this, provider, generation, triage = std::make_shared<const hlp::Triage::Result>(std::move(*triage))] {
+                if (!isProviderOpen(provider) || this->m_triageGeneration.get(provider) != generation)
+                    return;
+
+                this->m_triage.get(provider) = triage;
+                this->getWindowOpenState() = true;
+            });
+        });
+    }
+
+    void ViewMalcore::startAnalysisTask() {
+        auto provider = ImHexApi::Provider::get();
+        this->m_analysis.get(provider).reset();
+
+        // Runs that were started earlier may still finish after this one, their results are dropped
+        const auto generation = ++this->m_analysisGeneration.get(provider);
+
+        // The local pre-triage doesn't need the network, so there's something to show while the remote analysis is pending.
+        // It calculates the SHA-256 of the whole provider anyway, which the analysis reuses instead of hashing everything again
+        auto sha256 = std::make_shared<std::promise<std::optional<hlp::SampleSource::Hash>>>();
+        this->startTriageTask(provider, sha256);
+
+        TaskManager::createTask("mal.malcore.analyzing"_lang, 0, [this, provider, generation, triageHash = sha256->get_future().share()](auto &task) {
+            auto stopSource = std::make_shared<std::stop_source>();
+            task.setInterruptCallback([stopSource] { stopSource->request_stop(); });
+
+            const auto startTime = std::chrono::steady_clock::now();
+
+            auto sample = hlp::ProviderHashes::createSample(provider);
+            sample.setHasher([triageHash, stopSource, size = sample.getSize()](u64 limit) -> std::optional<hlp::SampleSource::Hash> {
+                // The triage always hashes everything, which is only the uploaded data if nothing gets cut off
+                if (size > limit)
+                    return std::nullopt;
+
+                // Cancelling the analysis must not wait for the triage to finish first
+                while (triageHash.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+                    if (stopSource->stop_requested())
+                        return std::nullopt;
+                }
+
+                // Broken if the triage task was dropped without ever running
+                try {
+                    return triageHash.get();
+                } catch (const std::future_error &) {
+                    return std::nullopt;
+                }
+            });
+
+            auto result = hlp::AnalysisRunner::run(sample, stopSource->get_token());
+
+            using enum hlp::AnalysisRunner::Error;
+            switch (result.error) {
+                case None:
+                    break;
+                case Cancelled:
+                    return;
+                case UploadFailed:
+                    PopupError::open("mal.malcore.popup.error.upload_failed"_lang);
+                    return;
+                case StatusFailed:
+                    PopupError::open("mal.malcore.popup.error.analysis_failed"_lang);
+                    return;
+                case TimedOut:
+                    PopupError::open("mal.malcore.popup.error.analysis_timeout"_lang);
+                    return;
+            }
+
+            using Phase = hlp::AnalysisMetrics::Phase;
+            auto &metrics = result.metrics;
+
+            // Only the summary of the response is parsed right away, its traces are split into pages that are decoded on demand
+            std::shared_ptr<const hlp::ReportPages> pages;
+            auto parsed = [&]() -> std::optional<hlp::MalcoreApi::AnalysisResult> {
+                auto timer = metrics.measure(Phase::Parse);
+
+                auto split = hlp::ReportPages::split(*result.status);
+                if (!split.has_value())
+                    return std::nullopt;
+
+                pages = std::make_shared<const hlp::ReportPages>(std::move(*split));
+
+                return hlp::StatusParser::parse(pages->getSummary());
+            }();
+
+            if (!parsed.has_value()) {
+                PopupError::open("mal.malcore.popup.error.analysis_failed"_lang);
+                return;
+            }
+
+            result.status.reset();
+
+            auto summary = std::make_shared<Analysis>(std::move(*parsed));
+            if (pages->hasTraces()) {
+                summary->tracePages   = pages;
+                summary->traceHeaders = pages->getTraceHeaders();
+            }
+
+            if (summary->threatScore.has_value())
+                metrics.signatureCount = summary->threatScore->signatures.size();
+            for (const auto &header : summary->traceHeaders)
+                metrics.apiCallCount += header.apiCount;
+            metrics.storedTraceSize   = pages->getStoredSize();
+            metrics.timeToFirstResult = std::chrono::steady_clock::now() - startTime;
+
+            summary->runResult = result;
+
+            // Show the threat score and the trace headers right away, string matches and annotations follow once they're done
+            TaskManager::doLater([this, provider, generation, summary] {
+                if (!isProviderOpen(provider) || this->m_analysisGeneration.get(provider) != generation)
+                    return;
+
+                this->m_analysis.get(provider) = summary;
+                this->m_traceFilters.get(provider).clear();
+                this->getWindowOpenState() = true;
+            });
+
+            auto analysis = std::make_shared<Analysis>(*summary);
+            if (analysis->interestingStrings.has_value()) {
+                auto timer = metrics.measure(Phase::LocateStrings);
+
+                analysis->stringMatches = hlp::StringLocator(*analysis->interestingStrings).locate(sample, stopSource->get_token());
+                if (stopSource->stop_requested())
+                    return;
+
+                // Matches are relative to the start of the sample, turn them into provider addresses
+                for (auto &matches : analysis->stringMatches) {
+                    for (auto &match : matches)
+                        match.offset += provider->getBaseAddress();
+
+                    metrics.stringMatchCount += matches.size();
+                }
+            }
+
+            {
+                auto timer = metrics.measure(Phase::Annotate);
+                analysis->annotations = buildAnnotations(provider, *analysis, &analysis->annotatedPageCount);
+            }
+
+            if (stopSource->stop_requested())
+                return;
+
+            metrics.pooledStringCount  = analysis->strings.size();
+            metrics.annotationCount    = analysis->annotations.size();
+
+            analysis->runResult = std::move(result);
+
+            TaskManager::doLater([this, provider, generation, summary = std::move(summary), analysis = std::move(analysis)] {
+                // The provider might have been closed or analyzed again while the analysis was running
+                if (!isProviderOpen(provider) || this->m_analysisGeneration.get(provider) != generation)
+                    return;
+
+                // The summary might have been replaced in the meantime, unless it only got annotated again for pages that were fetched.
+                // The traces are the same ones, so open traces and their filters stay as they are
+                auto &current = this->m_analysis.get(provider);
+                if (current != summary && (current == nullptr || summary->tracePages == nullptr || current->tracePages != summary->tracePages))
+                    return;
+
+                const bool missesPages = current->annotatedPageCount > analysis->annotatedPageCount;
+                current = analysis;
+
+                if (missesPages)
+                    this->startAnnotationTask(provider, analysis);
+            });
+        });
+    }
+
+    void ViewMalcore::startPageLoadTask(prv::Provider *provider, std::shared_ptr<const Analysis> analysis, u32 page) {
+        if (!analysis->tracePages->beginLoading(page))
+            return;
+
+        TaskManager::createTask("mal.malcore.loading_traces"_lang, 0, [this, provider, analysis = std::move(analysis), page](auto &) {
+            const auto &pages = analysis->tracePages;
+
+            const bool stored = pages->isPageStored(page);
+            pages->loadPage(page);
+
+            // Pages fetched from the service bring call sites the annotations don't have yet
+            if (!stored && pages->isPageStored(page))
+                this->startAnnotationTask(provider, analysis);
+        });
+    }
+
+    void ViewMalcore::startAnnotationTask(prv::Provider *provider, std::shared_ptr<const Analysis> analysis) {
+        TaskManager::createTask("mal.malcore.loading_traces"_lang, 0, [this, provider, analysis = std::move(analysis)](auto &) {
+            const auto startTime = std::chrono::steady_clock::now();
+
+            // Only merges the call sites that were collected along with the pages, none of the pages get decoded
+            auto annotated = std::make_shared<Analysis>(*analysis);
+            annotated->annotations = buildAnnotations(provider, *annotated, &annotated->annotatedPageCount);
+
+            log::debug("Annotated {} of {} pages of Malcore traces in {:.3f}s", annotated->annotatedPageCount, annotated->tracePages->getPageCount(), std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+
+            TaskManager::doLater([this, provider, analysis, annotated = std::move(annotated)] {
+                if (!isProviderOpen(provider))
+                    return;
+
+                // A new analysis might have replaced this one in the meantime
+                auto &current = this->m_analysis.get(provider);
+                if (current == nullptr || current->tracePages != analysis->tracePages)
+                    return;
+
+                // So might another pass or the finished analysis with the same traces. Those are annotated again if they miss any pages
+                if (current != analysis) {
+                    if (current->annotatedPageCount < annotated->annotatedPageCount)
+                        this->startAnnotationTask(provider, current);
+                    return;
+                }
+
+                current = annotated;
+            });
+        });
+    }
+
+    void ViewMalcore::stopTraceDiff(Comparison &comparison) {
+        // The stopped task winds down on its own, a new diff can start right away instead of waiting for it
+        if (comparison.diffing != nullptr)
+            comparison.diffing->request_stop();
+
+        comparison.diffing.reset();
+    }
+
+    void ViewMalcore::startTraceDiffTask(prv::Provider *provider, Comparison &comparison) {
+        if (comparison.diffing != nullptr)
+            return;
+
+        auto stopSource = std::make_shared<std::stop_source>();
+        comparison.diffing = stopSource;
+
+        TaskManager::createTask("mal.malcore.comparing"_lang, 0, [this, provider, stopSource, left = comparison.left, right = comparison.right, leftTrace = comparison.leftTrace, rightTrace = comparison.rightTrace](auto &task) {
+            task.setInterruptCallback([stopSource] { stopSource->request_stop(); });
+
+            const auto startTime = std::chrono::steady_clock::now();
+
+            // Paged traces get decoded here if they aren't already. Traces that can't be decoded are compared as empty ones
+            auto leftSource  = loadTrace(left, leftTrace).value_or(TraceRef());
+            auto rightSource = loadTrace(right, rightTrace).value_or(TraceRef());
+
+            std::optional<hlp::AnalysisDiff::TraceDiff> diff;
+            if (leftSource.trace != nullptr && rightSource.trace != nullptr)
+                diff = hlp::AnalysisDiff::compareTraces(*leftSource.trace, *leftSource.strings, *rightSource.trace, *rightSource.strings, stopSource->get_token());
+            else if (!stopSource->stop_requested())
+                diff = hlp::AnalysisDiff::TraceDiff();
+
+            if (diff.has_value())
+                log::debug("Aligned {} rows of Malcore traces in {:.3f}s", diff->rows.size(), std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+
+            TaskManager::doLater([this, provider, stopSource, left, right, leftTrace, rightTrace, leftSource = std::move(leftSource), rightSource = std::move(rightSource), diff = diff.has_value() ? std::make_shared<const hlp::AnalysisDiff::TraceDiff>(std::move(*diff)) : nullptr] {
+                if (!isProviderOpen(provider))
+                    return;
+
+                // Diffs that got stopped were replaced already, the one running now isn't theirs to clear
+                auto &comparison = this->m_comparisons.get(provider);
+                if (comparison.diffing != stopSource)
+                    return;
+
+                comparison.diffing.reset();
+
+                // The selection might have changed while the traces were being aligned
+                if (comparison.left != left || comparison.right != right || comparison.leftTrace != leftTrace || comparison.rightTrace != rightTrace)
+                    return;
+
+                comparison.traceDiff   = diff;
+                comparison.leftSource  = leftSource;
+                comparison.rightSource = rightSource;
+            });
+        });
+    }
+
+    void ViewMalcore::registerProjectHandler() {
+        // Analyses are stored per provider as a small summary and a separate blob of compressed trace pages. Loading only
+        // decodes the summary, the pages are restored as they are and decoded one at a time once they're looked at, so large
+        // traces don't slow down opening or saving projects
+        ProjectFile::registerPerProviderHandler({
+            .basePath = "malcore",
+            .required = false,
+            .load = [this](prv::Provider *provider, const std::fs::path &basePath, Tar &tar) -> bool {
+                this->m_analysis.get(provider).reset();
+                this->m_traceFilters.get(provider).clear();
+
+                // Analyses that are still running were started on whatever was open before the project
+                this->m_analysisGeneration.get(provider) += 1;
+
+                const auto summaryPath = basePath / "analysis.bin";
+                if (!tar.contains(summaryPath))
+                    return true;
+
+                auto summary = hlp::ResultArchive::decodeSummary(tar.readVector(summaryPath));
+                if (!summary.has_value()) {
+                    log::warn("Ignoring invalid Malcore analysis stored in project");
+                    return true;
+                }
+
+                auto analysis = std::make_shared<Analysis>(std::move(summary->result));
+                analysis->restored = true;
+
+                // Matches are stored relative to the start of the sample, turn them into provider addresses
+                analysis->stringMatches = std::move(summary->stringMatches);
+                for (auto &matches : analysis->stringMatches) {
+                    for (auto &match : matches)
+                        match.offset += provider->getBaseAddress();
+                }
+
+                // String matches are annotated right away, the call sites stored with the traces follow on a task
+                analysis->annotations = buildAnnotations(provider, *analysis);
+
+                const auto tracesPath = basePath / "traces.bin";
+                if (!summary->traces.empty() && tar.contains(tracesPath)) {
+                    // Broken traces are dropped so the rest of the restored analysis stays usable
+                    if (auto pages = hlp::ResultArchive::decodeTraces(tar.readVector(tracesPath), std::move(summary->traces)); pages.has_value()) {
+                        analysis->tracePages   = std::make_shared<const hlp::ReportPages>(std::move(*pages));
+                        analysis->traceHeaders = analysis->tracePages->getTraceHeaders();
+                    } else {
+                        log::error("Failed to restore Malcore dynamic analysis traces stored in project");
+                    }
+                }
+
+                this->m_analysis.get(provider) = analysis;
+
+                if (analysis->tracePages != nullptr)
+                    this->startAnnotationTask(provider, std::move(analysis));
+
+                return true;
+            },
+            .store = [this](prv::Provider *provider, const std::fs::path &basePath, Tar &tar) -> bool {
+                const auto analysis = this->m_analysis.get(provider);
+                if (analysis == nullptr)
+                    return true;
+
+                auto stringMatches = analysis->stringMatches;
+                for (auto &matches : stringMatches) {
+                    for (auto &match : matches)
+                        match.offset -= provider->getBaseAddress();
+                }
+
+                // The compressed pages are written as they are, nothing gets decoded to save a project
+                if (const auto &pages = analysis->tracePages; pages != nullptr && pages->hasTraces()) {
+                    tar.writeVector(basePath / "analysis.bin", hlp::ResultArchive::encodeSummary(*analysis, stringMatches, analysis->traceHeaders));
+                    tar.writeVector(basePath / "traces.bin", hlp::ResultArchive::encodeTraces(*pages));
+                } else {
+                    tar.writeVector(basePath / "analysis.bin", hlp::ResultArchive::encodeSummary(*analysis, stringMatches, { }));
+                }
+
+                return true;
+            }
+        });
+    }
+
+    void ViewMalcore::setApiKey(const std::string &key) {
+        hlp::MalcoreApi::setApiKey(key);
+        ContentRegistry::Settings::write("mal.malcore.setting.general", "hex.malcore.setting.general.api_key", key);
+    }
+
+}